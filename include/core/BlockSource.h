@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/ISynthesisNode.h"
+
+namespace vv {
+
+// Slices a whole-utterance packet into consecutive blocks of framesPerBlock analysis
+// frames for ComputationGraph::runStreaming().
+// The frame count comes from the "f0" feature when present, else from the sample count
+// and hopSamples. Samples are sliced by hopSamples per frame; a feature whose length is
+// a whole multiple of the frame count is treated as a row-major [frames x width] matrix
+// and sliced by rows, as is any matrix with one row per frame; other features, matrices
+// and all scalars are passed through unchanged.
+class PacketBlockSource {
+public:
+    PacketBlockSource(std::shared_ptr<const DataPacket> packet, size_t framesPerBlock, size_t hopSamples)
+        : packet_(std::move(packet)),
+          framesPerBlock_(std::max<size_t>(1, framesPerBlock)),
+          hop_(std::max<size_t>(1, hopSamples))
+    {
+        if (!packet_) return;
+        const size_t ch = std::max<size_t>(1, packet_->channels());
+        if (const auto* f0 = packet_->getFeature(FeatureKey::F0); f0 && !f0->empty()) totalFrames_ = f0->size();
+        else totalFrames_ = (packet_->samples().size() / ch + hop_ - 1) / hop_;
+    }
+
+    size_t totalFrames() const { return totalFrames_; }
+    size_t blockCount() const { return (totalFrames_ + framesPerBlock_ - 1) / framesPerBlock_; }
+
+    // Produce the next block; returns false once the packet is exhausted.
+    bool next(std::shared_ptr<const DataPacket>& block, StreamBlock& info) {
+        if (!packet_ || nextFrame_ >= totalFrames_) return false;
+        const size_t first = nextFrame_;
+        const size_t frames = std::min(framesPerBlock_, totalFrames_ - first);
+        const size_t ch = std::max<size_t>(1, packet_->channels());
+
+        const auto& x = packet_->samples();
+        const size_t s0 = std::min(x.size(), first * hop_ * ch);
+        const size_t s1 = (first + frames == totalFrames_) ? x.size() : std::min(x.size(), (first + frames) * hop_ * ch);
+        auto out = std::make_shared<DataPacket>(std::vector<float>(x.begin() + s0, x.begin() + s1),
+                                                packet_->sampleRate(), packet_->channels(), packet_->bitDepth(),
+                                                packet_->timestamp());
+        packet_->forEachFeature([&](const std::string& key, const std::vector<float>& v) {
+            if (totalFrames_ > 0 && !v.empty() && v.size() % totalFrames_ == 0) {
+                const size_t w = v.size() / totalFrames_;
+                out->setFeature(key, std::vector<float>(v.begin() + first * w, v.begin() + (first + frames) * w));
+            } else {
+                out->setFeature(key, packet_->sharedFeature(key)); // shared, not copied
+            }
+        });
+        packet_->forEachMatrix([&](const std::string& key, const FeatureMatrix& m) {
+            if (m.rows() == totalFrames_) out->setMatrix(key, m.sliceRows(first, frames));
+            else out->setMatrix(key, packet_->sharedMatrix(key));
+        });
+        packet_->forEachScalar([&](const std::string& key, double v) { out->setScalar(key, v); });
+
+        info.index = blockIndex_++;
+        info.firstFrame = first;
+        info.frames = frames;
+        info.last = first + frames >= totalFrames_;
+        nextFrame_ = first + frames;
+        block = std::move(out);
+        return true;
+    }
+
+private:
+    std::shared_ptr<const DataPacket> packet_;
+    size_t framesPerBlock_;
+    size_t hop_;
+    size_t totalFrames_{0};
+    size_t nextFrame_{0};
+    size_t blockIndex_{0};
+};
+
+} // namespace vv
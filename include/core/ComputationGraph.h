@@ -1,19 +1,42 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
-#include <future>
 #include <thread>
 
+#include "core/ExecutionPlan.h"
+#include "core/GraphTrace.h"
+#include "core/NodeResultCache.h"
 #include "core/ISynthesisNode.h"
+#include "core/ThreadPool.h"
+#include "utils/Hash.h"
 
 namespace vv {
 
+// Options for ComputationGraph::runStreaming().
+struct StreamOptions {
+    size_t maxInFlight{4};                     // pipeline depth in blocks
+    unsigned maxThreads{std::thread::hardware_concurrency()};
+    uint32_t outputNode{ExecutionPlan::npos};  // default: last sink in topological order
+};
+
+// Options for ComputationGraph::executeBatch().
+struct BatchOptions {
+    size_t maxInFlight{std::max(1u, std::thread::hardware_concurrency())}; // packets in flight
+    unsigned maxThreads{std::thread::hardware_concurrency()};
+    uint32_t outputNode{ExecutionPlan::npos};  // default: last sink in topological order
+};
+
 class ComputationGraph {
 public:
     using NodePtr = std::shared_ptr<ISynthesisNode>;
@@ -68,63 +91,483 @@ public:
 
     const std::unordered_map<std::string, NodePtr>& nodes() const { return nodes_; }
 
-    // Minimal parallel execute: runs initialize() then process() for each node when deps are ready.
+    // Share a worker pool between graphs (or with other subsystems). When unset, the graph
+    // lazily creates its own persistent pool sized by execute()'s maxThreads.
+    void setThreadPool(std::shared_ptr<ThreadPool> pool) {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        pool_ = std::move(pool);
+        ownsPool_ = false;
+    }
+
+    // Attach per-node instrumentation (see GraphTracer). Near-free while the tracer is
+    // disabled or absent; must not be changed while a run is in progress.
+    void setTracer(std::shared_ptr<GraphTracer> tracer) { tracer_ = std::move(tracer); }
+    const std::shared_ptr<GraphTracer>& tracer() const { return tracer_; }
+
+    // Memoize node outputs across runs (see NodeResultCache). Only nodes whose
+    // parameterHash() returns true are cached; on a re-run such a node is skipped when
+    // its parameters and input are unchanged. Applies to run() and execute().
+    void setResultCache(std::shared_ptr<NodeResultCache> cache) { cache_ = std::move(cache); }
+    const std::shared_ptr<NodeResultCache>& resultCache() const { return cache_; }
+
+    // Freeze the current graph into an immutable plan (dense indices, CSR edges).
+    // Returns false on cycle. Compile once and run() the plan many times.
+    bool compile(ExecutionPlan& plan) const {
+        plan = ExecutionPlan{};
+        auto order = topologicalOrder();
+        if (order.empty() && !nodes_.empty()) return false; // cycle
+        const size_t n = order.size();
+        std::unordered_map<std::string, uint32_t> index;
+        index.reserve(n);
+        for (size_t i = 0; i < n; ++i) index[order[i]] = static_cast<uint32_t>(i);
+
+        std::vector<std::vector<uint32_t>> preds(n), succs(n);
+        for (size_t i = 0; i < n; ++i) {
+            auto ait = adj_.find(order[i]);
+            if (ait == adj_.end()) continue;
+            for (const auto& to : ait->second) {
+                uint32_t j = index.at(to);
+                succs[i].push_back(j);
+                preds[j].push_back(static_cast<uint32_t>(i));
+            }
+        }
+        plan.nodes_.reserve(n);
+        plan.ids_ = std::move(order);
+        for (size_t i = 0; i < n; ++i) {
+            plan.nodes_.push_back(nodes_.at(plan.ids_[i]));
+            plan.predIndex_.insert(plan.predIndex_.end(), preds[i].begin(), preds[i].end());
+            plan.predOffsets_.push_back(static_cast<uint32_t>(plan.predIndex_.size()));
+            plan.succIndex_.insert(plan.succIndex_.end(), succs[i].begin(), succs[i].end());
+            plan.succOffsets_.push_back(static_cast<uint32_t>(plan.succIndex_.size()));
+            if (preds[i].empty()) plan.sources_.push_back(static_cast<uint32_t>(i));
+            if (succs[i].empty()) plan.sinks_.push_back(static_cast<uint32_t>(i));
+        }
+        return true;
+    }
+
+    // Run a compiled plan. Results land in state's per-node output slots.
+    // A node is released only once all of its predecessors have produced output; each
+    // node runs initialize() then process(). Independent branches run concurrently on the
+    // graph's persistent work-stealing pool. After the first run with a given state, this
+    // performs no hashing and no allocation beyond what the nodes themselves do.
     // Data routing: if multiple predecessors, takes the first predecessor's output.
+    // maxThreads <= 1 runs every node inline on the calling thread in topological order.
+    bool run(const ExecutionPlan& plan,
+             const std::shared_ptr<const DataPacket>& input,
+             ExecutionState& st,
+             unsigned maxThreads = std::thread::hardware_concurrency()) const
+    {
+        st.bind(plan);
+        const size_t n = plan.size();
+        st.plan_ = &plan;
+        st.input_ = input;
+        st.ok_ = true;
+        st.tracer_ = activeTracer();
+        st.cache_ = cache_.get();
+        if (st.cache_) st.inputHash_ = input ? input->contentHash() : 0;
+        for (auto& o : st.outputs_) o.reset();
+        if (maxThreads <= 1) {
+            for (uint32_t i = 0; i < n; ++i) {
+                if (st.tracer_) st.readyNs_[i] = st.tracer_->now();
+                if (!runNodeBody(st, i)) break;
+            }
+        } else if (n > 0) {
+            auto pool = acquirePool(maxThreads);
+            st.pool_ = pool.get();
+            st.remaining_ = n;
+            for (uint32_t i = 0; i < n; ++i) st.waiting_[i].store(plan.predCount(i), std::memory_order_relaxed);
+            if (st.tracer_) { const int64_t t0 = st.tracer_->now(); for (uint32_t s : plan.sources()) st.readyNs_[s] = t0; }
+            for (uint32_t s : plan.sources()) st.pool_->submit({&ComputationGraph::runNodeTask, &st, s});
+            waitForCompletion(st);
+            st.pool_ = nullptr;
+        }
+        st.input_.reset();
+        return st.ok_.load();
+    }
+
+    // Block-streaming execution. The source yields consecutive blocks (see
+    // PacketBlockSource); every block flows through the whole plan via processBlock().
+    // Blocks are pipelined: node B may work on block k while node A works on block k+1,
+    // but each node sees its blocks strictly in order and never concurrently.
+    // The sink receives the output node's result for every block, in order, on the
+    // calling thread; returning false from the sink stops the stream.
+    using BlockSourceFn = std::function<bool(std::shared_ptr<const DataPacket>& block, StreamBlock& info)>;
+    using BlockSinkFn = std::function<bool(const StreamBlock& info, const std::shared_ptr<DataPacket>& out)>;
+
+    bool runStreaming(const ExecutionPlan& plan, const BlockSourceFn& source, const BlockSinkFn& sink,
+                      const StreamOptions& opts = {}) const
+    {
+        if (plan.empty()) return true;
+        StreamRun sr;
+        if (!prepareRun(sr, plan, opts.maxInFlight, 1, opts.outputNode)) return false;
+        sr.blockMode = true;
+        for (uint32_t i = 0; i < plan.size(); ++i) plan.node(i)->beginStream();
+        return runPipelined(sr, source, sink, opts.maxThreads);
+    }
+
+    // Throughput mode: run every input packet through the plan with cross-packet
+    // parallelism; results[k] receives the output node's result for inputs[k].
+    // Nodes that implement clone() get one replica per in-flight packet so that no node
+    // state is shared between packets; other nodes process packets one at a time in
+    // input order, which still pipelines them against the rest of the graph.
+    bool executeBatch(const ExecutionPlan& plan,
+                      const std::shared_ptr<const DataPacket>* inputs, size_t count,
+                      std::vector<std::shared_ptr<DataPacket>>& results,
+                      const BatchOptions& opts = {}) const
+    {
+        results.assign(count, nullptr);
+        if (plan.empty() || count == 0) return true;
+        const size_t window = std::max<size_t>(1, std::min(opts.maxInFlight, count));
+        StreamRun sr;
+        if (!prepareRun(sr, plan, window, opts.maxThreads <= 1 ? 1 : window, opts.outputNode)) return false;
+        size_t next = 0;
+        return runPipelined(sr,
+            [&](std::shared_ptr<const DataPacket>& pkt, StreamBlock& info) {
+                if (next >= count) return false;
+                info = StreamBlock{};
+                info.index = next;
+                info.last = next + 1 == count;
+                pkt = inputs[next++];
+                return true;
+            },
+            [&](const StreamBlock& info, const std::shared_ptr<DataPacket>& out) {
+                results[info.index] = out;
+                return true;
+            },
+            opts.maxThreads);
+    }
+
+    bool executeBatch(const ExecutionPlan& plan,
+                      const std::vector<std::shared_ptr<const DataPacket>>& inputs,
+                      std::vector<std::shared_ptr<DataPacket>>& results,
+                      const BatchOptions& opts = {}) const
+    {
+        return executeBatch(plan, inputs.data(), inputs.size(), results, opts);
+    }
+
+    // Convenience one-shot execution keyed by node id: compiles, runs, and maps outputs.
+    // Prefer compile() + run() when executing the same graph repeatedly.
     // Returns true on full execution, false if cycle or failure.
     bool execute(const std::shared_ptr<const DataPacket>& input,
                  std::unordered_map<std::string, std::shared_ptr<DataPacket>>& outputs,
                  unsigned maxThreads = std::thread::hardware_concurrency()) const
     {
-        auto order = topologicalOrder();
-        if (order.empty() && !nodes_.empty()) return false; // cycle
-        // Build predecessors map
-        std::unordered_map<std::string, std::vector<std::string>> pred;
-        for (const auto& [u, nbrs] : adj_) for (const auto& v : nbrs) pred[v].push_back(u);
+        outputs.clear();
+        ExecutionPlan plan;
+        if (!compile(plan)) return false;
+        ExecutionState st(plan);
+        if (!run(plan, input, st, maxThreads)) return false;
+        for (uint32_t i = 0; i < plan.size(); ++i) outputs[plan.id(i)] = st.takeOutput(i);
+        return outputs.size() == nodes_.size();
+    }
+
+private:
+    static bool runNodeBody(ExecutionState& st, uint32_t i) {
+        if (!st.ok_.load(std::memory_order_relaxed)) return false;
+        const ExecutionPlan& plan = *st.plan_;
+        ISynthesisNode* node = plan.node(i);
+        const unsigned thread = st.pool_ ? st.pool_->currentWorker() : 0;
+        if (!tracedInitialize(st.tracer_, node, 0, thread)) { st.ok_ = false; return false; }
+        std::shared_ptr<const DataPacket> in;
+        uint32_t from = ExecutionPlan::npos;
+        for (const uint32_t* p = plan.predBegin(i); p != plan.predEnd(i); ++p) {
+            if (st.outputs_[*p]) { in = st.outputs_[*p]; from = *p; break; }
+        }
+        if (!in) in = st.input_; // source nodes (or fallback)
+
+        // Memoization: key = node id + parameters + input identity. A memoized
+        // predecessor's key stands in for its output's content hash, so intermediate
+        // packets are never rehashed.
+        uint64_t key = 0;
+        bool memo = false;
+        if (st.cache_) {
+            st.keyed_[i] = 0;
+            uint64_t params = 0;
+            if (node->parameterHash(params)) {
+                uint64_t inHash = st.inputHash_;
+                if (from != ExecutionPlan::npos) inHash = st.keyed_[from] ? st.keys_[from] : in->contentHash();
+                key = hash::combine(hash::combine(hash::string(node->id()), params), inHash);
+                st.keys_[i] = key;
+                st.keyed_[i] = 1;
+                memo = true;
+                // Callers own what execute() returns, so a hit is handed out as a copy.
+                if (auto hit = st.cache_->find(key)) { st.outputs_[i] = std::make_shared<DataPacket>(*hit); return true; }
+            }
+        }
+
+        auto out = st.tracer_
+            ? tracedProcess(st.tracer_, node, in, 0, thread, st.readyNs_[i], [&] { return node->process(in); })
+            : node->process(in);
+        if (!out) { st.ok_ = false; return false; }
+        if (memo) st.cache_->insert(key, *out);
+        st.outputs_[i] = std::move(out);
+        return true;
+    }
+
+    static void runNodeTask(void* ctx, uint32_t i) {
+        auto& st = *static_cast<ExecutionState*>(ctx);
+        const ExecutionPlan& plan = *st.plan_;
+        runNodeBody(st, i);
+        // Release successors whose last dependency just completed. They still run after a
+        // failure so the completion count drains; runNodeBody() skips them once ok is false.
+        for (const uint32_t* s = plan.succBegin(i); s != plan.succEnd(i); ++s) {
+            if (st.waiting_[*s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (st.tracer_) st.readyNs_[*s] = st.tracer_->now();
+                st.pool_->submit({&ComputationGraph::runNodeTask, &st, *s});
+            }
+        }
+        // Decrement and notify under the lock: the waiter may reuse st as soon as it sees zero.
+        std::lock_guard<std::mutex> lk(st.doneMutex_);
+        if (--st.remaining_ == 0) st.doneCv_.notify_all();
+    }
+
+    static void waitForCompletion(ExecutionState& st) {
+        for (;;) {
+            // Help drain the pool instead of blocking; required when called from a worker.
+            if (st.pool_->tryRunOne()) {
+                std::lock_guard<std::mutex> lk(st.doneMutex_);
+                if (st.remaining_ == 0) return;
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(st.doneMutex_);
+            if (st.doneCv_.wait_for(lk, std::chrono::microseconds(200), [&] { return st.remaining_ == 0; })) return;
+        }
+    }
 
-        // Thread-limited async execution using a simple semaphore via futures queue
-        std::vector<std::future<void>> inflight;
-        if (maxThreads == 0) maxThreads = 1;
+    // Pipelined scheduler state shared by streaming and batch runs. Each in-flight item
+    // (block or packet) owns a slot. A (node, item) task waits on the node's predecessors
+    // for that item and on the previous item of the same node lane: with one lane a node
+    // sees items strictly in order; with L lanes (batch mode, cloned nodes) item k runs on
+    // replica k % L after item k - L. Bookkeeping is serialized by one mutex: tasks are
+    // whole-item node runs, so the lock is cold compared to the work it guards.
+    struct StreamSlot {
+        size_t block{0};
+        StreamBlock info{};
+        std::shared_ptr<const DataPacket> input;
+        std::vector<std::shared_ptr<DataPacket>> outputs;
+        std::vector<uint32_t> waiting;
+        std::vector<int64_t> readyNs; // filled only while tracing
+        size_t remaining{0};
+    };
+    struct StreamRun {
+        const ExecutionPlan* plan{nullptr};
+        ThreadPool* pool{nullptr};
+        GraphTracer* tracer{nullptr};
+        bool blockMode{false};
+        uint32_t outNode{0};
+        std::vector<StreamSlot> slots;
+        std::vector<uint32_t> lanes;                      // lanes per node (1 = not replicated)
+        std::vector<size_t> laneBase;                     // offset of node i in laneNodes/laneDone
+        std::vector<ISynthesisNode*> laneNodes;           // replica per (node, lane)
+        std::vector<size_t> laneDone;                     // items completed per (node, lane)
+        std::vector<std::shared_ptr<ISynthesisNode>> replicas; // owns cloned nodes
+        size_t admitted{0};
         std::atomic<bool> ok{true};
-        outputs.clear();
-        for (const auto& id : order) {
-            if (!ok.load()) break;
-            // Wait if too many inflight
-            while (inflight.size() >= maxThreads) {
-                inflight.front().get();
-                inflight.erase(inflight.begin());
+        std::mutex m;
+        std::condition_variable cv;
+    };
+
+    bool prepareRun(StreamRun& sr, const ExecutionPlan& plan, size_t window, size_t maxLanes, uint32_t outputNode) const {
+        const size_t n = plan.size();
+        sr.plan = &plan;
+        sr.tracer = activeTracer();
+        sr.outNode = outputNode < n ? outputNode : plan.sinks().back();
+        sr.slots.resize(std::max<size_t>(1, window));
+        for (auto& slot : sr.slots) { slot.outputs.resize(n); slot.waiting.resize(n); slot.readyNs.resize(n); }
+        sr.lanes.assign(n, 1);
+        sr.laneBase.assign(n, 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            ISynthesisNode* node = plan.node(i);
+            if (!tracedInitialize(sr.tracer, node, 0, 0)) return false;
+            sr.laneBase[i] = sr.laneNodes.size();
+            sr.laneNodes.push_back(node);
+            for (size_t l = 1; l < maxLanes; ++l) {
+                auto replica = node->clone();
+                if (!replica) break;
+                if (!tracedInitialize(sr.tracer, replica.get(), l, 0)) return false;
+                sr.laneNodes.push_back(replica.get());
+                sr.replicas.push_back(std::move(replica));
             }
-            // capture by value needed items
-            auto nodeIt = nodes_.find(id);
-            if (nodeIt == nodes_.end()) { ok = false; break; }
-            auto node = nodeIt->second;
-            inflight.emplace_back(std::async(std::launch::async, [&, node, id]() {
-                if (!node->initialize()) { ok = false; return; }
-                std::shared_ptr<const DataPacket> in;
-                auto pit = pred.find(id);
-                if (pit == pred.end() || pit->second.empty()) in = input; // source nodes
-                else {
-                    // pick first predecessor's output if present
-                    auto& plist = pit->second;
-                    for (const auto& p : plist) {
-                        auto oit = outputs.find(p);
-                        if (oit != outputs.end()) { in = oit->second; break; }
-                    }
-                    if (!in) in = input; // fallback
+            sr.lanes[i] = static_cast<uint32_t>(sr.laneNodes.size() - sr.laneBase[i]);
+        }
+        sr.laneDone.assign(sr.laneNodes.size(), 0);
+        return true;
+    }
+
+    bool runPipelined(StreamRun& sr, const BlockSourceFn& source, const BlockSinkFn& sink, unsigned maxThreads) const {
+        const ExecutionPlan& plan = *sr.plan;
+        const size_t n = plan.size();
+        std::shared_ptr<const DataPacket> block;
+        StreamBlock info;
+        if (maxThreads <= 1) {
+            auto& slot = sr.slots[0];
+            while (source(block, info)) {
+                slot.block = info.index;
+                slot.input = std::move(block);
+                slot.info = info;
+                for (uint32_t i = 0; i < n; ++i) {
+                    if (sr.tracer) slot.readyNs[i] = sr.tracer->now();
+                    if (!runBlockBody(sr, slot, i)) return false;
                 }
-                auto out = node->process(in);
-                if (!out) { ok = false; return; }
-                outputs[id] = std::move(out);
-            }));
-        }
-        // drain remaining
-        for (auto& f : inflight) f.get();
-        if (!ok.load()) return false;
-        return outputs.size() == nodes_.size();
+                if (!sink(slot.info, slot.outputs[sr.outNode])) break;
+                for (auto& o : slot.outputs) o.reset();
+            }
+            return true;
+        }
+
+        auto pool = acquirePool(maxThreads);
+        sr.pool = pool.get();
+        const size_t window = sr.slots.size();
+        size_t admitted = 0, emitted = 0;
+        bool more = true;
+        while (more && admitted < window) {
+            if (source(block, info)) admitBlock(sr, admitted++, std::move(block), info);
+            else more = false;
+        }
+        bool stop = false;
+        while (emitted < admitted) {
+            auto& slot = sr.slots[emitted % window];
+            waitForBlock(sr, slot);
+            if (sr.ok.load() && !stop && !sink(slot.info, slot.outputs[sr.outNode])) stop = true;
+            for (auto& o : slot.outputs) o.reset();
+            slot.input.reset();
+            ++emitted;
+            if (more && !stop && sr.ok.load()) {
+                if (source(block, info)) admitBlock(sr, admitted++, std::move(block), info);
+                else more = false;
+            }
+        }
+        return sr.ok.load();
+    }
+
+    static bool runBlockBody(StreamRun& sr, StreamSlot& slot, uint32_t i) {
+        if (!sr.ok.load(std::memory_order_relaxed)) return false;
+        const ExecutionPlan& plan = *sr.plan;
+        std::shared_ptr<const DataPacket> in;
+        for (const uint32_t* p = plan.predBegin(i); p != plan.predEnd(i); ++p) {
+            if (slot.outputs[*p]) { in = slot.outputs[*p]; break; }
+        }
+        if (!in) in = slot.input;
+        ISynthesisNode* node = sr.laneNodes[sr.laneBase[i] + slot.block % sr.lanes[i]];
+        auto call = [&] { return sr.blockMode ? node->processBlock(in, slot.info) : node->process(in); };
+        auto out = sr.tracer
+            ? tracedProcess(sr.tracer, node, in, slot.block, sr.pool ? sr.pool->currentWorker() : 0, slot.readyNs[i], call)
+            : call();
+        if (!out) { sr.ok = false; return false; }
+        slot.outputs[i] = std::move(out);
+        return true;
+    }
+
+    static void submitBlockTask(StreamRun& sr, size_t slotIndex, uint32_t node) {
+        const size_t n = sr.plan->size();
+        if (sr.tracer) sr.slots[slotIndex].readyNs[node] = sr.tracer->now();
+        sr.pool->submit({&ComputationGraph::runBlockTask, &sr, static_cast<uint32_t>(slotIndex * n + node)});
+    }
+
+    static void admitBlock(StreamRun& sr, size_t k, std::shared_ptr<const DataPacket> input, const StreamBlock& info) {
+        const ExecutionPlan& plan = *sr.plan;
+        const size_t n = plan.size();
+        const size_t si = k % sr.slots.size();
+        auto& slot = sr.slots[si];
+        std::lock_guard<std::mutex> lk(sr.m);
+        slot.block = k;
+        slot.info = info;
+        slot.input = std::move(input);
+        slot.remaining = n;
+        sr.admitted = k + 1;
+        for (uint32_t i = 0; i < n; ++i) {
+            const size_t L = sr.lanes[i];
+            const bool laneBusy = sr.laneDone[sr.laneBase[i] + k % L] < k / L;
+            slot.waiting[i] = plan.predCount(i) + (laneBusy ? 1u : 0u);
+        }
+        for (uint32_t i = 0; i < n; ++i) if (slot.waiting[i] == 0) submitBlockTask(sr, si, i);
+    }
+
+    static void runBlockTask(void* ctx, uint32_t arg) {
+        auto& sr = *static_cast<StreamRun*>(ctx);
+        const ExecutionPlan& plan = *sr.plan;
+        const size_t n = plan.size();
+        const size_t si = arg / n;
+        const uint32_t i = static_cast<uint32_t>(arg % n);
+        auto& slot = sr.slots[si];
+        runBlockBody(sr, slot, i);
+
+        std::lock_guard<std::mutex> lk(sr.m);
+        const size_t k = slot.block;
+        const size_t L = sr.lanes[i];
+        sr.laneDone[sr.laneBase[i] + k % L] = k / L + 1;
+        for (const uint32_t* s = plan.succBegin(i); s != plan.succEnd(i); ++s) {
+            if (--slot.waiting[*s] == 0) submitBlockTask(sr, si, *s);
+        }
+        if (k + L < sr.admitted) {
+            const size_t ni = (k + L) % sr.slots.size();
+            if (--sr.slots[ni].waiting[i] == 0) submitBlockTask(sr, ni, i);
+        }
+        if (--slot.remaining == 0) sr.cv.notify_all();
+    }
+
+    static void waitForBlock(StreamRun& sr, StreamSlot& slot) {
+        for (;;) {
+            if (sr.pool->tryRunOne()) {
+                std::lock_guard<std::mutex> lk(sr.m);
+                if (slot.remaining == 0) return;
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(sr.m);
+            if (sr.cv.wait_for(lk, std::chrono::microseconds(200), [&] { return slot.remaining == 0; })) return;
+        }
+    }
+
+    GraphTracer* activeTracer() const { return (tracer_ && tracer_->enabled()) ? tracer_.get() : nullptr; }
+
+    static bool tracedInitialize(GraphTracer* tr, ISynthesisNode* node, size_t item, unsigned thread) {
+        if (!tr) return node->initialize();
+        TraceEvent ev;
+        ev.node = node->id();
+        ev.phase = TraceEvent::Phase::Initialize;
+        ev.item = item;
+        ev.thread = thread;
+        ev.readyNs = ev.startNs = tr->now();
+        const bool ok = node->initialize();
+        ev.endNs = tr->now();
+        tr->record(std::move(ev));
+        return ok;
+    }
+
+    template <typename Fn>
+    static std::shared_ptr<DataPacket> tracedProcess(GraphTracer* tr, ISynthesisNode* node,
+                                                     const std::shared_ptr<const DataPacket>& in,
+                                                     size_t item, unsigned thread, int64_t readyNs, Fn&& fn) {
+        TraceEvent ev;
+        ev.node = node->id();
+        ev.item = item;
+        ev.thread = thread;
+        ev.readyNs = readyNs;
+        GraphTracer::measure(in.get(), ev.inSamples, ev.inFeatureValues);
+        ev.startNs = tr->now();
+        auto out = fn();
+        ev.endNs = tr->now();
+        GraphTracer::measure(out.get(), ev.outSamples, ev.outFeatureValues);
+        tr->record(std::move(ev));
+        return out;
+    }
+
+    std::shared_ptr<ThreadPool> acquirePool(unsigned maxThreads) const {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        if (!pool_ || (ownsPool_ && pool_->size() != maxThreads)) {
+            pool_ = std::make_shared<ThreadPool>(maxThreads);
+            ownsPool_ = true;
+        }
+        return pool_;
     }
 
-private:
     std::unordered_map<std::string, NodePtr> nodes_{};
     std::unordered_map<std::string, std::vector<std::string>> adj_{}; // from -> [to]
+    std::shared_ptr<GraphTracer> tracer_{};
+    std::shared_ptr<NodeResultCache> cache_{};
+    mutable std::mutex poolMutex_{};
+    mutable std::shared_ptr<ThreadPool> pool_{};
+    mutable bool ownsPool_{false};
 };
 
 } // namespace vv
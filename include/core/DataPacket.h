@@ -6,11 +6,57 @@
 #include <string>
 #include <utility>
 #include <vector>
-#include <unordered_map>
+
+#include "core/FeatureKey.h"
+#include "core/FeatureMatrix.h"
+#include "utils/Hash.h"
 
 namespace vv {
 
-// Generic audio/data packet
+// Reference-counted, copy-on-write value. Copies share storage; the first mutable
+// access on a shared (or externally supplied) value detaches a private copy.
+template <typename T>
+class CowPtr {
+public:
+    CowPtr() = default;
+    explicit CowPtr(T v)
+        : data_(std::make_shared<T>(std::move(v))) {}
+    // Adopt an immutable value; it is never written through, only copied on mutation.
+    explicit CowPtr(std::shared_ptr<const T> v)
+        : data_(std::const_pointer_cast<T>(std::move(v))), frozen_(true) {}
+
+    const T& get() const { return data_ ? *data_ : empty(); }
+
+    T& mut() {
+        if (!data_ || frozen_ || data_.use_count() > 1) {
+            data_ = std::make_shared<T>(get());
+            frozen_ = false;
+        }
+        return *data_;
+    }
+
+    std::shared_ptr<const T> share() const {
+        return data_ ? std::shared_ptr<const T>(data_) : std::make_shared<const T>();
+    }
+
+private:
+    static const T& empty() { static const T e{}; return e; }
+
+    std::shared_ptr<T> data_{};
+    bool frozen_{false};
+};
+
+using SharedBuffer = CowPtr<std::vector<float>>;
+using SharedMatrix = CowPtr<FeatureMatrix>;
+
+// Generic audio/data packet.
+// Samples, features and matrices are shared, copy-on-write buffers: copying a packet
+// (e.g. to derive a node's output from its input) costs O(number of keys), and the data
+// is only duplicated by the first non-const access to a buffer that is still shared.
+// Per-frame 2-D data (spectral envelope, aperiodicity) lives in typed FeatureMatrix
+// slots that carry their own shape; features are flat float vectors.
+// Keys are interned (see FeatureKey.h) and index a flat slot table, so copying a packet
+// copies one small vector instead of three hash maps.
 class DataPacket {
 public:
     using Clock = std::chrono::steady_clock;
@@ -28,14 +74,19 @@ public:
           bitDepth_(bitDepth),
           timestamp_(ts) {}
 
-    // Copy/move defaulted for deep copy semantics on vector
+    // Copies share sample/feature storage (copy-on-write)
     DataPacket(const DataPacket&) = default;
     DataPacket(DataPacket&&) noexcept = default;
     DataPacket& operator=(const DataPacket&) = default;
     DataPacket& operator=(DataPacket&&) noexcept = default;
 
-    const std::vector<float>& samples() const { return samples_; }
-    std::vector<float>& samples() { return samples_; }
+    // Non-const access detaches shared storage; prefer the const overload for reading.
+    const std::vector<float>& samples() const { return samples_.get(); }
+    std::vector<float>& samples() { return samples_.mut(); }
+
+    std::shared_ptr<const std::vector<float>> sharedSamples() const { return samples_.share(); }
+    void setSamples(std::vector<float> samples) { samples_ = SharedBuffer(std::move(samples)); }
+    void setSamples(std::shared_ptr<const std::vector<float>> samples) { samples_ = SharedBuffer(std::move(samples)); }
 
     uint32_t sampleRate() const { return sampleRate_; }
     uint16_t channels() const { return channels_; }
@@ -43,40 +94,181 @@ public:
 
     Clock::time_point timestamp() const { return timestamp_; }
 
-    // Feature/metadata attachments for analysis pipelines
-    void setFeature(const std::string& key, std::vector<float> values) {
-        features_[key] = std::move(values);
+    // Feature/metadata attachments for analysis pipelines.
+    // Every accessor comes in two forms: by interned FeatureKey (an index into the slot
+    // table, no hashing) and by name (a registry lookup, then the same slot access).
+    // Features, matrices and scalars are separate namespaces that share the key space.
+    void setFeature(FeatureKey key, std::vector<float> values) {
+        Slot& s = slotFor(key);
+        s.feature = SharedBuffer(std::move(values));
+        s.present |= kFeature;
+    }
+    // Attach an immutable buffer without copying it (e.g. one shared with another packet).
+    void setFeature(FeatureKey key, std::shared_ptr<const std::vector<float>> values) {
+        Slot& s = slotFor(key);
+        s.feature = SharedBuffer(std::move(values));
+        s.present |= kFeature;
+    }
+    bool hasFeature(FeatureKey key) const { return slot(key, kFeature) != nullptr; }
+    const std::vector<float>* getFeature(FeatureKey key) const {
+        const Slot* s = slot(key, kFeature);
+        return s ? &s->feature.get() : nullptr;
+    }
+    // Mutable access detaches the feature from any packet it is shared with.
+    std::vector<float>* getFeature(FeatureKey key) {
+        Slot* s = slot(key, kFeature);
+        return s ? &s->feature.mut() : nullptr;
+    }
+    std::shared_ptr<const std::vector<float>> sharedFeature(FeatureKey key) const {
+        const Slot* s = slot(key, kFeature);
+        return s ? s->feature.share() : nullptr;
     }
-    bool hasFeature(const std::string& key) const {
-        return features_.find(key) != features_.end();
+    void removeFeature(FeatureKey key) {
+        if (Slot* s = slot(key, kFeature)) { s->feature = SharedBuffer(); s->present &= ~kFeature; }
     }
+
+    void setFeature(const std::string& key, std::vector<float> values) { setFeature(intern(key), std::move(values)); }
+    void setFeature(const std::string& key, std::shared_ptr<const std::vector<float>> values) {
+        setFeature(intern(key), std::move(values));
+    }
+    bool hasFeature(const std::string& key) const { FeatureKey k; return lookup(key, k) && hasFeature(k); }
     const std::vector<float>* getFeature(const std::string& key) const {
-        auto it = features_.find(key);
-        return it == features_.end() ? nullptr : &it->second;
+        FeatureKey k;
+        return lookup(key, k) ? getFeature(k) : nullptr;
     }
     std::vector<float>* getFeature(const std::string& key) {
-        auto it = features_.find(key);
-        return it == features_.end() ? nullptr : &it->second;
+        FeatureKey k;
+        return lookup(key, k) ? getFeature(k) : nullptr;
+    }
+    std::shared_ptr<const std::vector<float>> sharedFeature(const std::string& key) const {
+        FeatureKey k;
+        return lookup(key, k) ? sharedFeature(k) : nullptr;
+    }
+    void removeFeature(const std::string& key) { FeatureKey k; if (lookup(key, k)) removeFeature(k); }
+
+    // Typed 2-D matrices
+    void setMatrix(FeatureKey key, FeatureMatrix m) {
+        Slot& s = slotFor(key);
+        s.matrix = SharedMatrix(std::move(m));
+        s.present |= kMatrix;
+    }
+    void setMatrix(FeatureKey key, std::shared_ptr<const FeatureMatrix> m) {
+        Slot& s = slotFor(key);
+        s.matrix = SharedMatrix(std::move(m));
+        s.present |= kMatrix;
+    }
+    bool hasMatrix(FeatureKey key) const { return slot(key, kMatrix) != nullptr; }
+    const FeatureMatrix* getMatrix(FeatureKey key) const {
+        const Slot* s = slot(key, kMatrix);
+        return s ? &s->matrix.get() : nullptr;
+    }
+    // Mutable access detaches the matrix from any packet it is shared with.
+    FeatureMatrix* getMatrix(FeatureKey key) {
+        Slot* s = slot(key, kMatrix);
+        return s ? &s->matrix.mut() : nullptr;
+    }
+    std::shared_ptr<const FeatureMatrix> sharedMatrix(FeatureKey key) const {
+        const Slot* s = slot(key, kMatrix);
+        return s ? s->matrix.share() : nullptr;
+    }
+    void removeMatrix(FeatureKey key) {
+        if (Slot* s = slot(key, kMatrix)) { s->matrix = SharedMatrix(); s->present &= ~kMatrix; }
     }
 
-    void setScalar(const std::string& key, double value) {
-        scalars_[key] = value;
+    void setMatrix(const std::string& key, FeatureMatrix m) { setMatrix(intern(key), std::move(m)); }
+    void setMatrix(const std::string& key, std::shared_ptr<const FeatureMatrix> m) { setMatrix(intern(key), std::move(m)); }
+    bool hasMatrix(const std::string& key) const { FeatureKey k; return lookup(key, k) && hasMatrix(k); }
+    const FeatureMatrix* getMatrix(const std::string& key) const {
+        FeatureKey k;
+        return lookup(key, k) ? getMatrix(k) : nullptr;
     }
-    bool hasScalar(const std::string& key) const {
-        return scalars_.find(key) != scalars_.end();
+    FeatureMatrix* getMatrix(const std::string& key) {
+        FeatureKey k;
+        return lookup(key, k) ? getMatrix(k) : nullptr;
+    }
+    std::shared_ptr<const FeatureMatrix> sharedMatrix(const std::string& key) const {
+        FeatureKey k;
+        return lookup(key, k) ? sharedMatrix(k) : nullptr;
+    }
+    void removeMatrix(const std::string& key) { FeatureKey k; if (lookup(key, k)) removeMatrix(k); }
+
+    void setScalar(FeatureKey key, double value) {
+        Slot& s = slotFor(key);
+        s.scalar = value;
+        s.present |= kScalar;
     }
+    bool hasScalar(FeatureKey key) const { return slot(key, kScalar) != nullptr; }
+    double getScalar(FeatureKey key, double def = 0.0) const {
+        const Slot* s = slot(key, kScalar);
+        return s ? s->scalar : def;
+    }
+
+    void setScalar(const std::string& key, double value) { setScalar(intern(key), value); }
+    bool hasScalar(const std::string& key) const { FeatureKey k; return lookup(key, k) && hasScalar(k); }
     double getScalar(const std::string& key, double def = 0.0) const {
-        auto it = scalars_.find(key);
-        return it == scalars_.end() ? def : it->second;
+        FeatureKey k;
+        return lookup(key, k) ? getScalar(k, def) : def;
+    }
+
+    // Visit every feature / matrix / scalar as (name, value), in FeatureKey order.
+    template <typename Fn>
+    void forEachFeature(Fn&& fn) const {
+        for (size_t i = 0; i < slots_.size(); ++i)
+            if (slots_[i].present & kFeature) fn(nameOf(i), slots_[i].feature.get());
+    }
+    template <typename Fn>
+    void forEachMatrix(Fn&& fn) const {
+        for (size_t i = 0; i < slots_.size(); ++i)
+            if (slots_[i].present & kMatrix) fn(nameOf(i), slots_[i].matrix.get());
+    }
+    template <typename Fn>
+    void forEachScalar(Fn&& fn) const {
+        for (size_t i = 0; i < slots_.size(); ++i)
+            if (slots_[i].present & kScalar) fn(nameOf(i), slots_[i].scalar);
+    }
+
+    // 64-bit hash of the audio format, samples, features, matrices and scalars (timestamp excluded).
+    // Keys contribute by name, so the hash does not depend on FeatureKey registration order.
+    uint64_t contentHash() const {
+        uint64_t h = hash::value(sampleRate_);
+        h = hash::combine(h, hash::value(channels_));
+        h = hash::combine(h, hash::value(bitDepth_));
+        const auto& x = samples_.get();
+        h = hash::combine(h, hash::bytes(x.data(), x.size() * sizeof(float)));
+        uint64_t fh = 0, sh = 0; // commutative sums: key values differ between processes
+        const auto& reg = FeatureRegistry::global();
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            const Slot& s = slots_[i];
+            if (!s.present) continue;
+            const uint64_t kh = reg.nameHash(static_cast<FeatureKey>(i));
+            if (s.present & kFeature) {
+                const auto& v = s.feature.get();
+                fh += hash::combine(kh, hash::bytes(v.data(), v.size() * sizeof(float)));
+            }
+            if (s.present & kMatrix) fh += hash::combine(hash::mix(kh + 1), s.matrix.get().contentHash()); // own key space
+            if (s.present & kScalar) sh += hash::combine(kh, hash::value(s.scalar));
+        }
+        return hash::combine(hash::combine(h, fh), sh);
+    }
+
+    // Approximate payload footprint in bytes (samples + features + matrices + scalars).
+    size_t byteSize() const {
+        size_t bytes = samples_.get().size() * sizeof(float) + slots_.size() * sizeof(Slot);
+        for (const auto& s : slots_) {
+            if (s.present & kFeature) bytes += s.feature.get().size() * sizeof(float);
+            if (s.present & kMatrix) bytes += s.matrix.get().byteSize();
+        }
+        return bytes;
     }
 
     // Serialization placeholders (simple form)
     std::string serialize() const {
         // very simple csv-like format: sr,channels,bitdepth;count;values...
-        std::string out = std::to_string(sampleRate_) + "," + std::to_string(channels_) + "," + std::to_string(bitDepth_) + ";" + std::to_string(samples_.size()) + ";";
-        for (size_t i = 0; i < samples_.size(); ++i) {
-            out += std::to_string(samples_[i]);
-            if (i + 1 < samples_.size()) out += ",";
+        const auto& x = samples_.get();
+        std::string out = std::to_string(sampleRate_) + "," + std::to_string(channels_) + "," + std::to_string(bitDepth_) + ";" + std::to_string(x.size()) + ";";
+        for (size_t i = 0; i < x.size(); ++i) {
+            out += std::to_string(x[i]);
+            if (i + 1 < x.size()) out += ",";
         }
         return out;
     }
@@ -97,29 +289,55 @@ public:
             pkt.channels_ = static_cast<uint16_t>(std::stoul(header.substr(p1 + 1, p2 - p1 - 1)));
             pkt.bitDepth_ = static_cast<uint16_t>(std::stoul(header.substr(p2 + 1)));
         }
-        pkt.samples_.clear(); pkt.samples_.reserve(count);
+        auto& xs = pkt.samples_.mut();
+        xs.clear(); xs.reserve(count);
         auto values = data.substr(secondSemi + 1);
         size_t start = 0;
-        while (start < values.size() && pkt.samples_.size() < count) {
+        while (start < values.size() && xs.size() < count) {
             size_t comma = values.find(',', start);
             auto token = values.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
-            try { pkt.samples_.push_back(std::stof(token)); } catch (...) { pkt.samples_.push_back(0.0f); }
+            try { xs.push_back(std::stof(token)); } catch (...) { xs.push_back(0.0f); }
             if (comma == std::string::npos) break;
             start = comma + 1;
         }
         // pad if fewer parsed
-        while (pkt.samples_.size() < count) pkt.samples_.push_back(0.0f);
+        while (xs.size() < count) xs.push_back(0.0f);
         return pkt;
     }
 
 private:
-    std::vector<float> samples_{};
+    SharedBuffer samples_{};
     uint32_t sampleRate_{48000};
     uint16_t channels_{1};
     uint16_t bitDepth_{32};
     Clock::time_point timestamp_{Clock::now()};
-    std::unordered_map<std::string, std::vector<float>> features_{};
-    std::unordered_map<std::string, double> scalars_{};
+    enum : uint8_t { kFeature = 1, kMatrix = 2, kScalar = 4 };
+    struct Slot {
+        uint8_t present{0};
+        double scalar{0.0};
+        SharedBuffer feature{};
+        SharedMatrix matrix{};
+    };
+
+    static FeatureKey intern(const std::string& key) { return FeatureRegistry::global().intern(key); }
+    static bool lookup(const std::string& key, FeatureKey& k) { return FeatureRegistry::global().find(key, k); }
+    static const std::string& nameOf(size_t i) { return FeatureRegistry::global().name(static_cast<FeatureKey>(i)); }
+
+    const Slot* slot(FeatureKey key, uint8_t kind) const {
+        const size_t i = keyIndex(key);
+        return i < slots_.size() && (slots_[i].present & kind) ? &slots_[i] : nullptr;
+    }
+    Slot* slot(FeatureKey key, uint8_t kind) {
+        const size_t i = keyIndex(key);
+        return i < slots_.size() && (slots_[i].present & kind) ? &slots_[i] : nullptr;
+    }
+    Slot& slotFor(FeatureKey key) {
+        const size_t i = keyIndex(key);
+        if (i >= slots_.size()) slots_.resize(i + 1);
+        return slots_[i];
+    }
+
+    std::vector<Slot> slots_{}; // indexed by FeatureKey
 };
 
 } // namespace vv
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/IPostFilter.h"
+#include "core/ParameterExchange.h"
+#include "utils/Biquad.h"
+#include "utils/VectorMath.h"
+
+namespace vv {
+
+// Production post-filters: biquad EQ, spectral tilt, de-esser and compressor/limiter.
+// - Parameters are set from any one control thread through setParams(), which hands
+//   them over lock-free (ParameterExchange); process() picks up the newest set at the
+//   start of each call and glides towards it (about 20 ms) in control blocks of
+//   kControlBlock frames, so automation does not click. Settled filters process the
+//   whole call at once. params() and clone() belong to the control thread; prepare(),
+//   reset() and process() see only the audio side's copy.
+// - IIR cascades longer than two sections run as a vectorized wavefront across
+//   sections (iir::BiquadCascade); detector gains are computed over whole chunks with
+//   the array log/exp of utils/VectorMath.h.
+// - process() neither allocates nor locks; buffers are sized by prepare().
+
+namespace dsp {
+constexpr size_t kControlBlock = 64; // frames per parameter update while gliding
+constexpr size_t kChunk = 256;       // frames per detector pass (compressor, de-esser)
+
+// One-pole glide of a value towards its target, advanced once per control block.
+struct Glide {
+    float value{0.0f}, target{0.0f};
+    void snap(float v) { value = target = v; }
+    // False once settled.
+    bool advance(float coeff) {
+        if (value == target) return false;
+        value += coeff * (target - value);
+        if (std::fabs(target - value) <= 1e-4f * (1.0f + std::fabs(target))) value = target;
+        return true;
+    }
+};
+
+inline float glideCoeff(uint32_t sampleRate) {
+    return static_cast<float>(1.0 - std::exp(-static_cast<double>(kControlBlock) / (0.02 * std::max<uint32_t>(1, sampleRate))));
+}
+
+// One-pole coefficient for an envelope time constant in milliseconds.
+inline float timeCoeff(float ms, uint32_t sampleRate) {
+    return static_cast<float>(1.0 - std::exp(-1000.0 / (std::max(0.01f, ms) * std::max<uint32_t>(1, sampleRate))));
+}
+
+// Calls body(first, n) over [0, frames): one control block at a time while advance()
+// reports the parameters still moving, then the remainder at once.
+template <typename Advance, typename Body>
+void runControlBlocks(size_t frames, Advance&& advance, Body&& body) {
+    for (size_t first = 0; first < frames;) {
+        const size_t n = advance() ? std::min(kControlBlock, frames - first) : frames - first;
+        body(first, n);
+        first += n;
+    }
+}
+
+// Peak level of every frame across channels, then a one-pole attack/release follower;
+// level[i] ends up in dB.
+inline void detectLevelDb(const float* x, size_t frames, uint16_t channels, float attack, float release,
+                          float& envelope, float* level) {
+    for (size_t i = 0; i < frames; ++i) {
+        float peak = 0.0f;
+        for (uint16_t c = 0; c < channels; ++c) peak = std::max(peak, std::fabs(x[i * channels + c]));
+        envelope += (peak > envelope ? attack : release) * (peak - envelope);
+        level[i] = envelope + 1e-9f;
+    }
+    vmath::log(level, level, frames);
+    for (size_t i = 0; i < frames; ++i) level[i] *= 8.68588963806504f; // 20 / ln 10
+}
+
+// 10^(dB / 20) in place.
+inline void dbToGain(float* db, size_t n) {
+    for (size_t i = 0; i < n; ++i) db[i] *= 0.115129254649702f; // ln 10 / 20
+    vmath::exp(db, db, n);
+}
+} // namespace dsp
+
+struct EqBand {
+    iir::BiquadType type{iir::BiquadType::Peaking};
+    float freqHz{1000.0f};
+    float q{0.707f};
+    float gainDb{0.0f};
+};
+
+struct EqualizerParams {
+    size_t bands{0}; // used entries of band (at most band.size())
+    std::array<EqBand, iir::BiquadCascade::kMaxSections> band{};
+};
+
+// Parametric EQ: up to eight biquad bands in series per channel. Frequency, Q and gain
+// glide; a change of band type or count takes effect at once.
+class EqualizerFilter : public IPostFilter {
+public:
+    explicit EqualizerFilter(const EqualizerParams& params = {}) : params_(clamped(params)), current_(clamped(params)) {}
+
+    void setParams(const EqualizerParams& params) { params_.publish(clamped(params)); }
+    const EqualizerParams& params() const { return params_.latest(); }
+
+    void prepare(uint32_t sampleRate, uint16_t channels) override {
+        sampleRate_ = sampleRate;
+        channels_ = std::max<uint16_t>(1, channels);
+        cascades_.assign(channels_, iir::BiquadCascade{});
+        params_.fetch(current_);
+        for (size_t b = 0; b < current_.bands; ++b) {
+            logFreq_[b].snap(std::log(current_.band[b].freqHz));
+            logQ_[b].snap(std::log(current_.band[b].q));
+            gain_[b].snap(current_.band[b].gainDb);
+        }
+        design();
+    }
+    void reset() override { for (auto& c : cascades_) c.reset(); }
+
+    void process(float* interleaved, size_t frames) override {
+        if (cascades_.empty() || !interleaved) return;
+        EqualizerParams next;
+        if (params_.fetch(next)) retarget(next);
+        const float k = dsp::glideCoeff(sampleRate_);
+        dsp::runControlBlocks(frames, [&] {
+            bool moving = false;
+            for (size_t b = 0; b < current_.bands; ++b) {
+                moving |= logFreq_[b].advance(k);
+                moving |= logQ_[b].advance(k);
+                moving |= gain_[b].advance(k);
+            }
+            if (moving) design();
+            return moving;
+        }, [&](size_t first, size_t n) {
+            for (uint16_t c = 0; c < channels_; ++c) cascades_[c].process(interleaved + first * channels_ + c, n, channels_);
+        });
+    }
+
+    std::shared_ptr<IPostFilter> clone() const override { return std::make_shared<EqualizerFilter>(params_.latest()); }
+
+private:
+    static EqualizerParams clamped(EqualizerParams p) {
+        p.bands = std::min(p.bands, p.band.size());
+        return p;
+    }
+    void retarget(const EqualizerParams& next) {
+        const bool layout = next.bands != current_.bands ||
+            !std::equal(next.band.begin(), next.band.begin() + static_cast<std::ptrdiff_t>(next.bands),
+                        current_.band.begin(), [](const EqBand& a, const EqBand& b) { return a.type == b.type; });
+        current_ = next;
+        for (size_t b = 0; b < current_.bands; ++b) {
+            logFreq_[b].target = std::log(current_.band[b].freqHz);
+            logQ_[b].target = std::log(current_.band[b].q);
+            gain_[b].target = current_.band[b].gainDb;
+            if (layout) { logFreq_[b].snap(logFreq_[b].target); logQ_[b].snap(logQ_[b].target); gain_[b].snap(gain_[b].target); }
+        }
+        if (layout) design();
+    }
+    void design() {
+        for (auto& c : cascades_) {
+            c.setSections(current_.bands);
+            for (size_t b = 0; b < current_.bands; ++b) {
+                c.setCoeffs(b, iir::design(current_.band[b].type, sampleRate_, std::exp(logFreq_[b].value),
+                                           std::exp(logQ_[b].value), gain_[b].value));
+            }
+        }
+    }
+
+    ParameterExchange<EqualizerParams> params_;
+    EqualizerParams current_; // audio side
+    std::array<dsp::Glide, iir::BiquadCascade::kMaxSections> logFreq_{}, logQ_{}, gain_{};
+    std::vector<iir::BiquadCascade> cascades_;
+    uint32_t sampleRate_{48000};
+    uint16_t channels_{1};
+};
+
+struct TiltParams {
+    float tiltDb{0.0f};      // level of the top of the spectrum relative to the bottom
+    float pivotHz{1000.0f};  // unchanged frequency
+};
+
+// Formant-preserving spectral tilt: complementary broad (Q 0.5) low and high shelves
+// around the pivot, -tilt/2 and +tilt/2 dB. Being smooth and minimum-phase, they brighten
+// or darken a voice without adding resonances or moving its formant peaks.
+class TiltFilter : public IPostFilter {
+public:
+    explicit TiltFilter(const TiltParams& params = {}) : params_(params), current_(params) {}
+
+    void setParams(const TiltParams& params) { params_.publish(params); }
+    const TiltParams& params() const { return params_.latest(); }
+
+    void prepare(uint32_t sampleRate, uint16_t channels) override {
+        sampleRate_ = sampleRate;
+        channels_ = std::max<uint16_t>(1, channels);
+        cascades_.assign(channels_, iir::BiquadCascade{});
+        params_.fetch(current_);
+        tilt_.snap(current_.tiltDb);
+        logPivot_.snap(std::log(current_.pivotHz));
+        design();
+    }
+    void reset() override { for (auto& c : cascades_) c.reset(); }
+
+    void process(float* interleaved, size_t frames) override {
+        if (cascades_.empty() || !interleaved) return;
+        if (params_.fetch(current_)) { tilt_.target = current_.tiltDb; logPivot_.target = std::log(current_.pivotHz); }
+        const float k = dsp::glideCoeff(sampleRate_);
+        dsp::runControlBlocks(frames, [&] {
+            const bool moving = tilt_.advance(k) | logPivot_.advance(k);
+            if (moving) design();
+            return moving;
+        }, [&](size_t first, size_t n) {
+            // Flat: skipped. The history is stale by the time the tilt moves off 0, so the
+            // shelves restart from silence (they are near-transparent there).
+            if (tilt_.value == 0.0f) { idle_ = true; return; }
+            if (idle_) { reset(); idle_ = false; }
+            for (uint16_t c = 0; c < channels_; ++c) cascades_[c].process(interleaved + first * channels_ + c, n, channels_);
+        });
+    }
+
+    std::shared_ptr<IPostFilter> clone() const override { return std::make_shared<TiltFilter>(params_.latest()); }
+
+private:
+    void design() {
+        const double pivot = std::exp(logPivot_.value);
+        const auto low = iir::design(iir::BiquadType::LowShelf, sampleRate_, pivot, 0.5, -0.5 * tilt_.value);
+        const auto high = iir::design(iir::BiquadType::HighShelf, sampleRate_, pivot, 0.5, 0.5 * tilt_.value);
+        for (auto& c : cascades_) { c.setSections(2); c.setCoeffs(0, low); c.setCoeffs(1, high); }
+    }
+
+    ParameterExchange<TiltParams> params_;
+    TiltParams current_; // audio side
+    bool idle_{false};   // cascades skipped since the last block
+    dsp::Glide tilt_{}, logPivot_{};
+    std::vector<iir::BiquadCascade> cascades_;
+    uint32_t sampleRate_{48000};
+    uint16_t channels_{1};
+};
+
+struct DeEsserParams {
+    float freqHz{6500.0f};      // centre of the sibilance band
+    float q{1.0f};
+    float thresholdDb{-30.0f};  // band level where reduction starts
+    float ratio{4.0f};
+    float rangeDb{12.0f};       // deepest reduction
+    float attackMs{1.0f};
+    float releaseMs{60.0f};
+};
+
+// Split-band de-esser: the sibilance band (a 0 dB band-pass) drives a compressor whose
+// gain applies to that band only, y = x - (1 - g) * band; at full reduction this is the
+// complementary notch. Threshold, ratio and range glide; the band filter follows
+// freqHz/q as set.
+class DeEsserFilter : public IPostFilter {
+public:
+    explicit DeEsserFilter(const DeEsserParams& params = {}) : params_(params), current_(params) {}
+
+    void setParams(const DeEsserParams& params) { params_.publish(params); }
+    const DeEsserParams& params() const { return params_.latest(); }
+
+    void prepare(uint32_t sampleRate, uint16_t channels) override {
+        sampleRate_ = sampleRate;
+        channels_ = std::max<uint16_t>(1, channels);
+        bandpass_.assign(channels_, iir::BiquadCascade{});
+        band_.assign(dsp::kChunk * channels_, 0.0f);
+        level_.assign(dsp::kChunk, 0.0f);
+        params_.fetch(current_);
+        threshold_.snap(current_.thresholdDb);
+        slope_.snap(1.0f - 1.0f / std::max(1.0f, current_.ratio));
+        range_.snap(current_.rangeDb);
+        configure();
+        reset();
+    }
+    void reset() override { for (auto& c : bandpass_) c.reset(); envelope_ = 0.0f; }
+
+    void process(float* interleaved, size_t frames) override {
+        if (bandpass_.empty() || !interleaved) return;
+        DeEsserParams next;
+        if (params_.fetch(next)) {
+            current_ = next;
+            threshold_.target = next.thresholdDb;
+            slope_.target = 1.0f - 1.0f / std::max(1.0f, next.ratio);
+            range_.target = next.rangeDb;
+            configure();
+        }
+        const float k = dsp::glideCoeff(sampleRate_);
+        dsp::runControlBlocks(frames, [&] {
+            return threshold_.advance(k) | slope_.advance(k) | range_.advance(k);
+        }, [&](size_t first, size_t n) {
+            for (size_t done = 0; done < n; done += dsp::kChunk) processChunk(interleaved + (first + done) * channels_, std::min(dsp::kChunk, n - done));
+        });
+    }
+
+    std::shared_ptr<IPostFilter> clone() const override { return std::make_shared<DeEsserFilter>(params_.latest()); }
+
+private:
+    void configure() {
+        const auto c = iir::design(iir::BiquadType::BandPass, sampleRate_, current_.freqHz, current_.q, 0.0);
+        for (auto& f : bandpass_) { f.setSections(1); f.setCoeffs(0, c); }
+        attack_ = dsp::timeCoeff(current_.attackMs, sampleRate_);
+        release_ = dsp::timeCoeff(current_.releaseMs, sampleRate_);
+    }
+    void processChunk(float* x, size_t frames) {
+        const size_t count = frames * channels_;
+        float* band = band_.data();
+        float* g = level_.data();
+        std::copy(x, x + count, band);
+        for (uint16_t c = 0; c < channels_; ++c) bandpass_[c].process(band + c, frames, channels_);
+        dsp::detectLevelDb(band, frames, channels_, attack_, release_, envelope_, g);
+        // Reduction in dB, capped at the range, as the (negative) band gain.
+        const float t = threshold_.value, s = slope_.value, r = range_.value;
+        for (size_t i = 0; i < frames; ++i) g[i] = -std::min(r, std::max(0.0f, g[i] - t) * s);
+        dsp::dbToGain(g, frames);
+        for (size_t i = 0; i < frames; ++i) {
+            const float cut = 1.0f - g[i];
+            for (uint16_t c = 0; c < channels_; ++c) x[i * channels_ + c] -= cut * band[i * channels_ + c];
+        }
+    }
+
+    ParameterExchange<DeEsserParams> params_;
+    DeEsserParams current_; // audio side
+    dsp::Glide threshold_{}, slope_{}, range_{};
+    std::vector<iir::BiquadCascade> bandpass_;
+    std::vector<float> band_, level_;
+    float envelope_{0.0f}, attack_{0.0f}, release_{0.0f};
+    uint32_t sampleRate_{48000};
+    uint16_t channels_{1};
+};
+
+struct CompressorParams {
+    float thresholdDb{-18.0f};
+    float ratio{4.0f};
+    float kneeDb{6.0f};       // soft-knee width around the threshold
+    float attackMs{5.0f};
+    float releaseMs{80.0f};
+    float makeupDb{0.0f};
+    bool limit{false};        // infinite ratio, output clamped to threshold + makeup
+
+    // Fast limiter at `ceilingDb`. Without look-ahead the detector lags a transient by
+    // about the attack time; the output clamp catches that overshoot.
+    static CompressorParams limiter(float ceilingDb = -1.0f) {
+        CompressorParams p;
+        p.thresholdDb = ceilingDb; p.kneeDb = 0.0f; p.attackMs = 0.5f; p.releaseMs = 50.0f; p.limit = true;
+        return p;
+    }
+};
+
+// Feed-forward compressor/limiter with a soft knee and channel-linked peak detection.
+// Threshold, knee, ratio and make-up glide; attack/release apply at once.
+class CompressorFilter : public IPostFilter {
+public:
+    explicit CompressorFilter(const CompressorParams& params = {}) : params_(params), current_(params) {}
+
+    void setParams(const CompressorParams& params) { params_.publish(params); }
+    const CompressorParams& params() const { return params_.latest(); }
+
+    void prepare(uint32_t sampleRate, uint16_t channels) override {
+        sampleRate_ = sampleRate;
+        channels_ = std::max<uint16_t>(1, channels);
+        gain_.assign(dsp::kChunk, 0.0f);
+        params_.fetch(current_);
+        apply(current_, true);
+        reset();
+    }
+    void reset() override { envelope_ = 0.0f; }
+
+    void process(float* interleaved, size_t frames) override {
+        if (gain_.empty() || !interleaved) return;
+        if (params_.fetch(current_)) apply(current_, false);
+        const float k = dsp::glideCoeff(sampleRate_);
+        dsp::runControlBlocks(frames, [&] {
+            return threshold_.advance(k) | knee_.advance(k) | slope_.advance(k) | makeup_.advance(k);
+        }, [&](size_t first, size_t n) {
+            for (size_t done = 0; done < n; done += dsp::kChunk) processChunk(interleaved + (first + done) * channels_, std::min(dsp::kChunk, n - done));
+        });
+    }
+
+    std::shared_ptr<IPostFilter> clone() const override { return std::make_shared<CompressorFilter>(params_.latest()); }
+
+private:
+    void apply(const CompressorParams& p, bool snap) {
+        const float slope = p.limit ? 1.0f : 1.0f - 1.0f / std::max(1.0f, p.ratio);
+        if (snap) {
+            threshold_.snap(p.thresholdDb); knee_.snap(p.kneeDb); slope_.snap(slope); makeup_.snap(p.makeupDb);
+        } else {
+            threshold_.target = p.thresholdDb; knee_.target = p.kneeDb; slope_.target = slope; makeup_.target = p.makeupDb;
+        }
+        limit_ = p.limit;
+        attack_ = dsp::timeCoeff(p.attackMs, sampleRate_);
+        release_ = dsp::timeCoeff(p.releaseMs, sampleRate_);
+    }
+    void processChunk(float* x, size_t frames) {
+        float* g = gain_.data();
+        dsp::detectLevelDb(x, frames, channels_, attack_, release_, envelope_, g);
+        // Soft knee without branches: with y = max(0, over + W/2), the reduction is
+        // slope * (min(y, W)^2 / 2W + max(0, y - W)), i.e. 0 below the knee, quadratic
+        // inside it and slope * over above it.
+        const float t = threshold_.value, w = std::max(1e-3f, knee_.value), s = slope_.value, m = makeup_.value;
+        for (size_t i = 0; i < frames; ++i) {
+            const float y = std::max(0.0f, g[i] - t + 0.5f * w);
+            const float inside = std::min(y, w);
+            g[i] = m - s * (inside * inside / (2.0f * w) + std::max(0.0f, y - w));
+        }
+        dsp::dbToGain(g, frames);
+        const size_t ch = channels_;
+        for (size_t i = 0; i < frames; ++i)
+            for (size_t c = 0; c < ch; ++c) x[i * ch + c] *= g[i];
+        if (limit_) {
+            const float ceiling = std::pow(10.0f, (t + m) / 20.0f);
+            for (size_t i = 0; i < frames * ch; ++i) x[i] = std::clamp(x[i], -ceiling, ceiling);
+        }
+    }
+
+    ParameterExchange<CompressorParams> params_;
+    CompressorParams current_; // audio side
+    dsp::Glide threshold_{}, knee_{}, slope_{}, makeup_{};
+    std::vector<float> gain_;
+    float envelope_{0.0f}, attack_{0.0f}, release_{0.0f};
+    bool limit_{false};
+    uint32_t sampleRate_{48000};
+    uint16_t channels_{1};
+};
+
+} // namespace vv
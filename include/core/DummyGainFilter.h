@@ -2,25 +2,41 @@
 
 #include "core/IPostFilter.h"
 #include <algorithm>
+#include <atomic>
 
 namespace vv {
 
+// Plain gain. setGain() may be called from any thread while audio runs; a change ramps
+// linearly over the next process() call instead of stepping.
 class DummyGainFilter : public IPostFilter {
 public:
-    explicit DummyGainFilter(float gain = 1.0f) : gain_(gain) {}
+    explicit DummyGainFilter(float gain = 1.0f) : gain_(gain), applied_(gain) {}
 
-    void setGain(float g) { gain_ = g; }
-    float gain() const { return gain_; }
+    void setGain(float g) { gain_.store(g, std::memory_order_relaxed); }
+    float gain() const { return gain_.load(std::memory_order_relaxed); }
 
-    void prepare(uint32_t /*sampleRate*/, uint16_t /*channels*/) override {}
-    void reset() override {}
+    void prepare(uint32_t /*sampleRate*/, uint16_t channels) override { channels_ = std::max<uint16_t>(1, channels); }
+    void reset() override { applied_ = gain(); }
     void process(float* interleaved, size_t frames) override {
         if (!interleaved || frames == 0) return;
-        for (size_t i = 0; i < frames; ++i) interleaved[i] *= gain_;
+        const float target = gain();
+        if (target == applied_) {
+            for (size_t i = 0; i < frames * channels_; ++i) interleaved[i] *= target;
+            return;
+        }
+        const float step = (target - applied_) / static_cast<float>(frames);
+        for (size_t i = 0; i < frames; ++i) {
+            const float g = applied_ + step * static_cast<float>(i + 1);
+            for (size_t c = 0; c < channels_; ++c) interleaved[i * channels_ + c] *= g;
+        }
+        applied_ = target;
     }
+    std::shared_ptr<IPostFilter> clone() const override { return std::make_shared<DummyGainFilter>(gain()); }
 
 private:
-    float gain_;
+    std::atomic<float> gain_;
+    float applied_;
+    size_t channels_{1};
 };
 
 } // namespace vv
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/ISynthesisNode.h"
+
+namespace vv {
+
+class ComputationGraph;
+class ThreadPool;
+class GraphTracer;
+class NodeResultCache;
+
+// Immutable, compiled form of a ComputationGraph (see ComputationGraph::compile()).
+// Nodes are addressed by dense indices in topological order; edges are stored as flat
+// CSR arrays. The plan holds its own references to the nodes, so it stays valid if the
+// graph is edited afterwards.
+class ExecutionPlan {
+public:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    ExecutionPlan() = default;
+
+    size_t size() const { return nodes_.size(); }
+    bool empty() const { return nodes_.empty(); }
+
+    ISynthesisNode* node(uint32_t i) const { return nodes_[i].get(); }
+    const std::string& id(uint32_t i) const { return ids_[i]; }
+
+    const uint32_t* predBegin(uint32_t i) const { return predIndex_.data() + predOffsets_[i]; }
+    const uint32_t* predEnd(uint32_t i) const { return predIndex_.data() + predOffsets_[i + 1]; }
+    uint32_t predCount(uint32_t i) const { return predOffsets_[i + 1] - predOffsets_[i]; }
+
+    const uint32_t* succBegin(uint32_t i) const { return succIndex_.data() + succOffsets_[i]; }
+    const uint32_t* succEnd(uint32_t i) const { return succIndex_.data() + succOffsets_[i + 1]; }
+    uint32_t succCount(uint32_t i) const { return succOffsets_[i + 1] - succOffsets_[i]; }
+
+    const std::vector<uint32_t>& sources() const { return sources_; }
+    const std::vector<uint32_t>& sinks() const { return sinks_; }
+
+    // Setup-time lookup (linear scan); cache the index rather than calling per run.
+    uint32_t indexOf(const std::string& id) const {
+        for (size_t i = 0; i < ids_.size(); ++i) if (ids_[i] == id) return static_cast<uint32_t>(i);
+        return npos;
+    }
+
+private:
+    friend class ComputationGraph;
+
+    std::vector<std::shared_ptr<ISynthesisNode>> nodes_{};
+    std::vector<std::string> ids_{};
+    std::vector<uint32_t> predOffsets_{0};
+    std::vector<uint32_t> predIndex_{};
+    std::vector<uint32_t> succOffsets_{0};
+    std::vector<uint32_t> succIndex_{};
+    std::vector<uint32_t> sources_{};
+    std::vector<uint32_t> sinks_{};
+};
+
+// Reusable per-run scratch for ComputationGraph::run(). Output slots and dependency
+// counters are allocated once for a plan size and reused, so repeated runs of the same
+// plan do not touch the allocator. Not safe to share between concurrent runs.
+class ExecutionState {
+public:
+    ExecutionState() = default;
+    explicit ExecutionState(const ExecutionPlan& plan) { bind(plan); }
+
+    void bind(const ExecutionPlan& plan) {
+        if (outputs_.size() != plan.size()) {
+            outputs_.assign(plan.size(), nullptr);
+            waiting_ = std::make_unique<std::atomic<uint32_t>[]>(plan.size());
+            readyNs_.assign(plan.size(), 0);
+            keys_.assign(plan.size(), 0);
+            keyed_.assign(plan.size(), 0);
+        }
+    }
+
+    size_t size() const { return outputs_.size(); }
+
+    // Output of node i from the last run (null if it did not run).
+    const std::shared_ptr<DataPacket>& output(uint32_t i) const { return outputs_[i]; }
+    std::shared_ptr<DataPacket> takeOutput(uint32_t i) { return std::move(outputs_[i]); }
+
+private:
+    friend class ComputationGraph;
+
+    const ExecutionPlan* plan_{nullptr};
+    std::shared_ptr<const DataPacket> input_{};
+    std::vector<std::shared_ptr<DataPacket>> outputs_{};
+    std::unique_ptr<std::atomic<uint32_t>[]> waiting_{}; // unfinished predecessors per node
+    ThreadPool* pool_{nullptr};
+    GraphTracer* tracer_{nullptr};
+    std::vector<int64_t> readyNs_{}; // when each node became runnable (tracing only)
+    NodeResultCache* cache_{nullptr};
+    uint64_t inputHash_{0};
+    std::vector<uint64_t> keys_{};   // memo key per node (valid where keyed_)
+    std::vector<uint8_t> keyed_{};
+    std::atomic<bool> ok_{true};
+    size_t remaining_{0}; // guarded by doneMutex_
+    std::mutex doneMutex_{};
+    std::condition_variable doneCv_{};
+};
+
+} // namespace vv
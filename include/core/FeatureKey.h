@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "utils/Hash.h"
+
+namespace vv {
+
+// Interned DataPacket key. The well-known keys below have fixed compile-time values;
+// any other name gets the next free value from FeatureRegistry the first time it is
+// used. Values are dense, so DataPacket indexes a flat slot table with them.
+// Runtime-registered values depend on registration order and are only meaningful
+// within one process: persist names, not values.
+enum class FeatureKey : uint32_t {
+    F0 = 0,             // "f0"
+    SpectralEnvelope,   // "spectral_envelope"
+    Aperiodicity,       // "aperiodicity"
+    WorldFftSize,       // "world_fft_size"
+    WorldHopSize,       // "world_hop_size"
+    MelCepstrum,        // "mel_cepstrum"
+    BandAperiodicity,   // "band_aperiodicity"
+    MelCepstrumAlpha,   // "mel_cepstrum_alpha"
+    BandAperiodicityHz, // "band_aperiodicity_hz"
+    WellKnownCount
+};
+
+inline constexpr const char* kWellKnownKeyNames[] = {
+    "f0", "spectral_envelope", "aperiodicity", "world_fft_size", "world_hop_size",
+    "mel_cepstrum", "band_aperiodicity", "mel_cepstrum_alpha", "band_aperiodicity_hz",
+};
+static_assert(sizeof(kWellKnownKeyNames) / sizeof(kWellKnownKeyNames[0]) ==
+              static_cast<size_t>(FeatureKey::WellKnownCount), "name every well-known key");
+
+inline constexpr uint32_t keyIndex(FeatureKey k) { return static_cast<uint32_t>(k); }
+
+// Process-wide name <-> FeatureKey table. Thread-safe; names are never unregistered.
+class FeatureRegistry {
+public:
+    static FeatureRegistry& global() {
+        static FeatureRegistry r;
+        return r;
+    }
+
+    // Key for a name, registering it if new.
+    FeatureKey intern(const std::string& name) {
+        {
+            std::shared_lock<std::shared_mutex> lk(m_);
+            auto it = ids_.find(name);
+            if (it != ids_.end()) return it->second;
+        }
+        std::unique_lock<std::shared_mutex> lk(m_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return it->second;
+        return addLocked(name);
+    }
+
+    // Lookup without registering; false if the name was never interned.
+    bool find(const std::string& name, FeatureKey& out) const {
+        std::shared_lock<std::shared_mutex> lk(m_);
+        auto it = ids_.find(name);
+        if (it == ids_.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // References stay valid for the life of the process.
+    const std::string& name(FeatureKey k) const {
+        std::shared_lock<std::shared_mutex> lk(m_);
+        return entries_[keyIndex(k)].name;
+    }
+    // hash::string(name(k)), cached.
+    uint64_t nameHash(FeatureKey k) const {
+        std::shared_lock<std::shared_mutex> lk(m_);
+        return entries_[keyIndex(k)].hash;
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lk(m_);
+        return entries_.size();
+    }
+
+private:
+    FeatureRegistry() {
+        for (const char* n : kWellKnownKeyNames) addLocked(n);
+    }
+
+    FeatureKey addLocked(const std::string& name) {
+        const auto k = static_cast<FeatureKey>(entries_.size());
+        entries_.push_back(Entry{name, hash::string(name)});
+        ids_.emplace(name, k);
+        return k;
+    }
+
+    struct Entry {
+        std::string name;
+        uint64_t hash;
+    };
+
+    mutable std::shared_mutex m_;
+    std::deque<Entry> entries_; // deque: push_back keeps references to names valid
+    std::unordered_map<std::string, FeatureKey> ids_;
+};
+
+} // namespace vv
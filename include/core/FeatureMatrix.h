@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "utils/Hash.h"
+
+namespace vv {
+
+enum class ElementType : uint16_t { Float32 = 1, Float64 = 2 };
+
+inline size_t elementSize(ElementType t) { return t == ElementType::Float64 ? sizeof(double) : sizeof(float); }
+
+template <typename T>
+constexpr ElementType elementTypeOf() {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "FeatureMatrix holds float or double");
+    return std::is_same_v<T, double> ? ElementType::Float64 : ElementType::Float32;
+}
+
+// Strided view of one matrix column.
+template <typename T>
+struct ColumnView {
+    const T* base{nullptr};
+    size_t stride{0}; // elements between consecutive rows
+    size_t size{0};
+    const T& operator[](size_t r) const { return base[r * stride]; }
+};
+
+// Dense row-major [rows x cols] matrix of float or double, e.g. a per-frame spectral
+// envelope. Every row starts on a 64-byte boundary (stride() is cols rounded up to a
+// whole cache line), so rows can be handed to vectorized loops or to APIs that take
+// row pointers (WORLD's double**) without repacking. Copies are deep; DataPacket shares
+// matrices copy-on-write.
+// Storage comes from a std::pmr::memory_resource (default: the process default
+// resource), e.g. a render-scoped Arena; the resource must outlive the matrix. As with
+// std::pmr containers, copies allocate from the default resource, not the source's.
+class FeatureMatrix {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    FeatureMatrix() = default;
+    // Zero-initialized.
+    FeatureMatrix(size_t rows, size_t cols, ElementType type = ElementType::Float64,
+                  std::pmr::memory_resource* resource = nullptr)
+        : rows_(rows), cols_(cols), type_(type)
+    {
+        const size_t perLine = kAlignment / elementSize(type_);
+        stride_ = (cols_ + perLine - 1) / perLine * perLine;
+        const size_t bytes = byteSize();
+        if (bytes == 0) return;
+        if (!resource) resource = std::pmr::get_default_resource();
+        auto* p = static_cast<std::byte*>(resource->allocate(bytes, kAlignment));
+        std::memset(p, 0, bytes);
+        data_ = Storage(p, Release{resource, bytes});
+    }
+
+    FeatureMatrix(const FeatureMatrix& o) : FeatureMatrix(o.rows_, o.cols_, o.type_) {
+        if (o.data_) std::memcpy(data_.get(), o.data_.get(), byteSize());
+    }
+    FeatureMatrix& operator=(const FeatureMatrix& o) {
+        if (this != &o) *this = FeatureMatrix(o);
+        return *this;
+    }
+    FeatureMatrix(FeatureMatrix&&) noexcept = default;
+    FeatureMatrix& operator=(FeatureMatrix&&) noexcept = default;
+
+    // Copy a dense row-major float array into a new matrix of the given element type.
+    static FeatureMatrix fromRowMajor(const float* values, size_t rows, size_t cols,
+                                      ElementType type = ElementType::Float64,
+                                      std::pmr::memory_resource* resource = nullptr) {
+        FeatureMatrix m(rows, cols, type, resource);
+        for (size_t r = 0; r < rows; ++r) {
+            if (type == ElementType::Float64) std::copy(values + r * cols, values + (r + 1) * cols, m.row<double>(r));
+            else std::copy(values + r * cols, values + (r + 1) * cols, m.row<float>(r));
+        }
+        return m;
+    }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+    ElementType type() const { return type_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+    size_t byteSize() const { return rows_ * stride_ * elementSize(type_); }
+
+    template <typename T>
+    bool is() const { return type_ == elementTypeOf<T>(); }
+
+    const void* data() const { return data_.get(); }
+    void* data() { return data_.get(); }
+
+    // Typed row access; nullptr if T does not match type().
+    template <typename T>
+    T* row(size_t r) {
+        return is<T>() && data_ ? reinterpret_cast<T*>(data_.get()) + r * stride_ : nullptr;
+    }
+    template <typename T>
+    const T* row(size_t r) const {
+        return is<T>() && data_ ? reinterpret_cast<const T*>(data_.get()) + r * stride_ : nullptr;
+    }
+
+    template <typename T>
+    ColumnView<T> column(size_t c) const {
+        const T* base = row<T>(0);
+        return base ? ColumnView<T>{base + c, stride_, rows_} : ColumnView<T>{};
+    }
+
+    // One pointer per row, for APIs taking T** / const T* const*. Empty on type mismatch.
+    template <typename T>
+    std::vector<T*> rowPointers() {
+        std::vector<T*> out;
+        if (!is<T>() || !data_) return out;
+        out.resize(rows_);
+        for (size_t r = 0; r < rows_; ++r) out[r] = row<T>(r);
+        return out;
+    }
+    template <typename T>
+    std::vector<const T*> rowPointers() const {
+        std::vector<const T*> out;
+        if (!is<T>() || !data_) return out;
+        out.resize(rows_);
+        for (size_t r = 0; r < rows_; ++r) out[r] = row<T>(r);
+        return out;
+    }
+
+    // Type-agnostic element access (slow path; prefer typed rows in loops).
+    double at(size_t r, size_t c) const {
+        return type_ == ElementType::Float64 ? row<double>(r)[c] : static_cast<double>(row<float>(r)[c]);
+    }
+    void set(size_t r, size_t c, double v) {
+        if (type_ == ElementType::Float64) row<double>(r)[c] = v;
+        else row<float>(r)[c] = static_cast<float>(v);
+    }
+
+    FeatureMatrix converted(ElementType type, std::pmr::memory_resource* resource = nullptr) const {
+        if (type == type_) return *this;
+        FeatureMatrix m(rows_, cols_, type, resource);
+        for (size_t r = 0; r < rows_; ++r) {
+            if (type == ElementType::Float64) std::copy(row<float>(r), row<float>(r) + cols_, m.row<double>(r));
+            else std::transform(row<double>(r), row<double>(r) + cols_, m.row<float>(r),
+                                [](double v) { return static_cast<float>(v); });
+        }
+        return m;
+    }
+
+    // Copy of rows [first, first + count).
+    FeatureMatrix sliceRows(size_t first, size_t count) const {
+        first = std::min(first, rows_);
+        count = std::min(count, rows_ - first);
+        FeatureMatrix m(count, cols_, type_);
+        if (count > 0 && data_) {
+            const size_t rowBytes = stride_ * elementSize(type_);
+            std::memcpy(m.data_.get(), data_.get() + first * rowBytes, count * rowBytes);
+        }
+        return m;
+    }
+
+    // Hash of shape, type and values; row padding is excluded.
+    uint64_t contentHash() const {
+        uint64_t h = hash::combine(hash::value(rows_), hash::value(cols_));
+        h = hash::combine(h, hash::value(type_));
+        const size_t rowBytes = stride_ * elementSize(type_);
+        for (size_t r = 0; r < rows_ && data_; ++r) {
+            h = hash::combine(h, hash::bytes(data_.get() + r * rowBytes, cols_ * elementSize(type_)));
+        }
+        return h;
+    }
+
+private:
+    struct Release {
+        std::pmr::memory_resource* resource;
+        size_t bytes;
+        void operator()(std::byte* p) const { if (p) resource->deallocate(p, bytes, kAlignment); }
+    };
+    using Storage = std::unique_ptr<std::byte[], Release>;
+
+    size_t rows_{0};
+    size_t cols_{0};
+    size_t stride_{0};
+    ElementType type_{ElementType::Float64};
+    Storage data_{nullptr, Release{nullptr, 0}};
+};
+
+} // namespace vv
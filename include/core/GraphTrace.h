@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/DataPacket.h"
+
+namespace vv {
+
+// One timed node phase recorded by ComputationGraph while a GraphTracer is enabled.
+struct TraceEvent {
+    enum class Phase : uint8_t { Initialize, Process };
+
+    std::string node;          // node id
+    Phase phase{Phase::Process};
+    size_t item{0};            // block/packet index (0 for single runs)
+    unsigned thread{0};        // pool worker index (pool size = calling thread)
+    int64_t readyNs{0};        // when the node became runnable
+    int64_t startNs{0};
+    int64_t endNs{0};
+    // Packet sizes: samples, and feature values (vector features plus matrix cells).
+    uint64_t inSamples{0}, inFeatureValues{0};
+    uint64_t outSamples{0}, outFeatureValues{0};
+};
+
+// Per-node aggregate over all recorded events.
+struct TraceNodeSummary {
+    std::string node;
+    size_t calls{0};
+    double initializeMs{0.0};
+    double processMs{0.0};
+    double maxProcessMs{0.0};
+    double queueWaitMs{0.0};
+    uint64_t inFeatureValues{0};  // summed over process calls
+    uint64_t outFeatureValues{0};
+};
+
+// Opt-in instrumentation for graph execution. While disabled the graph checks the flag
+// once per run and then takes the untraced path, so a tracer can stay attached in
+// production builds and be switched on when a render is slow. Recording takes a lock;
+// it is meant for diagnosis.
+class GraphTracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit GraphTracer(bool enabled = true) : enabled_(enabled) {}
+
+    void setEnabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Nanoseconds since the tracer was created.
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count();
+    }
+
+    static void measure(const DataPacket* p, uint64_t& samples, uint64_t& featureValues) {
+        samples = 0; featureValues = 0;
+        if (!p) return;
+        samples = p->samples().size();
+        p->forEachFeature([&](const std::string&, const std::vector<float>& v) { featureValues += v.size(); });
+        p->forEachMatrix([&](const std::string&, const FeatureMatrix& m) { featureValues += m.rows() * m.cols(); });
+    }
+
+    void record(TraceEvent ev) {
+        std::lock_guard<std::mutex> lk(m_);
+        events_.push_back(std::move(ev));
+    }
+
+    std::vector<TraceEvent> events() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return events_;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lk(m_);
+        events_.clear();
+    }
+
+    // Aggregate per node, sorted by total process time (descending).
+    std::vector<TraceNodeSummary> summary() const {
+        std::lock_guard<std::mutex> lk(m_);
+        std::vector<TraceNodeSummary> out;
+        std::unordered_map<std::string, size_t> index;
+        for (const auto& e : events_) {
+            auto it = index.find(e.node);
+            if (it == index.end()) {
+                it = index.emplace(e.node, out.size()).first;
+                out.push_back(TraceNodeSummary{});
+                out.back().node = e.node;
+            }
+            auto& s = out[it->second];
+            const double ms = static_cast<double>(e.endNs - e.startNs) * 1e-6;
+            if (e.phase == TraceEvent::Phase::Initialize) {
+                s.initializeMs += ms;
+            } else {
+                ++s.calls;
+                s.processMs += ms;
+                s.maxProcessMs = std::max(s.maxProcessMs, ms);
+                s.queueWaitMs += static_cast<double>(std::max<int64_t>(0, e.startNs - e.readyNs)) * 1e-6;
+                s.inFeatureValues += e.inFeatureValues;
+                s.outFeatureValues += e.outFeatureValues;
+            }
+        }
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.processMs > b.processMs; });
+        return out;
+    }
+
+    // Human-readable table of summary().
+    std::string formatSummary() const {
+        std::ostringstream os;
+        os.setf(std::ios::fixed); os.precision(3);
+        os << std::left << std::setw(24) << "node" << std::right << std::setw(8) << "calls"
+           << std::setw(12) << "init ms" << std::setw(13) << "process ms" << std::setw(12) << "max ms"
+           << std::setw(12) << "queue ms" << std::setw(14) << "in values" << std::setw(14) << "out values" << "\n";
+        for (const auto& s : summary()) {
+            os << std::left << std::setw(24) << s.node.substr(0, 23) << std::right << std::setw(8) << s.calls
+               << std::setw(12) << s.initializeMs << std::setw(13) << s.processMs << std::setw(12)
+               << s.maxProcessMs << std::setw(12) << s.queueWaitMs << std::setw(14) << s.inFeatureValues
+               << std::setw(14) << s.outFeatureValues << "\n";
+        }
+        return os.str();
+    }
+
+    // Chrome trace-event JSON (load in chrome://tracing or Perfetto).
+    bool writeChromeTrace(const std::string& path) const {
+        std::ofstream os(path);
+        if (!os) return false;
+        os << toChromeTrace();
+        return static_cast<bool>(os);
+    }
+
+    std::string toChromeTrace() const {
+        std::lock_guard<std::mutex> lk(m_);
+        std::ostringstream os;
+        os.setf(std::ios::fixed); os.precision(3);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& e : events_) {
+            if (!first) os << ",";
+            first = false;
+            const bool init = e.phase == TraceEvent::Phase::Initialize;
+            os << "\n{\"name\":\"" << escape(e.node) << (init ? ".initialize" : "")
+               << "\",\"cat\":\"" << (init ? "initialize" : "process")
+               << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+               << ",\"ts\":" << static_cast<double>(e.startNs) * 1e-3
+               << ",\"dur\":" << static_cast<double>(e.endNs - e.startNs) * 1e-3
+               << ",\"args\":{\"item\":" << e.item
+               << ",\"queue_wait_us\":" << static_cast<double>(std::max<int64_t>(0, e.startNs - e.readyNs)) * 1e-3
+               << ",\"in_samples\":" << e.inSamples << ",\"in_feature_values\":" << e.inFeatureValues
+               << ",\"out_samples\":" << e.outSamples << ",\"out_feature_values\":" << e.outFeatureValues
+               << "}}";
+        }
+        os << "\n]}\n";
+        return os.str();
+    }
+
+private:
+    static std::string escape(const std::string& s) {
+        std::string out;
+        out.reserve(s.size());
+        for (char c : s) {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            if (static_cast<unsigned char>(c) >= 0x20) out.push_back(c);
+        }
+        return out;
+    }
+
+    std::atomic<bool> enabled_;
+    Clock::time_point epoch_{Clock::now()};
+    mutable std::mutex m_;
+    std::vector<TraceEvent> events_;
+};
+
+} // namespace vv
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -12,15 +13,32 @@ struct MemoryBlock {
     size_t size{0};
 };
 
+// Read-only view of a whole file, memory-mapped where the platform supports it.
+// The mapping is released when the last copy of `owner` goes away.
+struct MappedFile {
+    const std::byte* data{nullptr};
+    size_t size{0};
+    std::shared_ptr<const void> owner{};
+    explicit operator bool() const { return data != nullptr; }
+};
+
 class IPlatformIO {
 public:
     virtual ~IPlatformIO() = default;
 
     virtual std::vector<std::byte> readFile(const std::string& path) = 0;
     virtual bool writeFile(const std::string& path, const std::vector<std::byte>& data) = 0;
+    // Map a file for zero-copy reading. Returns an empty MappedFile on failure.
+    virtual MappedFile mapFile(const std::string& path) = 0;
 
     virtual MemoryBlock allocateMemory(size_t bytes) = 0;
     virtual void deallocateMemory(MemoryBlock& block) = 0;
+
+    // Page-granular upstream for Arena / SizeClassPool (see core/MemoryResource.h).
+    // With hugePages, blocks are rounded to 2 MiB and backed by huge pages where the OS
+    // allows it, else by ordinary pages. Owned by this object; it must outlive every
+    // allocation made from it. Alignments above the page size are not supported.
+    virtual std::pmr::memory_resource* pageResource(bool hugePages = false) = 0;
 };
 
 // Factory (simple)
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 namespace vv {
 
@@ -20,6 +21,9 @@ public:
     // In-place processing on interleaved buffer for the given number of frames.
     // Channels match the value passed to prepare().
     virtual void process(float* interleaved, size_t frames) = 0;
+
+    // Independent copy with the same parameters and cleared state, or null if unsupported.
+    virtual std::shared_ptr<IPostFilter> clone() const { return nullptr; }
 };
 
 } // namespace vv
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,6 +10,14 @@ namespace vv {
 
 class DataPacket; // forward decl
 
+// Position of a block within a stream (see ComputationGraph::runStreaming()).
+struct StreamBlock {
+    size_t index{0};      // 0-based block number
+    size_t firstFrame{0}; // first analysis frame covered by the block
+    size_t frames{0};     // frames in this block
+    bool last{false};     // final block of the stream
+};
+
 // Base abstract node for synthesis/processing graph
 class ISynthesisNode {
 public:
@@ -19,6 +29,26 @@ public:
     // Process single packet input -> output
     virtual std::shared_ptr<DataPacket> process(const std::shared_ptr<const DataPacket>& input) = 0;
 
+    // Streaming (optional). beginStream() is called once before the first block;
+    // processBlock() is then called for consecutive blocks in order, never concurrently
+    // for the same node, so implementations may carry state (phase, filter history)
+    // across blocks. The default treats each block as an independent packet.
+    virtual void beginStream() {}
+    virtual std::shared_ptr<DataPacket> processBlock(const std::shared_ptr<const DataPacket>& block,
+                                                     const StreamBlock& /*info*/) {
+        return process(block);
+    }
+
+    // Return an independent copy with the same parameters and fresh processing state, or
+    // null if the node cannot be replicated. Batch execution runs one replica per
+    // in-flight packet; non-clonable nodes are serialized across packets instead.
+    virtual std::shared_ptr<ISynthesisNode> clone() const { return nullptr; }
+
+    // Memoization (optional). Return true and a hash of every parameter that affects the
+    // output to let ComputationGraph reuse a previous result for an identical input.
+    // Only deterministic nodes without cross-call state should opt in.
+    virtual bool parameterHash(uint64_t& /*hash*/) const { return false; }
+
     // Introspection
     virtual std::vector<std::string> getInputs() const = 0;
     virtual std::vector<std::string> getOutputs() const = 0;
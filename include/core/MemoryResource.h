@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace vv {
+
+// Allocators for render-scoped data (feature matrices, WORLD scratch buffers).
+// Both derive from std::pmr::memory_resource, so they plug into FeatureMatrix and into
+// std::pmr containers alike. Back them with IPlatformIO::pageResource() to get
+// page-aligned (optionally huge-page) chunks instead of going through malloc.
+
+// Monotonic arena: allocation is a pointer bump inside large upstream chunks and
+// deallocate() is a no-op. reset() rewinds the arena in O(chunks) and keeps the chunks
+// for the next render; release() hands them back upstream. Everything allocated from
+// the arena must be dead before either call. Thread-safe.
+class Arena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kChunkAlignment = 64;
+
+    explicit Arena(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource(),
+                   size_t chunkBytes = size_t(4) << 20)
+        : upstream_(upstream ? upstream : std::pmr::new_delete_resource()),
+          chunkBytes_(std::max<size_t>(chunkBytes, 4096)) {}
+    ~Arena() override { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void reset() {
+        std::lock_guard<std::mutex> lk(m_);
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lk(m_);
+        for (const auto& c : chunks_) upstream_->deallocate(c.base, c.size, kChunkAlignment);
+        chunks_.clear();
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    // Bytes handed out since the last reset (including alignment padding).
+    size_t bytesUsed() const { std::lock_guard<std::mutex> lk(m_); return used_; }
+    // Bytes held from upstream.
+    size_t bytesReserved() const {
+        std::lock_guard<std::mutex> lk(m_);
+        size_t n = 0;
+        for (const auto& c : chunks_) n += c.size;
+        return n;
+    }
+    size_t chunkCount() const { std::lock_guard<std::mutex> lk(m_); return chunks_.size(); }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        if (bytes == 0) bytes = 1;
+        std::lock_guard<std::mutex> lk(m_);
+        if (void* p = bumpLocked(bytes, align)) return p;
+        // Move to the next retained chunk that fits, or insert a fresh one after current_.
+        const size_t need = bytes + (align > kChunkAlignment ? align : 0);
+        size_t next = chunks_.empty() ? 0 : current_ + 1;
+        size_t fit = next;
+        while (fit < chunks_.size() && chunks_[fit].size < need) ++fit;
+        if (fit < chunks_.size()) {
+            std::swap(chunks_[next], chunks_[fit]);
+        } else {
+            const size_t size = std::max(chunkBytes_, (need + 4095) / 4096 * 4096);
+            auto* base = static_cast<std::byte*>(upstream_->allocate(size, kChunkAlignment));
+            chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(next), Chunk{base, size});
+        }
+        current_ = next;
+        offset_ = 0;
+        return bumpLocked(bytes, align);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    struct Chunk {
+        std::byte* base;
+        size_t size;
+    };
+
+    void* bumpLocked(size_t bytes, size_t align) {
+        if (chunks_.empty()) return nullptr;
+        const Chunk& c = chunks_[current_];
+        const auto addr = reinterpret_cast<uintptr_t>(c.base) + offset_;
+        const uintptr_t aligned = (addr + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+        const size_t start = static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(c.base));
+        if (start > c.size || c.size - start < bytes) return nullptr;
+        used_ += start + bytes - offset_;
+        offset_ = start + bytes;
+        return c.base + start;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    size_t chunkBytes_;
+    mutable std::mutex m_;
+    std::vector<Chunk> chunks_;
+    size_t current_{0};
+    size_t offset_{0};
+    size_t used_{0};
+};
+
+// Size-class pool: requests up to kMaxPooled bytes are rounded up to a power of two
+// (64 B .. 256 KiB) and served from per-class free lists carved out of upstream slabs,
+// so steady-state allocate/deallocate pairs never reach the upstream allocator.
+// Larger requests go straight upstream. Every pooled block is 64-byte aligned.
+// release() returns all slabs (outstanding blocks must be dead). Thread-safe.
+class SizeClassPool : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kMinClass = 64;
+    static constexpr size_t kMaxPooled = size_t(256) << 10;
+    static constexpr size_t kClassCount = 13; // 2^6 .. 2^18
+
+    explicit SizeClassPool(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource(),
+                           size_t slabBytes = size_t(1) << 20)
+        : upstream_(upstream ? upstream : std::pmr::new_delete_resource()),
+          slabBytes_(std::max(slabBytes, kMaxPooled)) {}
+    ~SizeClassPool() override { release(); }
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    void release() {
+        std::lock_guard<std::mutex> lk(m_);
+        for (const auto& s : slabs_) upstream_->deallocate(s.base, s.size, kMinClass);
+        slabs_.clear();
+        free_.fill(nullptr);
+    }
+
+    // Requests served from a free list vs. ones that needed upstream memory.
+    size_t reused() const { std::lock_guard<std::mutex> lk(m_); return reused_; }
+    size_t upstreamAllocations() const { std::lock_guard<std::mutex> lk(m_); return upstreamAllocs_; }
+
+    static size_t classIndex(size_t bytes) {
+        size_t size = kMinClass, idx = 0;
+        while (size < bytes) { size <<= 1; ++idx; }
+        return idx;
+    }
+    static size_t classSize(size_t idx) { return kMinClass << idx; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        if (bytes > kMaxPooled || align > kMinClass) {
+            std::lock_guard<std::mutex> lk(m_);
+            ++upstreamAllocs_;
+            return upstream_->allocate(bytes, std::max(align, kMinClass));
+        }
+        const size_t idx = classIndex(std::max<size_t>(bytes, 1));
+        std::lock_guard<std::mutex> lk(m_);
+        if (FreeBlock* b = free_[idx]) {
+            free_[idx] = b->next;
+            ++reused_;
+            return b;
+        }
+        // Carve a new slab for this class; all blocks but the first go onto the free list.
+        const size_t size = classSize(idx);
+        auto* base = static_cast<std::byte*>(upstream_->allocate(slabBytes_, kMinClass));
+        slabs_.push_back(Slab{base, slabBytes_});
+        ++upstreamAllocs_;
+        for (size_t off = slabBytes_ / size * size; off > size; ) {
+            off -= size;
+            auto* b = reinterpret_cast<FreeBlock*>(base + off);
+            b->next = free_[idx];
+            free_[idx] = b;
+        }
+        return base;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        if (!p) return;
+        if (bytes > kMaxPooled || align > kMinClass) {
+            upstream_->deallocate(p, bytes, std::max(align, kMinClass));
+            return;
+        }
+        const size_t idx = classIndex(std::max<size_t>(bytes, 1));
+        std::lock_guard<std::mutex> lk(m_);
+        auto* b = static_cast<FreeBlock*>(p);
+        b->next = free_[idx];
+        free_[idx] = b;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    struct FreeBlock { FreeBlock* next; };
+    struct Slab {
+        std::byte* base;
+        size_t size;
+    };
+
+    std::pmr::memory_resource* upstream_;
+    size_t slabBytes_;
+    mutable std::mutex m_;
+    std::array<FreeBlock*, kClassCount> free_{};
+    std::vector<Slab> slabs_;
+    size_t reused_{0};
+    size_t upstreamAllocs_{0};
+};
+
+} // namespace vv
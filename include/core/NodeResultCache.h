@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "core/DataPacket.h"
+
+namespace vv {
+
+// Content-addressed memo of node outputs for incremental graph re-execution.
+// Keys combine the node id, the node's parameterHash() and the hash of its input packet;
+// ComputationGraph computes them (see ComputationGraph::setResultCache()). Entries are
+// evicted least-recently-used once their summed DataPacket::byteSize() exceeds the budget.
+// Entries are immutable: insert() keeps its own copy of the packet and find() hands out
+// a const one, so nothing a caller does to a graph output reaches later hits. Copies are
+// cheap, DataPacket being copy-on-write.
+// Thread-safe.
+class NodeResultCache {
+public:
+    explicit NodeResultCache(size_t budgetBytes = size_t(256) << 20) : budget_(budgetBytes) {}
+
+    std::shared_ptr<const DataPacket> find(uint64_t key) {
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = index_.find(key);
+        if (it == index_.end()) { ++misses_; return nullptr; }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        ++hits_;
+        return it->second->value;
+    }
+
+    void insert(uint64_t key, const DataPacket& packet) {
+        auto value = std::make_shared<const DataPacket>(packet);
+        const size_t bytes = value->byteSize();
+        std::lock_guard<std::mutex> lk(m_);
+        if (bytes > budget_) return; // would evict everything and still not fit
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            bytes_ -= it->second->bytes;
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.push_front(Entry{key, std::move(value), bytes});
+        index_[key] = lru_.begin();
+        bytes_ += bytes;
+        evictToBudget();
+    }
+
+    void setBudget(size_t budgetBytes) {
+        std::lock_guard<std::mutex> lk(m_);
+        budget_ = budgetBytes;
+        evictToBudget();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lk(m_);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    size_t budget() const { std::lock_guard<std::mutex> lk(m_); return budget_; }
+    size_t bytes() const { std::lock_guard<std::mutex> lk(m_); return bytes_; }
+    size_t entries() const { std::lock_guard<std::mutex> lk(m_); return index_.size(); }
+    size_t hits() const { std::lock_guard<std::mutex> lk(m_); return hits_; }
+    size_t misses() const { std::lock_guard<std::mutex> lk(m_); return misses_; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::shared_ptr<const DataPacket> value;
+        size_t bytes;
+    };
+
+    void evictToBudget() {
+        while (bytes_ > budget_ && !lru_.empty()) {
+            bytes_ -= lru_.back().bytes;
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    mutable std::mutex m_;
+    size_t budget_;
+    size_t bytes_{0};
+    size_t hits_{0};
+    size_t misses_{0};
+    std::list<Entry> lru_;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+} // namespace vv
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/IPlatformIO.h"
+#include "core/PacketFormat.h"
+#include "utils/Hash.h"
+
+namespace vv {
+
+// Persistent DataPacket cache: one packetio file per 64-bit key in a directory, shared
+// by any number of threads and processes.
+// - Writes go to a uniquely named temporary file that is then renamed over the final
+//   name, so readers only ever see complete files. Files are never modified in place,
+//   so a reader's mapping stays valid even if another process replaces or evicts it.
+// - Files that fail validation (truncated, foreign, older format) count as misses and
+//   are removed.
+// - A hit refreshes the file's modification time; when the directory grows past the
+//   budget, the least recently used files are evicted. The size is tracked per process
+//   and re-measured on every trim, so concurrent writers can overshoot the budget
+//   briefly but never indefinitely.
+class PacketDiskCache {
+public:
+    explicit PacketDiskCache(std::string dir, uint64_t budgetBytes = uint64_t(1) << 30,
+                             std::shared_ptr<IPlatformIO> io = nullptr)
+        : dir_(std::move(dir)), budget_(budgetBytes), io_(io ? std::move(io) : std::shared_ptr<IPlatformIO>(makePlatformIO()))
+    {
+        seed_ = (uint64_t(std::random_device{}()) << 32) ^ std::random_device{}();
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        ok_ = std::filesystem::is_directory(dir_, ec);
+        if (ok_) bytes_ = scanBytes();
+    }
+
+    PacketDiskCache(const PacketDiskCache&) = delete;
+    PacketDiskCache& operator=(const PacketDiskCache&) = delete;
+
+    // False if the directory could not be created.
+    bool good() const { return ok_; }
+    const std::string& directory() const { return dir_; }
+
+    bool load(uint64_t key, DataPacket& out) {
+        if (!ok_) return false;
+        const std::string path = pathFor(key);
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) { misses_.fetch_add(1, std::memory_order_relaxed); return false; }
+        // A file that cannot be opened or mapped (I/O error, or another process renaming a
+        // fresh entry into place) is only a miss; only one that fails the format's header
+        // and size checks is removed (corrupt or from an incompatible version).
+        const MappedFile file = io_->mapFile(path);
+        if (!file) { misses_.fetch_add(1, std::memory_order_relaxed); return false; }
+        packetio::PacketView view;
+        if (!view.open(file.data, file.size)) {
+            std::filesystem::remove(path, ec);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        out = view.toPacket();
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool store(uint64_t key, const DataPacket& pkt) {
+        if (!ok_) return false;
+        const std::string path = pathFor(key);
+        const std::string tmp = path + "." + uniqueSuffix() + ".tmp";
+        const auto bytes = packetio::encode(pkt);
+        std::error_code ec;
+        if (!io_->writeFile(tmp, bytes)) { std::filesystem::remove(tmp, ec); return false; }
+        std::filesystem::rename(tmp, path, ec); // atomic replace on POSIX
+        if (ec) { std::filesystem::remove(tmp, ec); return false; }
+        stores_.fetch_add(1, std::memory_order_relaxed);
+        if (bytes_.fetch_add(bytes.size()) + bytes.size() > budget_) trim();
+        return true;
+    }
+
+    // Evict least recently used files until the directory fits the budget; also removes
+    // temporaries abandoned by crashed writers.
+    void trim() {
+        if (!ok_) return;
+        struct File {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            uint64_t size;
+        };
+        std::vector<File> files;
+        uint64_t total = 0;
+        const auto staleBefore = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+        std::error_code ec;
+        for (auto it = std::filesystem::directory_iterator(dir_, ec); !ec && it != std::filesystem::directory_iterator();
+             it.increment(ec)) {
+            std::error_code fec;
+            const auto& p = it->path();
+            const auto time = std::filesystem::last_write_time(p, fec);
+            const uint64_t size = fec ? 0 : std::filesystem::file_size(p, fec);
+            if (fec) continue; // removed by someone else meanwhile
+            if (p.extension() == ".tmp") {
+                if (time < staleBefore) std::filesystem::remove(p, fec);
+                continue;
+            }
+            if (p.extension() != kExtension) continue;
+            files.push_back(File{p, time, size});
+            total += size;
+        }
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+        for (const auto& f : files) {
+            if (total <= budget_) break;
+            std::error_code rec;
+            std::filesystem::remove(f.path, rec);
+            total -= f.size;
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        bytes_.store(total);
+    }
+
+    uint64_t budget() const { return budget_; }
+    uint64_t bytes() const { return bytes_.load(); }
+    size_t hits() const { return hits_.load(); }
+    size_t misses() const { return misses_.load(); }
+    size_t stores() const { return stores_.load(); }
+    size_t evictions() const { return evictions_.load(); }
+
+private:
+    static constexpr const char* kExtension = ".vvpk";
+
+    std::string pathFor(uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return dir_ + "/" + name + kExtension;
+    }
+
+    // Distinct across threads and processes sharing the directory.
+    std::string uniqueSuffix() {
+        uint64_t h = hash::combine(hash::value(seed_), hash::value(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+        h = hash::combine(h, hash::value(std::chrono::steady_clock::now().time_since_epoch().count()));
+        h = hash::combine(h, hash::value(std::chrono::system_clock::now().time_since_epoch().count()));
+        h = hash::combine(h, hash::value(reinterpret_cast<uintptr_t>(this)));
+        h = hash::combine(h, hash::value(counter_.fetch_add(1, std::memory_order_relaxed)));
+        char s[20];
+        std::snprintf(s, sizeof(s), "%016llx", static_cast<unsigned long long>(h));
+        return s;
+    }
+
+    uint64_t scanBytes() const {
+        uint64_t total = 0;
+        std::error_code ec;
+        for (auto it = std::filesystem::directory_iterator(dir_, ec); !ec && it != std::filesystem::directory_iterator();
+             it.increment(ec)) {
+            std::error_code fec;
+            if (it->path().extension() != kExtension) continue;
+            const uint64_t size = std::filesystem::file_size(it->path(), fec);
+            if (!fec) total += size;
+        }
+        return total;
+    }
+
+    std::string dir_;
+    uint64_t budget_;
+    std::shared_ptr<IPlatformIO> io_;
+    bool ok_{false};
+    uint64_t seed_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> counter_{0};
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> stores_{0};
+    std::atomic<size_t> evictions_{0};
+};
+
+} // namespace vv
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/FeatureMatrix.h"
+#include "core/IPlatformIO.h"
+
+namespace vv::packetio {
+
+// Versioned binary DataPacket format ("VVPK"), little-endian, lossless.
+//
+//   [0, 64)           header (see below)
+//   samplesOffset     float32[sampleCount]                     (64-byte aligned)
+//   directoryOffset   entryCount x { Entry (32 bytes), key bytes padded to 8 }
+//   payloads          one block per feature / matrix           (64-byte aligned)
+//
+// Header: magic "VVPK", u16 version, u16 headerSize, u32 sampleRate, u16 channels,
+// u16 bitDepth, u32 entryCount, u32 reserved, u64 sampleCount, u64 samplesOffset,
+// u64 directoryOffset, u64 totalSize, zero padding.
+// Entry: u16 kind, u16 elementType, u32 keyLength, u64 a, u64 b, u32 rows, u32 cols.
+//   FloatVector: a = payload offset, b = element count.
+//   Scalar:      a = IEEE-754 bits of the double value, b = 0.
+//   Matrix:      a = payload offset, b = row stride in elements, rows x cols, elementType
+//                is ElementType; rows are stored with FeatureMatrix's padded stride.
+// Because payloads are aligned and stored in host order on little-endian machines,
+// PacketView can expose them straight out of a buffer or a memory-mapped file.
+// Version 2 added Matrix entries; version 1 files are still accepted.
+
+constexpr char kMagic[4] = {'V', 'V', 'P', 'K'};
+constexpr uint16_t kVersion = 2;
+constexpr size_t kHeaderSize = 64;
+constexpr size_t kEntrySize = 32;
+constexpr size_t kAlign = 64;
+
+enum class EntryKind : uint16_t { FloatVector = 1, Scalar = 2, Matrix = 3 };
+
+// Non-owning view of a float payload.
+struct FloatSpan {
+    const float* data{nullptr};
+    size_t size{0};
+    const float* begin() const { return data; }
+    const float* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    float operator[](size_t i) const { return data[i]; }
+};
+
+// Non-owning view of a matrix payload, laid out like FeatureMatrix.
+struct MatrixView {
+    const void* data{nullptr};
+    size_t rows{0};
+    size_t cols{0};
+    size_t stride{0};
+    ElementType type{ElementType::Float64};
+    bool empty() const { return data == nullptr || rows == 0 || cols == 0; }
+    // nullptr if T does not match type
+    template <typename T>
+    const T* row(size_t r) const {
+        return type == elementTypeOf<T>() && data ? static_cast<const T*>(data) + r * stride : nullptr;
+    }
+    FeatureMatrix toMatrix() const {
+        FeatureMatrix m(rows, cols, type);
+        if (empty()) return m;
+        const size_t elem = elementSize(type);
+        for (size_t r = 0; r < rows; ++r) {
+            std::memcpy(static_cast<std::byte*>(m.data()) + r * m.stride() * elem,
+                        static_cast<const std::byte*>(data) + r * stride * elem, cols * elem);
+        }
+        return m;
+    }
+};
+
+namespace detail {
+inline bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char b;
+    std::memcpy(&b, &probe, 1);
+    return b == 1;
+}
+template <typename T>
+inline void put(std::vector<std::byte>& buf, size_t at, T v) {
+    unsigned char raw[sizeof(T)];
+    std::memcpy(raw, &v, sizeof(T));
+    if (!hostIsLittleEndian()) for (size_t i = 0; i < sizeof(T) / 2; ++i) std::swap(raw[i], raw[sizeof(T) - 1 - i]);
+    std::memcpy(buf.data() + at, raw, sizeof(T));
+}
+template <typename T>
+inline T get(const std::byte* p) {
+    unsigned char raw[sizeof(T)];
+    std::memcpy(raw, p, sizeof(T));
+    if (!hostIsLittleEndian()) for (size_t i = 0; i < sizeof(T) / 2; ++i) std::swap(raw[i], raw[sizeof(T) - 1 - i]);
+    T v;
+    std::memcpy(&v, raw, sizeof(T));
+    return v;
+}
+inline size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+} // namespace detail
+
+// Serialize samples, all features, matrices and scalars.
+inline std::vector<std::byte> encode(const DataPacket& pkt) {
+    using detail::alignUp;
+    using detail::put;
+    struct Pending {
+        EntryKind kind;
+        const std::string* key;
+        const std::vector<float>* vec;
+        const FeatureMatrix* mat;
+        double scalar;
+        size_t payloadBytes;
+    };
+    std::vector<Pending> entries;
+    pkt.forEachFeature([&](const std::string& k, const std::vector<float>& v) {
+        entries.push_back({EntryKind::FloatVector, &k, &v, nullptr, 0.0, v.size() * sizeof(float)});
+    });
+    pkt.forEachMatrix([&](const std::string& k, const FeatureMatrix& m) {
+        entries.push_back({EntryKind::Matrix, &k, nullptr, &m, 0.0, m.byteSize()});
+    });
+    pkt.forEachScalar([&](const std::string& k, double v) {
+        entries.push_back({EntryKind::Scalar, &k, nullptr, nullptr, v, 0});
+    });
+
+    const auto& x = pkt.samples();
+    const size_t samplesOffset = kHeaderSize;
+    const size_t directoryOffset = alignUp(samplesOffset + x.size() * sizeof(float), kAlign);
+    size_t cursor = directoryOffset;
+    for (const auto& e : entries) cursor += kEntrySize + alignUp(e.key->size(), 8);
+    std::vector<size_t> payloadOffsets(entries.size(), 0);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].kind == EntryKind::Scalar) continue;
+        cursor = alignUp(cursor, kAlign);
+        payloadOffsets[i] = cursor;
+        cursor += entries[i].payloadBytes;
+    }
+    const size_t total = alignUp(cursor, 8);
+
+    std::vector<std::byte> buf(total, std::byte{0});
+    std::memcpy(buf.data(), kMagic, 4);
+    put<uint16_t>(buf, 4, kVersion);
+    put<uint16_t>(buf, 6, static_cast<uint16_t>(kHeaderSize));
+    put<uint32_t>(buf, 8, pkt.sampleRate());
+    put<uint16_t>(buf, 12, pkt.channels());
+    put<uint16_t>(buf, 14, pkt.bitDepth());
+    put<uint32_t>(buf, 16, static_cast<uint32_t>(entries.size()));
+    put<uint64_t>(buf, 24, static_cast<uint64_t>(x.size()));
+    put<uint64_t>(buf, 32, static_cast<uint64_t>(samplesOffset));
+    put<uint64_t>(buf, 40, static_cast<uint64_t>(directoryOffset));
+    put<uint64_t>(buf, 48, static_cast<uint64_t>(total));
+
+    auto putArray = [&](size_t at, const auto* v, size_t n) {
+        using T = std::remove_cv_t<std::remove_pointer_t<decltype(v)>>;
+        if (n == 0) return;
+        if (detail::hostIsLittleEndian()) std::memcpy(buf.data() + at, v, n * sizeof(T));
+        else for (size_t i = 0; i < n; ++i) put<T>(buf, at + i * sizeof(T), v[i]);
+    };
+    putArray(samplesOffset, x.data(), x.size());
+
+    size_t dir = directoryOffset;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& e = entries[i];
+        put<uint16_t>(buf, dir, static_cast<uint16_t>(e.kind));
+        put<uint32_t>(buf, dir + 4, static_cast<uint32_t>(e.key->size()));
+        if (e.kind == EntryKind::Scalar) {
+            put<double>(buf, dir + 8, e.scalar);
+        } else if (e.kind == EntryKind::FloatVector) {
+            put<uint16_t>(buf, dir + 2, static_cast<uint16_t>(ElementType::Float32));
+            put<uint64_t>(buf, dir + 8, static_cast<uint64_t>(payloadOffsets[i]));
+            put<uint64_t>(buf, dir + 16, static_cast<uint64_t>(e.vec->size()));
+            putArray(payloadOffsets[i], e.vec->data(), e.vec->size());
+        } else {
+            const FeatureMatrix& m = *e.mat;
+            put<uint16_t>(buf, dir + 2, static_cast<uint16_t>(m.type()));
+            put<uint64_t>(buf, dir + 8, static_cast<uint64_t>(payloadOffsets[i]));
+            put<uint64_t>(buf, dir + 16, static_cast<uint64_t>(m.stride()));
+            put<uint32_t>(buf, dir + 24, static_cast<uint32_t>(m.rows()));
+            put<uint32_t>(buf, dir + 28, static_cast<uint32_t>(m.cols()));
+            if (m.type() == ElementType::Float64) putArray(payloadOffsets[i], m.row<double>(0), m.rows() * m.stride());
+            else putArray(payloadOffsets[i], m.row<float>(0), m.rows() * m.stride());
+        }
+        std::memcpy(buf.data() + dir + kEntrySize, e.key->data(), e.key->size());
+        dir += kEntrySize + alignUp(e.key->size(), 8);
+    }
+    return buf;
+}
+
+// Zero-copy reader over an encoded buffer. The buffer must outlive the view.
+// open() validates every offset against the buffer size; payload access is then
+// pointer arithmetic only. Requires a little-endian host for payload views.
+class PacketView {
+public:
+    struct Entry {
+        std::string key;
+        EntryKind kind{EntryKind::FloatVector};
+        FloatSpan values{};
+        MatrixView matrix{};
+        double scalar{0.0};
+    };
+
+    bool open(const std::byte* data, size_t size) {
+        entries_.clear();
+        data_ = nullptr;
+        if (!data || size < kHeaderSize || std::memcmp(data, kMagic, 4) != 0) return false;
+        if (!detail::hostIsLittleEndian()) return false;
+        using detail::get;
+        const uint16_t version = get<uint16_t>(data + 4);
+        if (version < 1 || version > kVersion) return false;
+        const size_t headerSize = get<uint16_t>(data + 6);
+        sampleRate_ = get<uint32_t>(data + 8);
+        channels_ = get<uint16_t>(data + 12);
+        bitDepth_ = get<uint16_t>(data + 14);
+        const uint32_t entryCount = get<uint32_t>(data + 16);
+        const uint64_t sampleCount = get<uint64_t>(data + 24);
+        const uint64_t samplesOffset = get<uint64_t>(data + 32);
+        const uint64_t directoryOffset = get<uint64_t>(data + 40);
+        const uint64_t total = get<uint64_t>(data + 48);
+        if (headerSize < kHeaderSize || total > size) return false;
+        if (!inBounds(samplesOffset, sampleCount, sizeof(float), total) || samplesOffset % alignof(float)) return false;
+        samples_ = FloatSpan{reinterpret_cast<const float*>(data + samplesOffset), static_cast<size_t>(sampleCount)};
+
+        size_t dir = static_cast<size_t>(directoryOffset);
+        entries_.reserve(entryCount);
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            if (dir > total || total - dir < kEntrySize) return false;
+            Entry e;
+            e.kind = static_cast<EntryKind>(get<uint16_t>(data + dir));
+            const uint32_t keyLen = get<uint32_t>(data + dir + 4);
+            if (total - dir - kEntrySize < keyLen) return false;
+            e.key.assign(reinterpret_cast<const char*>(data + dir + kEntrySize), keyLen);
+            if (e.kind == EntryKind::Scalar) {
+                e.scalar = get<double>(data + dir + 8);
+            } else if (e.kind == EntryKind::FloatVector) {
+                const uint64_t off = get<uint64_t>(data + dir + 8);
+                const uint64_t count = get<uint64_t>(data + dir + 16);
+                if (!inBounds(off, count, sizeof(float), total) || off % alignof(float)) return false;
+                e.values = FloatSpan{reinterpret_cast<const float*>(data + off), static_cast<size_t>(count)};
+            } else if (e.kind == EntryKind::Matrix) {
+                const auto type = static_cast<ElementType>(get<uint16_t>(data + dir + 2));
+                if (type != ElementType::Float32 && type != ElementType::Float64) return false;
+                const uint64_t off = get<uint64_t>(data + dir + 8);
+                const uint64_t stride = get<uint64_t>(data + dir + 16);
+                const uint32_t rows = get<uint32_t>(data + dir + 24);
+                const uint32_t cols = get<uint32_t>(data + dir + 28);
+                const size_t elem = elementSize(type);
+                if (stride < cols || (rows > 0 && stride > UINT64_MAX / rows)) return false;
+                if (!inBounds(off, stride * rows, elem, total) || off % elem) return false;
+                e.matrix = MatrixView{data + off, rows, cols, static_cast<size_t>(stride), type};
+            } else {
+                return false; // unknown entry kind
+            }
+            entries_.push_back(std::move(e));
+            dir += kEntrySize + detail::alignUp(keyLen, 8);
+        }
+        data_ = data;
+        size_ = static_cast<size_t>(total);
+        return true;
+    }
+
+    bool valid() const { return data_ != nullptr; }
+    size_t byteSize() const { return size_; }
+    uint32_t sampleRate() const { return sampleRate_; }
+    uint16_t channels() const { return channels_; }
+    uint16_t bitDepth() const { return bitDepth_; }
+    FloatSpan samples() const { return samples_; }
+    const std::vector<Entry>& entries() const { return entries_; }
+
+    const Entry* find(const std::string& key, EntryKind kind) const {
+        for (const auto& e : entries_) if (e.kind == kind && e.key == key) return &e;
+        return nullptr;
+    }
+    FloatSpan feature(const std::string& key) const {
+        const Entry* e = find(key, EntryKind::FloatVector);
+        return e ? e->values : FloatSpan{};
+    }
+    bool hasFeature(const std::string& key) const { return find(key, EntryKind::FloatVector) != nullptr; }
+    MatrixView matrix(const std::string& key) const {
+        const Entry* e = find(key, EntryKind::Matrix);
+        return e ? e->matrix : MatrixView{};
+    }
+    bool hasMatrix(const std::string& key) const { return find(key, EntryKind::Matrix) != nullptr; }
+    double scalar(const std::string& key, double def = 0.0) const {
+        const Entry* e = find(key, EntryKind::Scalar);
+        return e ? e->scalar : def;
+    }
+
+    // Materialize an owning DataPacket (copies payloads).
+    DataPacket toPacket() const {
+        DataPacket pkt(std::vector<float>(samples_.begin(), samples_.end()), sampleRate_, channels_, bitDepth_);
+        for (const auto& e : entries_) {
+            if (e.kind == EntryKind::Scalar) pkt.setScalar(e.key, e.scalar);
+            else if (e.kind == EntryKind::Matrix) pkt.setMatrix(e.key, e.matrix.toMatrix());
+            else pkt.setFeature(e.key, std::vector<float>(e.values.begin(), e.values.end()));
+        }
+        return pkt;
+    }
+
+private:
+    static bool inBounds(uint64_t off, uint64_t count, size_t elem, uint64_t total) {
+        if (off > total) return false;
+        return count <= (total - off) / elem;
+    }
+
+    const std::byte* data_{nullptr};
+    size_t size_{0};
+    uint32_t sampleRate_{0};
+    uint16_t channels_{0};
+    uint16_t bitDepth_{0};
+    FloatSpan samples_{};
+    std::vector<Entry> entries_{};
+};
+
+// A PacketView over a memory-mapped file; payloads are read straight from the mapping.
+class MappedPacket {
+public:
+    bool open(IPlatformIO& io, const std::string& path) {
+        file_ = io.mapFile(path);
+        return file_ && view_.open(file_.data, file_.size);
+    }
+    const PacketView& view() const { return view_; }
+
+private:
+    MappedFile file_{};
+    PacketView view_{};
+};
+
+inline bool decode(const std::byte* data, size_t size, DataPacket& out) {
+    PacketView v;
+    if (!v.open(data, size)) return false;
+    out = v.toPacket();
+    return true;
+}
+
+inline bool writeFile(IPlatformIO& io, const std::string& path, const DataPacket& pkt) {
+    return io.writeFile(path, encode(pkt));
+}
+
+inline bool readFile(IPlatformIO& io, const std::string& path, DataPacket& out) {
+    MappedPacket mp;
+    if (!mp.open(io, path)) return false;
+    out = mp.view().toPacket();
+    return true;
+}
+
+} // namespace vv::packetio
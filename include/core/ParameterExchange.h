@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace vv {
+
+// Lock-free hand-over of a parameter set from one control thread to one audio thread.
+// The control side writes into its back buffer and swaps it with a shared middle slot;
+// the audio side swaps its front buffer with the middle slot only when a newer set was
+// published. Neither side ever waits or sees a half-written set, and the audio thread
+// always gets the latest set (intermediate ones may be skipped).
+// T must be copyable; publish() and fetch() may each be called from one thread only.
+template <typename T>
+class ParameterExchange {
+public:
+    explicit ParameterExchange(const T& initial = T{}) : slots_{initial, initial, initial}, latest_(initial) {}
+
+    // Control thread.
+    void publish(const T& value) {
+        latest_ = value;
+        slots_[back_] = value;
+        back_ = static_cast<uint8_t>(middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndex);
+    }
+    // The last published set, for the control thread (e.g. to clone a filter).
+    const T& latest() const { return latest_; }
+
+    // Audio thread: copies the newest set into `out` and returns true if one was
+    // published since the previous fetch().
+    bool fetch(T& out) {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        front_ = static_cast<uint8_t>(middle_.exchange(front_, std::memory_order_acq_rel) & kIndex);
+        out = slots_[front_];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t kIndex = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    T slots_[3];
+    T latest_;
+    uint8_t back_{0};                // control side
+    uint8_t front_{2};               // audio side
+    std::atomic<uint8_t> middle_{1};
+};
+
+} // namespace vv
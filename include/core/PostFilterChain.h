@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "core/IPostFilter.h"
+
+namespace vv {
+
+// Ordered post-filters run tile by tile: every enabled filter processes one tile of the
+// buffer before the next tile is touched, so a long render streams through memory once
+// instead of once per filter. Tiles default to kDefaultTileBytes of interleaved samples,
+// small enough to stay in L1 alongside the filters' state.
+// Bypassed filters are dropped from the run list when the flag changes, so they cost
+// nothing per tile; a filter coming back from bypass is reset first (its history is
+// stale).
+// Filters see tiles as consecutive process() calls, exactly as they see stream blocks,
+// so the same chain serves offline buffers and streaming paths alike.
+// Not thread-safe: configure between process() calls.
+class PostFilterChain {
+public:
+    static constexpr size_t kDefaultTileBytes = size_t(16) << 10;
+
+    // Appends an enabled filter; it is prepared at once if the chain already is.
+    void add(std::shared_ptr<IPostFilter> filter) {
+        if (!filter) return;
+        if (prepared_) filter->prepare(sampleRate_, channels_);
+        filters_.push_back(Entry{std::move(filter), false});
+        rebuild();
+    }
+    void clear() { filters_.clear(); active_.clear(); prepared_ = false; }
+
+    size_t size() const { return filters_.size(); }
+    bool empty() const { return filters_.empty(); }
+    // Filters that are not bypassed.
+    size_t activeCount() const { return active_.size(); }
+    IPostFilter* filter(size_t i) const { return i < filters_.size() ? filters_[i].filter.get() : nullptr; }
+
+    void setBypassed(size_t i, bool bypassed) {
+        if (i >= filters_.size() || filters_[i].bypassed == bypassed) return;
+        filters_[i].bypassed = bypassed;
+        if (!bypassed) filters_[i].filter->reset();
+        rebuild();
+    }
+    bool isBypassed(size_t i) const { return i < filters_.size() && filters_[i].bypassed; }
+
+    // Tile length in interleaved samples (0 = kDefaultTileBytes worth).
+    void setTileSamples(size_t samples) { tileSamples_ = samples; }
+    size_t tileFrames() const {
+        const size_t samples = tileSamples_ ? tileSamples_ : kDefaultTileBytes / sizeof(float);
+        return std::max<size_t>(1, samples / std::max<uint16_t>(1, channels_));
+    }
+
+    // Prepares every filter for the format; a no-op if already prepared for it.
+    void prepare(uint32_t sampleRate, uint16_t channels) {
+        if (prepared_ && sampleRate == sampleRate_ && channels == channels_) return;
+        for (auto& e : filters_) e.filter->prepare(sampleRate, channels);
+        prepared_ = true;
+        sampleRate_ = sampleRate;
+        channels_ = channels;
+    }
+    bool isPrepared() const { return prepared_; }
+    void reset() { for (auto& e : filters_) e.filter->reset(); }
+
+    // In-place on `frames` interleaved frames of the prepared channel count.
+    void process(float* interleaved, size_t frames) {
+        if (!prepared_ || active_.empty() || !interleaved || frames == 0) return;
+        const size_t tile = tileFrames();
+        for (size_t first = 0; first < frames; first += tile) {
+            float* data = interleaved + first * channels_;
+            const size_t n = std::min(tile, frames - first);
+            for (IPostFilter* f : active_) f->process(data, n);
+        }
+    }
+
+    // Copies the chain with cloned filters (bypass flags and tiling kept, state cleared,
+    // unprepared). False if any filter cannot be cloned.
+    bool clone(PostFilterChain& out) const {
+        PostFilterChain c;
+        c.tileSamples_ = tileSamples_;
+        for (const auto& e : filters_) {
+            auto f = e.filter->clone();
+            if (!f) return false;
+            c.filters_.push_back(Entry{std::move(f), e.bypassed});
+        }
+        c.rebuild();
+        out = std::move(c);
+        return true;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<IPostFilter> filter;
+        bool bypassed{false};
+    };
+
+    void rebuild() {
+        active_.clear();
+        for (auto& e : filters_) if (!e.bypassed) active_.push_back(e.filter.get());
+    }
+
+    std::vector<Entry> filters_;
+    std::vector<IPostFilter*> active_; // run list: filters_ minus the bypassed ones
+    size_t tileSamples_{0};
+    bool prepared_{false};
+    uint32_t sampleRate_{0};
+    uint16_t channels_{1};
+};
+
+} // namespace vv
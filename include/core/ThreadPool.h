@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vv {
+
+// Persistent work-stealing thread pool.
+// Each worker owns a deque: it pushes/pops at the back (LIFO, cache-warm) while
+// idle workers steal from the front of other workers' deques (FIFO, oldest first).
+// Tasks are plain function pointers + context so that submitting does not allocate
+// in steady state (deques are ring buffers that only grow).
+class ThreadPool {
+public:
+    struct Task {
+        void (*fn)(void* ctx, uint32_t arg){nullptr};
+        void* ctx{nullptr};
+        uint32_t arg{0};
+    };
+
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) threads = 1;
+        queues_.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) queues_.push_back(std::make_unique<WorkQueue>());
+        workers_.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(sleepMutex_);
+            stop_ = true;
+        }
+        sleepCv_.notify_all();
+        for (auto& t : workers_) if (t.joinable()) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    // Submit a task. From a worker of this pool it lands on that worker's own deque;
+    // from any other thread the target deque is chosen round-robin.
+    void submit(Task task) {
+        size_t q;
+        if (tlsPool() == this) q = tlsIndex();
+        else q = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        // Count before publishing so a waiter never observes an empty pool with work queued.
+        pending_.fetch_add(1);
+        queues_[q]->push(task);
+        if (sleeping_.load() > 0) {
+            std::lock_guard<std::mutex> lk(sleepMutex_);
+            sleepCv_.notify_one();
+        }
+    }
+
+    // Run one queued task on the calling thread if any is available.
+    // Lets threads that wait on pool work (including workers blocking on nested
+    // graph executions) help instead of idling. Returns false if nothing ran.
+    bool tryRunOne() {
+        Task t;
+        size_t self = (tlsPool() == this) ? tlsIndex() : queues_.size();
+        if (!acquire(self, t)) return false;
+        t.fn(t.ctx, t.arg);
+        return true;
+    }
+
+    // Index of the calling worker in [0, size()), or size() for external threads.
+    unsigned currentWorker() const {
+        return tlsPool() == this ? static_cast<unsigned>(tlsIndex()) : size();
+    }
+
+private:
+    // Mutex-guarded ring-buffer deque. Owner operates on the back, thieves on the front.
+    class WorkQueue {
+    public:
+        void push(const Task& t) {
+            std::lock_guard<std::mutex> lk(m_);
+            if (count_ == buf_.size()) grow();
+            buf_[(head_ + count_) & (buf_.size() - 1)] = t;
+            ++count_;
+        }
+        bool popBack(Task& t) {
+            std::lock_guard<std::mutex> lk(m_);
+            if (count_ == 0) return false;
+            --count_;
+            t = buf_[(head_ + count_) & (buf_.size() - 1)];
+            return true;
+        }
+        bool stealFront(Task& t) {
+            std::lock_guard<std::mutex> lk(m_);
+            if (count_ == 0) return false;
+            t = buf_[head_];
+            head_ = (head_ + 1) & (buf_.size() - 1);
+            --count_;
+            return true;
+        }
+
+    private:
+        void grow() {
+            std::vector<Task> next(buf_.empty() ? 64 : buf_.size() * 2);
+            for (size_t i = 0; i < count_; ++i) next[i] = buf_[(head_ + i) & (buf_.size() - 1)];
+            buf_.swap(next);
+            head_ = 0;
+        }
+
+        std::mutex m_;
+        std::vector<Task> buf_{};
+        size_t head_{0};
+        size_t count_{0};
+    };
+
+    static const ThreadPool*& tlsPool() { static thread_local const ThreadPool* p = nullptr; return p; }
+    static size_t& tlsIndex() { static thread_local size_t i = 0; return i; }
+
+    bool acquire(size_t self, Task& t) {
+        if (pending_.load(std::memory_order_acquire) == 0) return false;
+        const size_t n = queues_.size();
+        if (self < n && queues_[self]->popBack(t)) { pending_.fetch_sub(1, std::memory_order_acq_rel); return true; }
+        const size_t start = (self < n) ? self + 1 : 0;
+        for (size_t k = 0; k < n; ++k) {
+            size_t victim = (start + k) % n;
+            if (victim == self) continue;
+            if (queues_[victim]->stealFront(t)) { pending_.fetch_sub(1, std::memory_order_acq_rel); return true; }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index) {
+        tlsPool() = this;
+        tlsIndex() = index;
+        Task t;
+        for (;;) {
+            if (acquire(index, t)) { t.fn(t.ctx, t.arg); continue; }
+            std::unique_lock<std::mutex> lk(sleepMutex_);
+            sleeping_.fetch_add(1);
+            sleepCv_.wait(lk, [this] { return stop_ || pending_.load() > 0; });
+            sleeping_.fetch_sub(1);
+            if (stop_ && pending_.load(std::memory_order_acquire) == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_{};
+    std::vector<std::thread> workers_{};
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> nextQueue_{0};
+    std::atomic<unsigned> sleeping_{0};
+    std::mutex sleepMutex_{};
+    std::condition_variable sleepCv_{};
+    bool stop_{false};
+};
+
+// Run fn(i) for every i in [0, count) on the pool and the calling thread; returns once
+// all calls have finished. Indices are handed out dynamically, so uneven work items
+// balance themselves. Safe to call from a pool worker (the caller helps drain the pool
+// while it waits). Without a pool, or for a single item, runs inline.
+template <typename Fn>
+void parallelFor(ThreadPool* pool, size_t count, Fn&& fn) {
+    if (!pool || count <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    struct Ctx {
+        std::remove_reference_t<Fn>* fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+        size_t finished{0}; // helper tasks that have returned; guarded by m
+        std::mutex m;
+        std::condition_variable cv;
+        void drain() {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) (*fn)(i);
+        }
+        static void run(void* p, uint32_t) {
+            auto* c = static_cast<Ctx*>(p);
+            c->drain();
+            std::lock_guard<std::mutex> lk(c->m); // last touch of *c happens under the lock
+            ++c->finished;
+            c->cv.notify_all();
+        }
+    } ctx;
+    ctx.fn = &fn;
+    ctx.count = count;
+    const size_t helpers = std::min<size_t>(count - 1, pool->size());
+    for (size_t h = 0; h < helpers; ++h) pool->submit({&Ctx::run, &ctx, 0});
+    ctx.drain();
+    // Every helper must have returned before ctx goes out of scope, even those that
+    // found no indices left; run other pool work meanwhile so nested calls cannot stall.
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(ctx.m);
+            if (ctx.finished == helpers) return;
+        }
+        if (pool->tryRunOne()) continue;
+        std::unique_lock<std::mutex> lk(ctx.m);
+        ctx.cv.wait_for(lk, std::chrono::microseconds(200), [&] { return ctx.finished == helpers; });
+        if (ctx.finished == helpers) return;
+    }
+}
+
+} // namespace vv
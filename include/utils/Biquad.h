@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace vv::iir {
+
+// Normalized biquad: y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2].
+struct BiquadCoeffs {
+    float b0{1.0f}, b1{0.0f}, b2{0.0f}, a1{0.0f}, a2{0.0f};
+};
+
+enum class BiquadType { Peaking, LowShelf, HighShelf, LowPass, HighPass, BandPass };
+
+// Audio EQ cookbook (R. Bristow-Johnson) designs. gainDb applies to Peaking and the
+// shelves; q is the bandwidth (shelves: 0.707 is the steepest without overshoot).
+inline BiquadCoeffs design(BiquadType type, double sampleRate, double freq, double q, double gainDb) {
+    const double pi = 3.14159265358979323846;
+    const double w = 2.0 * pi * std::clamp(freq, 1.0, 0.49 * sampleRate) / sampleRate;
+    const double cw = std::cos(w), sw = std::sin(w);
+    const double alpha = sw / (2.0 * std::max(q, 1e-3));
+    const double A = std::pow(10.0, gainDb / 40.0);
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (type) {
+    case BiquadType::Peaking:
+        b0 = 1.0 + alpha * A; b1 = -2.0 * cw; b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A; a1 = -2.0 * cw; a2 = 1.0 - alpha / A;
+        break;
+    case BiquadType::LowShelf: {
+        const double s = 2.0 * std::sqrt(A) * alpha;
+        b0 = A * ((A + 1.0) - (A - 1.0) * cw + s); b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cw - s);
+        a0 = (A + 1.0) + (A - 1.0) * cw + s; a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+        a2 = (A + 1.0) + (A - 1.0) * cw - s;
+        break;
+    }
+    case BiquadType::HighShelf: {
+        const double s = 2.0 * std::sqrt(A) * alpha;
+        b0 = A * ((A + 1.0) + (A - 1.0) * cw + s); b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cw - s);
+        a0 = (A + 1.0) - (A - 1.0) * cw + s; a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+        a2 = (A + 1.0) - (A - 1.0) * cw - s;
+        break;
+    }
+    case BiquadType::LowPass:
+        b0 = (1.0 - cw) / 2.0; b1 = 1.0 - cw; b2 = b0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cw; a2 = 1.0 - alpha;
+        break;
+    case BiquadType::HighPass:
+        b0 = (1.0 + cw) / 2.0; b1 = -(1.0 + cw); b2 = b0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cw; a2 = 1.0 - alpha;
+        break;
+    case BiquadType::BandPass: // 0 dB peak gain
+        b0 = alpha; b1 = 0.0; b2 = -alpha;
+        a0 = 1.0 + alpha; a1 = -2.0 * cw; a2 = 1.0 - alpha;
+        break;
+    }
+    BiquadCoeffs c;
+    c.b0 = static_cast<float>(b0 / a0); c.b1 = static_cast<float>(b1 / a0); c.b2 = static_cast<float>(b2 / a0);
+    c.a1 = static_cast<float>(a1 / a0); c.a2 = static_cast<float>(a2 / a0);
+    return c;
+}
+
+// Up to kMaxSections biquads in series on one channel (transposed direct form II).
+// A recursion cannot be vectorized along time, so longer cascades are evaluated as a
+// wavefront across sections instead: at step t section s works on sample t - s, taking
+// section s - 1's output of the previous step, so all kMaxSections sections update
+// together as one fixed-width, unit-stride loop. The pipeline fills and drains within
+// each process() call (those edge steps run per section), so there is no added latency
+// and the result equals running the sections one after another.
+class BiquadCascade {
+public:
+    static constexpr size_t kMaxSections = 8;
+
+    BiquadCascade() { setSections(0); }
+
+    // Sections [0, n) filter; the rest pass through.
+    void setSections(size_t n) {
+        n_ = std::min(n, kMaxSections);
+        for (size_t s = n_; s < kMaxSections; ++s) { setCoeffs(s, BiquadCoeffs{}); z1_[s] = z2_[s] = 0.0f; }
+    }
+    size_t sections() const { return n_; }
+    void setCoeffs(size_t s, const BiquadCoeffs& c) {
+        if (s >= kMaxSections) return;
+        b0_[s] = c.b0; b1_[s] = c.b1; b2_[s] = c.b2; a1_[s] = c.a1; a2_[s] = c.a2;
+    }
+    void reset() { std::fill(z1_, z1_ + kMaxSections, 0.0f); std::fill(z2_, z2_ + kMaxSections, 0.0f); }
+
+    // In place on frames samples spaced `stride` apart (one channel of an interleaved
+    // buffer).
+    void process(float* x, size_t frames, size_t stride = 1) {
+        if (n_ == 0 || frames == 0) return;
+        if (n_ <= 2 || frames < 4 * kMaxSections) { processSerial(x, frames, stride); return; }
+        constexpr size_t K = kMaxSections;
+        float in[K] = {}, out[K] = {};
+        // Edge steps: only sections with a sample in flight (0 <= t - s < frames) advance.
+        auto edge = [&](size_t t) {
+            for (size_t s = 0; s < K; ++s) {
+                if (t < s || t - s >= frames) continue;
+                out[s] = step(s, in[s]);
+            }
+            if (t >= K - 1) x[(t - (K - 1)) * stride] = out[K - 1];
+            for (size_t s = K - 1; s > 0; --s) in[s] = out[s - 1];
+            if (t + 1 < frames) in[0] = x[(t + 1) * stride];
+        };
+        in[0] = x[0];
+        size_t t = 0;
+        for (; t < K - 1; ++t) edge(t);
+        // Every section busy: the wavefront proper.
+        float b0[K], b1[K], b2[K], a1[K], a2[K], z1[K], z2[K];
+        std::copy(b0_, b0_ + K, b0); std::copy(b1_, b1_ + K, b1); std::copy(b2_, b2_ + K, b2);
+        std::copy(a1_, a1_ + K, a1); std::copy(a2_, a2_ + K, a2);
+        std::copy(z1_, z1_ + K, z1); std::copy(z2_, z2_ + K, z2);
+        for (; t < frames; ++t) {
+            for (size_t s = 0; s < K; ++s) {
+                const float v = in[s];
+                const float y = b0[s] * v + z1[s];
+                z1[s] = b1[s] * v - a1[s] * y + z2[s];
+                z2[s] = b2[s] * v - a2[s] * y;
+                out[s] = y;
+            }
+            x[(t - (K - 1)) * stride] = out[K - 1];
+            for (size_t s = K - 1; s > 0; --s) in[s] = out[s - 1];
+            in[0] = t + 1 < frames ? x[(t + 1) * stride] : 0.0f;
+        }
+        std::copy(z1, z1 + K, z1_); std::copy(z2, z2 + K, z2_);
+        for (; t < frames + K - 1; ++t) edge(t);
+    }
+
+private:
+    float step(size_t s, float v) {
+        const float y = b0_[s] * v + z1_[s];
+        z1_[s] = b1_[s] * v - a1_[s] * y + z2_[s];
+        z2_[s] = b2_[s] * v - a2_[s] * y;
+        return y;
+    }
+    void processSerial(float* x, size_t frames, size_t stride) {
+        for (size_t i = 0; i < frames; ++i) {
+            float v = x[i * stride];
+            for (size_t s = 0; s < n_; ++s) v = step(s, v);
+            x[i * stride] = v;
+        }
+    }
+
+    size_t n_{0};
+    float b0_[kMaxSections]{}, b1_[kMaxSections]{}, b2_[kMaxSections]{}, a1_[kMaxSections]{}, a2_[kMaxSections]{};
+    float z1_[kMaxSections]{}, z2_[kMaxSections]{};
+};
+
+} // namespace vv::iir
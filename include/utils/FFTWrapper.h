@@ -3,47 +3,214 @@
 #include <vector>
 #include <complex>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
 namespace vv::fft {
 
-// Minimal Cooley-Tukey radix-2 FFT for power-of-two sizes
-// For production, replace with FFTW/KissFFT integration.
-class FFTWrapper {
+// Radix-2 Cooley-Tukey transform of one power-of-two size. Twiddles (computed in double)
+// and the bit-reversal permutation are built once, so repeated transforms of the same
+// size, e.g. one per analysis frame, skip the trig calls and do not accumulate twiddle
+// error. Immutable after construction: share one plan across threads, each thread
+// transforming its own buffers.
+// Convention: forward is X[k] = sum x[n] e^{-2 pi i k n / N}; inverse scales by 1/N.
+class FFTPlan {
+public:
+    explicit FFTPlan(size_t n = 0) : n_(n) {
+        if (n_ < 2 || (n_ & (n_ - 1)) != 0) { n_ = (n_ == 1) ? 1 : 0; return; }
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n_) ++bits;
+        rev_.resize(n_);
+        for (size_t i = 0; i < n_; ++i) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+            rev_[i] = static_cast<uint32_t>(r);
+        }
+        twiddles_.resize(n_ / 2);
+        for (size_t k = 0; k < n_ / 2; ++k) {
+            const double a = -2.0 * 3.14159265358979323846 * static_cast<double>(k) / static_cast<double>(n_);
+            twiddles_[k] = std::complex<float>(static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a)));
+        }
+    }
+
+    // 0 if the size passed to the constructor was not a power of two.
+    size_t size() const { return n_; }
+
+    void forward(std::complex<float>* a) const { transform(a, false); }
+    void inverse(std::complex<float>* a) const { transform(a, true); }
+
+    static size_t nextPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+private:
+    void transform(std::complex<float>* a, bool inverse) const {
+        if (n_ < 2) return;
+        for (size_t i = 0; i < n_; ++i) {
+            if (i < rev_[i]) std::swap(a[i], a[rev_[i]]);
+        }
+        for (size_t len = 2; len <= n_; len <<= 1) {
+            const size_t half = len / 2, step = n_ / len;
+            for (size_t i = 0; i < n_; i += len) {
+                for (size_t k = 0; k < half; ++k) {
+                    const std::complex<float> w = inverse ? std::conj(twiddles_[k * step]) : twiddles_[k * step];
+                    const auto u = a[i + k];
+                    const auto v = a[i + k + half] * w;
+                    a[i + k] = u + v;
+                    a[i + k + half] = u - v;
+                }
+            }
+        }
+        if (inverse) {
+            const float s = 1.0f / static_cast<float>(n_);
+            for (size_t i = 0; i < n_; ++i) a[i] *= s;
+        }
+    }
+
+    size_t n_{0};
+    std::vector<uint32_t> rev_{};
+    std::vector<std::complex<float>> twiddles_{};
+};
+
+// Forward transform of a real signal of power-of-two length n >= 4 through one complex
+// FFT of size n/2 (even/odd samples packed as re/im, then split with a twiddle pass).
+// Produces the n/2 + 1 non-negative-frequency bins. Immutable, like FFTPlan.
+class RealFFTPlan {
 public:
-    static void fft(std::vector<std::complex<float>>& a) { transform(a, false); }
-    static void ifft(std::vector<std::complex<float>>& a) { transform(a, true); }
+    explicit RealFFTPlan(size_t n = 0) : half_(n / 2) {
+        n_ = (half_.size() >= 2 && half_.size() * 2 == n) ? n : 0;
+        twiddles_.resize(n_ / 4 + 1);
+        for (size_t k = 0; k < twiddles_.size() && n_; ++k) {
+            const double a = -2.0 * 3.14159265358979323846 * static_cast<double>(k) / static_cast<double>(n_);
+            twiddles_[k] = std::complex<float>(static_cast<float>(std::cos(a)), static_cast<float>(std::sin(a)));
+        }
+    }
+
+    // 0 unless constructed with a power of two >= 4.
+    size_t size() const { return n_; }
+    size_t bins() const { return n_ ? n_ / 2 + 1 : 0; }
+
+    // x: n samples; out: bins() values (also used as workspace).
+    void forward(const float* x, std::complex<float>* out) const {
+        if (!n_) return;
+        const size_t h = n_ / 2;
+        for (size_t m = 0; m < h; ++m) out[m] = std::complex<float>(x[2 * m], x[2 * m + 1]);
+        half_.forward(out);
+        // X[k] = E[k] + W^k O[k], where E/O are the spectra of the even/odd samples, and
+        // X[h - k] = conj(E[k] - W^k O[k]); k and h - k are updated together in place.
+        const std::complex<float> z0 = out[0];
+        out[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+        out[h] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+        for (size_t k = 1; k <= h / 2; ++k) {
+            const std::complex<float> a = out[k], b = std::conj(out[h - k]);
+            const std::complex<float> e = 0.5f * (a + b);
+            const std::complex<float> o = std::complex<float>(0.0f, -0.5f) * (a - b);
+            const std::complex<float> wo = twiddles_[k] * o;
+            out[k] = e + wo;
+            out[h - k] = std::conj(e - wo);
+        }
+    }
 
 private:
-    static void transform(std::vector<std::complex<float>>& a, bool inverse) {
-        const size_t n = a.size();
-        if ((n & (n-1)) != 0) return; // require power of two
-        // bit-reverse
-        size_t j = 0;
-        for (size_t i=1;i<n;i++) {
-            size_t bit = n >> 1;
-            for (; j & bit; bit >>= 1) j ^= bit;
-            j ^= bit;
-            if (i < j) std::swap(a[i], a[j]);
-        }
-        for (size_t len=2; len<=n; len<<=1) {
-            float ang = 2.0f * 3.14159265358979323846f / static_cast<float>(len);
-            if (inverse) ang = -ang;
-            std::complex<float> wlen(std::cos(ang), std::sin(ang));
-            for (size_t i=0; i<n; i+=len) {
-                std::complex<float> w(1.0f, 0.0f);
-                for (size_t j2=0; j2<len/2; ++j2) {
-                    auto u = a[i+j2];
-                    auto v = a[i+j2+len/2] * w;
-                    a[i+j2] = u + v;
-                    a[i+j2+len/2] = u - v;
-                    w *= wlen;
+    FFTPlan half_;
+    size_t n_{0};
+    std::vector<std::complex<float>> twiddles_{};
+};
+
+// Lanes transforms of one power-of-two size at once, on split real/imaginary arrays with
+// the signals interleaved: element i of signal l is re[i * Lanes + l]. Every butterfly
+// runs over the lanes innermost with one twiddle, a fixed-length unit-stride loop the
+// compiler turns into vector instructions, so a batch costs about as much as one scalar
+// transform. Each lane's result is independent of the others (and of which lane it sits
+// in). Same conventions as FFTPlan; immutable, shareable across threads.
+template <size_t Lanes>
+class BatchFFTPlan {
+public:
+    static constexpr size_t kLanes = Lanes;
+
+    explicit BatchFFTPlan(size_t n = 0) : n_(n) {
+        if (n_ < 2 || (n_ & (n_ - 1)) != 0) { n_ = 0; return; }
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n_) ++bits;
+        rev_.resize(n_);
+        for (size_t i = 0; i < n_; ++i) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+            rev_[i] = static_cast<uint32_t>(r);
+        }
+        // Per stage, the twiddles of its half-length butterfly group repeated across the
+        // lanes (stage with half-length h at offset (h - 1) * Lanes), so a group is one
+        // unit-stride loop of h * Lanes butterflies.
+        twRe_.resize((n_ - 1) * Lanes);
+        twIm_.resize((n_ - 1) * Lanes);
+        for (size_t half = 1; half < n_; half <<= 1) {
+            for (size_t k = 0; k < half; ++k) {
+                const double a = -3.14159265358979323846 * static_cast<double>(k) / static_cast<double>(half);
+                for (size_t l = 0; l < Lanes; ++l) {
+                    twRe_[(half - 1 + k) * Lanes + l] = static_cast<float>(std::cos(a));
+                    twIm_[(half - 1 + k) * Lanes + l] = static_cast<float>(std::sin(a));
                 }
             }
         }
+    }
+
+    // 0 unless constructed with a power of two >= 2.
+    size_t size() const { return n_; }
+
+    // re/im: size() * Lanes values each.
+    void forward(float* re, float* im) const { transform(re, im, false); }
+    void inverse(float* re, float* im) const { transform(re, im, true); }
+
+private:
+    void transform(float* re, float* im, bool inverse) const {
+        if (!n_) return;
+        for (size_t i = 0; i < n_; ++i) {
+            if (i >= rev_[i]) continue;
+            float* a = re + i * Lanes; float* b = re + rev_[i] * Lanes;
+            float* c = im + i * Lanes; float* d = im + rev_[i] * Lanes;
+            for (size_t l = 0; l < Lanes; ++l) { std::swap(a[l], b[l]); std::swap(c[l], d[l]); }
+        }
+        const float sign = inverse ? -1.0f : 1.0f;
+        for (size_t half = 1; half < n_; half <<= 1) {
+            const float* wr = twRe_.data() + (half - 1) * Lanes;
+            const float* wi = twIm_.data() + (half - 1) * Lanes;
+            const size_t span = half * Lanes;
+            for (size_t i = 0; i < n_; i += 2 * half) {
+                float* ur = re + i * Lanes; float* ui = im + i * Lanes;
+                butterflies(ur, ui, ur + span, ui + span, wr, wi, span, sign);
+            }
+        }
         if (inverse) {
-            for (auto& x : a) x /= static_cast<float>(n);
+            const float s = 1.0f / static_cast<float>(n_);
+            for (size_t i = 0; i < n_ * Lanes; ++i) { re[i] *= s; im[i] *= s; }
+        }
+    }
+
+    // The six arrays never overlap; saying so spares the vectorizer runtime alias checks
+    // (more than it is willing to emit, in which case the loop stays scalar).
+    static void butterflies(float* __restrict ur, float* __restrict ui, float* __restrict vr, float* __restrict vi,
+                            const float* __restrict wr, const float* __restrict wi, size_t count, float sign) {
+        for (size_t j = 0; j < count; ++j) {
+            const float tr = vr[j] * wr[j] - sign * vi[j] * wi[j];
+            const float ti = sign * vr[j] * wi[j] + vi[j] * wr[j];
+            vr[j] = ur[j] - tr; vi[j] = ui[j] - ti;
+            ur[j] += tr; ui[j] += ti;
         }
     }
+
+    size_t n_{0};
+    std::vector<uint32_t> rev_{};
+    std::vector<float> twRe_{}, twIm_{};
+};
+
+// One-shot transforms for power-of-two sizes (other sizes are left untouched).
+// Prefer an FFTPlan when transforming many buffers of the same size.
+class FFTWrapper {
+public:
+    static void fft(std::vector<std::complex<float>>& a) { FFTPlan(a.size()).forward(a.data()); }
+    static void ifft(std::vector<std::complex<float>>& a) { FFTPlan(a.size()).inverse(a.data()); }
 };
 
 } // namespace vv::fft
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace vv::hash {
+
+// Fast non-cryptographic 64-bit hashing for content addressing (caches, dedup).
+// Four independent lanes consume 32 bytes per iteration (xxHash64-style rounds), so
+// hashing a multi-megabyte feature matrix runs at memory bandwidth.
+
+namespace detail {
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t P3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+inline uint64_t load64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+inline uint32_t load32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint64_t round(uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; }
+inline uint64_t merge(uint64_t acc, uint64_t val) { return (acc ^ round(0, val)) * P1 + P4; }
+} // namespace detail
+
+// Final avalanche; also usable to scramble small integers.
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33; h *= detail::P2;
+    h ^= h >> 29; h *= detail::P3;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint64_t bytes(const void* data, size_t len, uint64_t seed = 0) {
+    using namespace detail;
+    const auto* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        const unsigned char* const limit = end - 32;
+        do {
+            v1 = round(v1, load64(p));
+            v2 = round(v2, load64(p + 8));
+            v3 = round(v3, load64(p + 16));
+            v4 = round(v4, load64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1); h = merge(h, v2); h = merge(h, v3); h = merge(h, v4);
+    } else {
+        h = seed + P5;
+    }
+    h += static_cast<uint64_t>(len);
+    for (; p + 8 <= end; p += 8) h = rotl(h ^ round(0, load64(p)), 27) * P1 + P4;
+    if (p + 4 <= end) { h = rotl(h ^ (static_cast<uint64_t>(load32(p)) * P1), 23) * P2 + P3; p += 4; }
+    for (; p < end; ++p) h = rotl(h ^ (static_cast<uint64_t>(*p) * P5), 11) * P1;
+    return mix(h);
+}
+
+inline uint64_t string(const std::string& s, uint64_t seed = 0) { return bytes(s.data(), s.size(), seed); }
+
+template <typename T>
+inline uint64_t value(const T& v, uint64_t seed = 0) { return bytes(&v, sizeof(T), seed); }
+
+// Order-dependent combination of two hashes.
+inline uint64_t combine(uint64_t a, uint64_t b) { return mix(a ^ (b + detail::P1 + (a << 6) + (a >> 2))); }
+
+} // namespace vv::hash
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace vv::vmath {
+
+// Single-precision log, exp and sin/cos over arrays, written branch-free from integer and
+// float arithmetic only (Cephes polynomials, ~2 ulp in the ranges below) so the loops
+// vectorize; the libm calls they replace do not. Outputs may alias inputs.
+
+namespace detail {
+inline float asFloat(int32_t i) { float f; std::memcpy(&f, &i, sizeof f); return f; }
+inline int32_t asInt(float f) { int32_t i; std::memcpy(&i, &f, sizeof i); return i; }
+
+// Natural log for positive, normal x.
+inline float logf1(float x) {
+    const int32_t bits = asInt(x);
+    // x = 2^e * m with m in [sqrt(0.5), sqrt(2)), decided on the mantissa bits (integer
+    // selects are if-converted; float ones are not under the default -ftrapping-math).
+    const int32_t mantissa = bits & 0x007fffff;
+    const int32_t low = mantissa < 0x003504f3 ? 1 : 0;
+    const float fe = static_cast<float>(((bits >> 23) & 0xff) - 126 - low);
+    const float m = asFloat(mantissa | (0x3f000000 + (low << 23))) - 1.0f;
+    const float z = m * m;
+    float y = 7.0376836292e-2f;
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y *= m * z;
+    y += -2.12194440e-4f * fe - 0.5f * z;
+    return m + y + 0.693359375f * fe;
+}
+
+// exp, saturating outside [-87.3, 88].
+inline float expf1(float x) {
+    // Clamped as an integer key that orders like the float (negative magnitudes flipped),
+    // since float selects are branched on (see logf1()).
+    const int32_t bits = asInt(x);
+    int32_t key = bits ^ ((bits >> 31) & 0x7fffffff);
+    key = std::max(std::min(key, 0x42b00000), static_cast<int32_t>(0xc2ae999au ^ 0x7fffffffu)); // [-87.3f, 88.0f]
+    x = asFloat(key ^ ((key >> 31) & 0x7fffffff));
+    const float t = x * 1.44269504088896341f;
+    const float fn = (t + 12582912.0f) - 12582912.0f; // round to nearest
+    float r = x - fn * 0.693359375f;
+    r -= fn * -2.12194440e-4f;
+    const float z = r * r;
+    float y = 1.9875691500e-4f;
+    y = y * r + 1.3981999507e-3f;
+    y = y * r + 8.3334519073e-3f;
+    y = y * r + 4.1665795894e-2f;
+    y = y * r + 1.6666665459e-1f;
+    y = y * r + 5.0000001201e-1f;
+    y = y * z + r + 1.0f;
+    return y * asFloat((static_cast<int32_t>(fn) + 127) << 23);
+}
+
+// sin and cos for |x| < 8192.
+inline void sincosf1(float x, float& s, float& c) {
+    const bool negative = x < 0.0f;
+    x = negative ? -x : x;
+    int32_t j = static_cast<int32_t>(x * 1.27323954473516f); // 4 / pi
+    j = (j + 1) & ~1;
+    const float y = static_cast<float>(j);
+    x = ((x - y * 0.78515625f) - y * 2.4187564849853515625e-4f) - y * 3.77489497744594108e-8f;
+    const float z = x * x;
+    float pc = 2.443315711809948e-5f;
+    pc = pc * z - 1.388731625493765e-3f;
+    pc = pc * z + 4.166664568298827e-2f;
+    pc = pc * z * z - 0.5f * z + 1.0f;
+    float ps = -1.9515295891e-4f;
+    ps = ps * z + 8.3321608736e-3f;
+    ps = ps * z - 1.6666654611e-1f;
+    ps = ps * z * x + x;
+    const bool swap = (j & 2) != 0;
+    const float sv = swap ? pc : ps, cv = swap ? ps : pc;
+    const bool sinNegative = ((j & 4) != 0) != negative;
+    const bool cosNegative = ((j - 2) & 4) == 0;
+    s = sinNegative ? -sv : sv;
+    c = cosNegative ? -cv : cv;
+}
+} // namespace detail
+
+inline void log(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = detail::logf1(x[i]);
+}
+
+inline void exp(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = detail::expf1(x[i]);
+}
+
+inline void sincos(const float* x, float* s, float* c, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        float sv, cv;
+        detail::sincosf1(x[i], sv, cv);
+        s[i] = sv;
+        c[i] = cv;
+    }
+}
+
+} // namespace vv::vmath
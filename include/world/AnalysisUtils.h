@@ -4,11 +4,67 @@
 #include <cstdint>
 #include <vector>
 
+#include "core/FeatureMatrix.h"
+#include "utils/FFTWrapper.h"
+
 namespace vv {
 
-// Placeholder implementations standing in for DIO/Harvest, CheapTrick, D4C
-std::vector<float> estimateF0(const std::vector<float>& x, uint32_t sr, size_t hop);
-std::vector<float> simpleSpectralEnvelope(const std::vector<float>& x, size_t frameSize, size_t hop);
-std::vector<float> simpleAperiodicity(const std::vector<float>& x, size_t frameSize, size_t hop);
+// Fallback estimators used when WORLD is not available: an FFT-based YIN pitch tracker
+// standing in for DIO/Harvest, and STFT-based stand-ins for CheapTrick and D4C.
+// F0 is searched in [f0Floor, f0Ceil] Hz; unvoiced frames are 0.
+std::vector<float> estimateF0(const std::vector<float>& x, uint32_t sr, size_t hop,
+                              double f0Floor = 50.0, double f0Ceil = 500.0);
+
+// Frame-range forms: every frame depends only on the input signal, so disjoint ranges
+// can be computed concurrently and give the same values as whole-signal calls.
+// `out` receives `count` values starting at frame `first`.
+size_t f0FrameCount(size_t samples, uint32_t sr, size_t hop, double f0Floor = 50.0, double f0Ceil = 500.0);
+// Samples estimateF0Frames reads from a frame's first sample onward.
+size_t f0ContextSamples(uint32_t sr, double f0Floor = 50.0);
+size_t envelopeFrameCount(size_t samples, size_t hop);
+void estimateF0Frames(const std::vector<float>& x, uint32_t sr, size_t hop, size_t first, size_t count, float* out,
+                      double f0Floor = 50.0, double f0Ceil = 500.0);
+
+// Resample an F0 track with one value every srcHop samples (from sample 0) onto a grid
+// of one value every dstHop samples starting at sample dstOffset. Voiced neighbours are
+// interpolated linearly; next to an unvoiced (0) value the nearer source value is taken,
+// so voicing edges move by at most half a source frame. The last source value is held
+// past the end.
+void resampleF0(const float* src, size_t srcFrames, double srcHop, float* dst, size_t dstFrames, double dstHop,
+                double dstOffset = 0.0);
+
+// Short-time Fourier analysis on the envelope frame grid: frame f covers samples
+// [f * hop, f * hop + frameSize) (zero past the end of x), Hann-windowed and zero-padded
+// to fftSize(), the next power of two. Power spectra are normalized by the window
+// energy. Immutable after construction: one engine serves any number of threads.
+class StftEngine {
+public:
+    StftEngine(size_t frameSize, size_t hop);
+
+    size_t frameSize() const { return frameSize_; }
+    size_t hop() const { return hop_; }
+    size_t fftSize() const { return plan_.size(); }
+    size_t bins() const { return plan_.bins(); }
+    size_t frameCount(size_t samples) const { return envelopeFrameCount(samples, hop_); }
+
+    // Power spectrum of one frame into power[0, bins()). `scratch` holds bins() values.
+    void powerSpectrum(const std::vector<float>& x, size_t frame, float* power,
+                       std::complex<float>* scratch) const;
+
+private:
+    size_t frameSize_;
+    size_t hop_;
+    fft::RealFFTPlan plan_;
+    std::vector<float> window_;
+    float norm_{1.0f};
+};
+
+// Per-bin spectral envelope and aperiodicity for frames [first, first + count), both
+// derived from one power spectrum per frame: the envelope is the power spectrum smoothed
+// over a fixed 300 Hz band; aperiodicity is the spectral flatness (geometric / arithmetic
+// mean power) of 3 kHz bands, interpolated across bins and clamped to [0, 1].
+// envRows/apRows hold `count` row pointers of stft.bins() floats each.
+void stftEnvelopeAperiodicityFrames(const StftEngine& stft, const std::vector<float>& x, uint32_t sr,
+                                    size_t first, size_t count, float* const* envRows, float* const* apRows);
 
 } // namespace vv
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/ISynthesisNode.h"
+#include "world/WorldAnalysisNode.h"
+
+namespace vv {
+
+namespace wavio { class WavReader; }
+
+// Analyses a recording of any length in bounded memory. Audio is pulled from a reader
+// (e.g. WavReader::readFrames) and analysed block by block: each block of framesPerBlock
+// frames is run through the WorldAnalysisNode together with the context its estimators
+// need on either side (WorldAnalysisNode::analysisContext()), and only the block's own
+// frames are emitted. Peak memory is a window of framesPerBlock * hop + context samples
+// plus the features of that window, independent of the file length.
+//
+// Blocks have the same shape as PacketBlockSource's: the block's samples, its rows of
+// every per-frame feature and matrix, and the node's scalars. next() can therefore feed
+// ComputationGraph::runStreaming() directly; run() pushes every block to a sink instead
+// (e.g. UtauWorldStreamWriter).
+//
+// Multi-channel input is mixed down to mono. With the placeholder estimators the blocks
+// are bit-identical to slices of a whole-file analysis. WORLD's Harvest tracks F0
+// contours across the whole signal, so F0 (and the envelope/aperiodicity derived from
+// it) can differ from a whole-file run near block boundaries; CheapTrick and D4C are
+// otherwise fully covered by the context.
+class ChunkedAnalysisSource {
+public:
+    // Reads up to maxFrames interleaved frames into dst; returns frames read (0 at end).
+    using FrameReader = std::function<size_t(float* dst, size_t maxFrames)>;
+    using BlockSink = std::function<bool(const StreamBlock& info, const std::shared_ptr<DataPacket>& block)>;
+
+    ChunkedAnalysisSource(std::shared_ptr<WorldAnalysisNode> node, FrameReader reader, size_t totalFrames,
+                          uint32_t sampleRate, uint16_t channels, size_t framesPerBlock = 2048);
+    // Reads from an opened WavReader, which must outlive the source.
+    ChunkedAnalysisSource(std::shared_ptr<WorldAnalysisNode> node, wavio::WavReader& reader,
+                          size_t framesPerBlock = 2048);
+
+    size_t totalFrames() const { return totalFrames_; }
+    size_t blockCount() const { return (totalFrames_ + framesPerBlock_ - 1) / framesPerBlock_; }
+    uint32_t sampleRate() const { return sampleRate_; }
+    size_t sampleCount() const { return totalSamples_; }
+
+    // Analyse the next block; false once the input is exhausted or on failure (a read
+    // that ends early, or the node returning no packet; see failed()).
+    bool next(std::shared_ptr<const DataPacket>& block, StreamBlock& info);
+    // Push every remaining block to sink in order; false on failure or if the sink stops.
+    bool run(const BlockSink& sink);
+
+    bool failed() const { return failed_; }
+    // Largest analysis window held so far, in samples.
+    size_t peakWindowSamples() const { return peakWindow_; }
+
+private:
+    bool fill(size_t start, size_t end);
+    std::shared_ptr<DataPacket> analyseNext(StreamBlock& info);
+
+    std::shared_ptr<WorldAnalysisNode> node_;
+    FrameReader reader_;
+    size_t totalSamples_{0};
+    uint32_t sampleRate_{0};
+    uint16_t channels_{1};
+    size_t framesPerBlock_{1};
+    size_t hop_{1};
+    WorldAnalysisNode::Context context_{};
+    size_t totalFrames_{0};
+
+    std::vector<float> window_; // mono samples [windowStart_, windowStart_ + window_.size())
+    std::vector<float> interleaved_;
+    size_t windowStart_{0};
+    size_t samplesRead_{0};
+    size_t nextFrame_{0};
+    size_t blockIndex_{0};
+    size_t peakWindow_{0};
+    bool failed_{false};
+};
+
+// Frames [firstFrame, firstFrame + frames) of an analysis: every per-frame feature and
+// matrix cut to those rows (clamped to what the analysis has) and the scalars, with the
+// given samples. Used to keep a window's own frames and drop its context.
+std::shared_ptr<DataPacket> sliceAnalysisFrames(const DataPacket& analysed, size_t firstFrame, size_t frames,
+                                                std::vector<float> samples);
+
+} // namespace vv
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "core/FeatureMatrix.h"
+#include "utils/FFTWrapper.h"
+
+namespace vv {
+
+class ThreadPool;
+
+struct PulseVocoderConfig {
+    uint32_t sampleRate{48000};
+    size_t fftSize{2048};  // envelope/aperiodicity rows have fftSize/2+1 values
+    double hopSize{240.0}; // samples between frames
+    uint64_t seed{0x9E3779B97F4A7C15ull}; // aperiodic noise
+};
+
+// One excitation pulse of the schedule: where it sits, which frames it interpolates and
+// how much noise it carries.
+struct VocoderPulse {
+    double time{0.0};      // in samples
+    size_t frame{0};       // frame at or before time; interpolates with frame + 1
+    float weight{0.0f};    // position between frame and frame + 1
+    bool voiced{false};
+    size_t noiseSize{1};   // samples to the next pulse (capped at fftSize)
+    double period{1.0};
+    uint64_t index{0};     // ordinal in the schedule; keys the pulse's noise
+};
+
+// WORLD-style pulse vocoder kernel. Every pitch pulse (every 2 ms when unvoiced) yields a
+// minimum-phase periodic response and a noise burst shaped by the aperiodic envelope,
+// both from the envelope and aperiodicity interpolated between the two surrounding
+// frames; responses are causal, starting at the pulse.
+// Pulses are rendered kBatch at a time, one per lane of structure-of-arrays buffers
+// transformed by a BatchFFTPlan, so liftering, the logs, exponentials and phases of the
+// spectra (utils/VectorMath.h), spectral products and the FFT butterflies all vectorize
+// across pulses. Per pulse that is four transforms instead of six: both
+// minimum-phase spectra come out of one inverse/forward pair (the periodic log spectrum
+// in the real part, the aperiodic one in the imaginary part) and one inverse transform
+// yields both responses. A lane's result does not depend on its neighbours.
+// The schedule depends only on the F0 track and each pulse's noise only on its index,
+// so any subset of pulses renders exactly as it would within the whole utterance. That
+// is what lets RealtimeSynthesizer stream pulses and synthesize() split the utterance
+// into segments rendered in parallel.
+// Instances own FFT scratch: one per thread.
+class PulseVocoder {
+public:
+    explicit PulseVocoder(const PulseVocoderConfig& config);
+
+    const PulseVocoderConfig& config() const { return config_; }
+    size_t bins() const { return bins_; }
+    size_t fftSize() const { return config_.fftSize; }
+
+    // The pulse at `time` given the F0 of the surrounding frames (0 = unvoiced); the next
+    // one is at time + period.
+    static VocoderPulse pulseAt(double time, uint64_t index, double hopSize, double f0a, double f0b,
+                                uint32_t sampleRate, size_t fftSize);
+
+    static constexpr size_t kBatch = 8;
+
+    // Load a pulse into lane (< kBatch) for the next render(): the spectra of frames a and
+    // b blended with pulse.weight.
+    void load(size_t lane, const VocoderPulse& pulse, const double* envA, const double* envB,
+              const double* apA, const double* apB);
+    void load(size_t lane, const VocoderPulse& pulse, const float* envA, const float* envB,
+              const float* apA, const float* apB);
+    // Render the pulses in lanes [0, count); their responses stay valid until the next
+    // render().
+    void render(size_t count);
+    // Add lane's response (fftSize() samples from the pulse on) to buffer[(at + i) & mask].
+    void addResponse(size_t lane, float* buffer, size_t at, size_t mask = ~size_t(0)) const;
+
+    // Offline synthesis of frames [0, f0.size()) into ceil(frames * hopSize) samples.
+    // env/ap have one row per frame and fftSize/2+1 columns (Float32 or Float64).
+    // With a pool, the pulse schedule is cut into `segments` runs (0 = four per thread)
+    // rendered concurrently and overlap-added; the result equals the serial one up to
+    // floating-point summation order where segment tails overlap.
+    static bool synthesize(const std::vector<float>& f0, const FeatureMatrix& env, const FeatureMatrix& ap,
+                           const PulseVocoderConfig& config, std::vector<float>& out,
+                           ThreadPool* pool = nullptr, size_t segments = 0);
+
+private:
+    static constexpr size_t L = kBatch;
+    template <typename T> void loadImpl(size_t lane, const VocoderPulse& pulse, const T* envA, const T* envB,
+                                        const T* apA, const T* apB);
+
+    PulseVocoderConfig config_;
+    size_t bins_;
+    fft::BatchFFTPlan<kBatch> plan_;
+    std::vector<float> dcRemover_;
+    // fftSize x kBatch, lane-interleaved: power -> log spectra -> cepstra -> minimum-phase spectra
+    // (periodic in p, aperiodic in z), noise spectrum -> responses in n.
+    std::vector<float> zRe_, zIm_, pRe_, pIm_, nRe_, nIm_, scratch_;
+    float gain_[kBatch]{};           // periodic gain, 0 where the lane is not periodic
+    size_t noiseSize_[kBatch]{};
+    uint64_t index_[kBatch]{};
+};
+
+} // namespace vv
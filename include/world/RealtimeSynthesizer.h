@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/PostFilterChain.h"
+#include "world/PulseVocoder.h"
+
+namespace vv {
+
+class MelCepstrumCodec;
+class BandAperiodicityCodec;
+
+struct RealtimeSynthesisConfig {
+    uint32_t sampleRate{48000};
+    size_t fftSize{2048};     // envelope/aperiodicity rows have fftSize/2+1 values
+    double hopSize{240.0};    // samples between frames
+    size_t blockSize{256};    // samples per pull()
+    size_t maxFrames{64};     // frames the queue holds (at least 4)
+    uint64_t seed{0x9E3779B97F4A7C15ull}; // aperiodic noise
+};
+
+// Incremental WORLD-style vocoder: frames (f0, spectral envelope, aperiodicity) are pushed
+// as they become available and audio is pulled in fixed-size blocks, with the pulse
+// schedule and overlap-add state carried across calls.
+// - Pulses are rendered by PulseVocoder, so the stream equals PulseVocoder::synthesize()
+//   of the same frames. Its responses are causal, so nothing after a pulse needs to be
+//   known to render it.
+// - All buffers are allocated by the constructor; pull() neither allocates nor locks.
+// - One producer thread may push while one consumer thread pulls: the frame queue is a
+//   single-producer/single-consumer ring. reset() needs both sides idle.
+class RealtimeSynthesizer {
+public:
+    explicit RealtimeSynthesizer(const RealtimeSynthesisConfig& config);
+    ~RealtimeSynthesizer();
+
+    RealtimeSynthesizer(const RealtimeSynthesizer&) = delete;
+    RealtimeSynthesizer& operator=(const RealtimeSynthesizer&) = delete;
+
+    const RealtimeSynthesisConfig& config() const { return config_; }
+    size_t bins() const { return bins_; }
+
+    // Algorithmic latency in samples: a block can be pulled once the frames up to
+    // latencySamples() past its first sample have been pushed (one hop of interpolation
+    // look-ahead plus the block itself). Independent of the signal.
+    size_t latencySamples() const;
+
+    // Producer side. False if the queue is full (pull some audio first) or finish() was
+    // called. env/ap hold bins() values.
+    bool pushFrame(double f0, const double* env, const double* ap);
+    bool pushFrame(double f0, const float* env, const float* ap);
+    // Push frames [first, ...) of an analysed packet (f0 plus full or compact spectra of
+    // bins() columns) until the queue is full; returns the number pushed. Compact spectra
+    // are decoded here, on the producer side.
+    size_t pushFrames(const DataPacket& pkt, size_t first = 0);
+    // No more frames: the last one is held to its hop's end and the tails then decay.
+    void finish();
+    size_t framesPushed() const { return head_.load(std::memory_order_acquire); }
+    size_t freeFrames() const;
+
+    // Consumer side. True if the next block's frames are queued, or finish() was called
+    // and audio is still decaying.
+    bool ready() const;
+    // Write blockSize() samples. On underrun (not ready()) the block is silent, the
+    // timeline does not advance and false is returned; likewise once drained().
+    bool pull(float* out);
+    bool drained() const;
+    size_t samplesPulled() const { return position_; }
+    size_t underruns() const { return underruns_; }
+
+    // Post-filters run on every pulled block (prepared here for mono at sampleRate).
+    // The chain belongs to this stream while set; null removes it.
+    void setPostFilters(std::shared_ptr<PostFilterChain> chain);
+
+    // Back to an empty timeline; post-filter state is reset too.
+    void reset();
+
+private:
+    template <typename T> bool pushImpl(double f0, const T* env, const T* ap);
+    size_t requiredFrames(size_t end) const;
+
+    RealtimeSynthesisConfig config_;
+    PulseVocoder vocoder_;
+    size_t bins_;
+    size_t ringMask_;
+
+    // Frame queue: slot i % maxFrames holds frame i.
+    std::vector<double> qf0_;
+    std::vector<double> qenv_;
+    std::vector<double> qap_;
+    std::atomic<size_t> head_{0}; // frames pushed
+    std::atomic<size_t> tail_{0}; // frames the consumer no longer needs
+    std::atomic<bool> finished_{false};
+
+    // Consumer state.
+    size_t position_{0};     // samples pulled
+    double nextPulse_{0.0};  // sample time of the next pulse
+    uint64_t pulses_{0};     // pulses rendered
+    size_t underruns_{0};
+    std::vector<float> ola_; // overlap-add ring, ringMask_ + 1 samples
+    std::shared_ptr<PostFilterChain> postFilters_;
+
+    // Producer-side decoders for compact packets, built on first use.
+    std::unique_ptr<MelCepstrumCodec> mcep_;
+    std::unique_ptr<BandAperiodicityCodec> bap_;
+    std::vector<double> decodedEnv_, decodedAp_;
+};
+
+} // namespace vv
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/FeatureMatrix.h"
+
+namespace vv {
+
+// Compact stand-ins for the per-bin envelope and aperiodicity matrices, a few dozen floats
+// per frame instead of fft_size/2+1 doubles each:
+// - the envelope as a warped (mel-like) cepstrum: the log power spectrum, resampled onto
+//   an all-pass-warped frequency axis, expanded in `order` cosine terms;
+// - the aperiodicity as band values in dB every bandHz from 0 Hz to Nyquist (at least
+//   those two), linear in between; the encoder is the least-squares fit of that
+//   interpolation.
+// Both codecs are immutable tables built once per shape, after which encoding and
+// decoding a frame are small matrix-vector products written as unit-stride loops the
+// compiler vectorizes. Share one codec across threads.
+
+// Warping constant whose all-pass frequency map approximates the mel scale at sr
+// (0.42 at 16 kHz, 0.55 at 48 kHz).
+double melCepstrumAlpha(uint32_t sampleRate);
+
+class MelCepstrumCodec {
+public:
+    MelCepstrumCodec(size_t bins, size_t order, double alpha);
+
+    size_t bins() const { return bins_; }
+    size_t order() const { return order_; }
+    double alpha() const { return alpha_; }
+
+    // env: bins() power values; cep: order() coefficients.
+    void encode(const double* env, float* cep) const;
+    void encode(const float* env, float* cep) const;
+    void decode(const float* cep, double* env) const;
+    void decode(const float* cep, float* env) const;
+
+private:
+    template <typename T> void encodeImpl(const T* env, float* cep) const;
+    template <typename T> void decodeImpl(const float* cep, T* env) const;
+
+    size_t bins_;
+    size_t order_;
+    double alpha_;
+    std::vector<float> analysis_;  // bins x order: coefficient weights of each bin's log power
+    std::vector<float> synthesis_; // order x bins: each coefficient's contribution to every bin
+};
+
+class BandAperiodicityCodec {
+public:
+    BandAperiodicityCodec(size_t bins, uint32_t sampleRate, double bandHz = 3000.0);
+
+    size_t bins() const { return bins_; }
+    size_t bands() const { return bands_; }
+    double bandHz() const { return bandHz_; }
+
+    // ap: bins() values in [0, 1]; db: bands() values.
+    void encode(const double* ap, float* db) const;
+    void encode(const float* ap, float* db) const;
+    void decode(const float* db, double* ap) const;
+    void decode(const float* db, float* ap) const;
+
+private:
+    template <typename T> void encodeImpl(const T* ap, float* db) const;
+    template <typename T> void decodeImpl(const float* db, T* ap) const;
+
+    size_t bins_;
+    size_t bands_;
+    double bandHz_;
+    std::vector<float> analysis_; // bins x bands: least-squares weights of each bin's dB value
+    std::vector<uint32_t> lo_;    // per bin: lower band centre for interpolation
+    std::vector<float> frac_;     // per bin: position between lo_ and lo_ + 1
+};
+
+// Replace a packet's SpectralEnvelope and Aperiodicity matrices with their MelCepstrum and
+// BandAperiodicity codes (Float32, one row per frame), recording the codec parameters as
+// scalars (MelCepstrumAlpha, BandAperiodicityHz, WorldFftSize). False if the packet has no
+// envelope/aperiodicity pair of equal shape.
+bool encodeSpectralFeatures(DataPacket& pkt, size_t order, double alpha = 0.0, double bandHz = 3000.0);
+// Full fft_size/2+1 matrices back from a packet's codes, of the given element type.
+// False if the packet does not carry both codes.
+bool decodeSpectralFeatures(const DataPacket& pkt, ElementType type, FeatureMatrix& env, FeatureMatrix& ap,
+                            std::pmr::memory_resource* mem = nullptr);
+
+} // namespace vv
@@ -3,6 +3,10 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <fstream>
+
+#include "core/DataPacket.h"
+#include "core/FeatureMatrix.h"
 
 namespace vv {
 
@@ -13,21 +17,87 @@ struct UtauWorldMeta {
     int frames{0};
     double framePeriodMs{5.0};
     size_t sampleCount{0};
+    // First analysed sample when only part of the recording was analysed: frame i is at
+    // sample startSample + i * hop. Files written before this field read as 0.
+    size_t startSample{0};
+    // Compact spectra (see SpectralCodec.h): with cepstrumOrder > 0 the directory holds
+    // mcep.bin (frames x cepstrumOrder) and bap.bin (frames x apBands) as float32 in place
+    // of sp.bin and ap.bin; bins and fftSize still describe the decoded spectra.
+    int cepstrumOrder{0};
+    double cepstrumAlpha{0.0};
+    int apBands{0};
+    double apBandHz{0.0};
+};
+
+// UTAU frequency map (.frq), shipped next to each voicebank sample: one F0 value (Hz,
+// 0 = unvoiced) and one amplitude per block of samplesPerFrame samples; value i
+// describes the signal from sample i * samplesPerFrame.
+struct UtauFrq {
+    int32_t samplesPerFrame{256};
+    double averageF0{0.0};
+    std::vector<double> f0;
+    std::vector<double> amplitude;
 };
 
-// Simple UTAU-compatible WORLD IO (text f0 + binary sp/ap as double, row-major [T x bins])
+// Simple UTAU-compatible WORLD IO (text f0 + binary sp/ap as double, row-major [T x bins],
+// or compact mcep/bap as float32)
 namespace UtauWorldIO {
     // Write one value per line (text)
     bool writeF0Txt(const std::string& path, const std::vector<float>& f0);
     bool readF0Txt(const std::string& path, std::vector<float>& f0);
 
-    // Binary little-endian double matrices (row-major T*bins)
-    bool writeBinMatrix(const std::string& path, const std::vector<float>& flat, int frames, int bins);
-    bool readBinMatrix(const std::string& path, std::vector<float>& flat, int& frames, int& bins);
+    // Binary little-endian matrices of `stored` elements (row-major T*bins, no row padding).
+    // The file carries no shape; readBinMatrix takes bins from meta.json and derives T.
+    bool writeBinMatrix(const std::string& path, const FeatureMatrix& m, ElementType stored = ElementType::Float64);
+    bool readBinMatrix(const std::string& path, int bins, FeatureMatrix& m, ElementType stored = ElementType::Float64);
 
     // Metadata JSON for safe round-trip
     bool writeMetaJson(const std::string& path, const UtauWorldMeta& m);
     bool readMetaJson(const std::string& path, UtauWorldMeta& m);
+
+    // Write f0.txt, sp.bin, ap.bin (or mcep.bin, bap.bin for compact spectra) and
+    // meta.json for a WorldAnalysisNode output into dir (which must exist). hopSize is
+    // used when the packet does not record its own.
+    bool writeAnalysis(const std::string& dir, const DataPacket& analysed, size_t hopSize,
+                       size_t sampleCount, size_t startSample = 0);
+    // Read a directory written by writeAnalysis or UtauWorldStreamWriter into a sample-less
+    // packet ready for WorldSynthesisNode.
+    bool readAnalysis(const std::string& dir, DataPacket& pkt, UtauWorldMeta& meta);
+
+    // .frq files ("FREQ0003"): a 40-byte header (magic, int32 samples per value, double
+    // average F0, 16 reserved bytes, int32 value count) followed by (double f0, double
+    // amplitude) pairs, little-endian. readFrq loads the file in one read and rejects it
+    // if its size disagrees with the count.
+    bool readFrq(const std::string& path, UtauFrq& frq);
+    bool writeFrq(const std::string& path, const UtauFrq& frq);
+    // .frq for an analysed recording: f0 (one value every f0Hop samples) resampled to the
+    // .frq grid, amplitude the mean absolute sample per block on the 16-bit scale, and
+    // averageF0 the mean of the voiced values.
+    UtauFrq makeFrq(const std::vector<float>& samples, const std::vector<float>& f0, double f0Hop,
+                    int32_t samplesPerFrame = 256);
+    // Attach frq's F0 track to an analysis input (see WorldParams::externalF0) whose first
+    // sample is sample startSample of the recording the .frq describes.
+    void attachFrq(DataPacket& input, const UtauFrq& frq, size_t startSample = 0);
+    // UTAU's name for a sample's frequency map: "dir/a.wav" -> "dir/a_wav.frq".
+    std::string frqPathFor(const std::string& wavPath);
 }
 
+// Incremental writer for the same files: append() takes consecutive analysis blocks
+// (e.g. from ChunkedAnalysisSource) and appends their f0 values and sp/ap (or mcep/bap)
+// rows, so a long recording never has to be held in memory. close() writes meta.json
+// with the accumulated frame count. The result is identical to writing the whole
+// analysis at once.
+class UtauWorldStreamWriter {
+public:
+    bool open(const std::string& dir, uint32_t sampleRate, double framePeriodMs);
+    bool append(const DataPacket& block);
+    bool close(size_t sampleCount);
+    size_t frames() const { return meta_.frames > 0 ? static_cast<size_t>(meta_.frames) : 0; }
+
+private:
+    std::string dir_;
+    std::ofstream f0_, sp_, ap_;
+    UtauWorldMeta meta_{};
+};
+
 } // namespace vv
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/DataPacket.h"
+#include "core/PacketDiskCache.h"
+#include "world/WorldAnalysisNode.h"
+
+namespace vv {
+
+// One oto.ini line: "name.wav=alias,offset,consonant,cutoff,preutterance,overlap", times
+// in milliseconds. offset is measured from the start of the file; a positive cutoff is
+// measured back from the end of the file, a negative one forward from offset.
+struct OtoEntry {
+    std::string file; // as written, relative to the oto.ini's directory ('/' separated)
+    std::string alias;
+    double offsetMs{0.0};
+    double consonantMs{0.0};
+    double cutoffMs{0.0};
+    double preutterMs{0.0};
+    double overlapMs{0.0};
+
+    // Region the entry uses, in ms, for a file of durationMs (end <= begin if inconsistent).
+    double beginMs() const { return offsetMs; }
+    double endMs(double durationMs) const { return cutoffMs < 0.0 ? offsetMs - cutoffMs : durationMs - cutoffMs; }
+};
+
+namespace OtoIni {
+    // Lines may end in CRLF and the file may start with a UTF-8 BOM. Names and aliases are
+    // kept as raw bytes (voicebanks are usually Shift-JIS): splitting on '=' and ',' is
+    // safe in Shift-JIS, and a '\' is only read as a path separator where it is not the
+    // second byte of a double-byte character. Lines without '=' are skipped; missing
+    // numeric fields are 0.
+    bool parse(const std::string& text, std::vector<OtoEntry>& entries);
+    bool read(const std::string& path, std::vector<OtoEntry>& entries);
+}
+
+struct VoicebankOptions {
+    // Analysis parameters; sampleRate and the 5 ms hop are set per file.
+    WorldParams params{};
+    // Files analysed at once (0 = one per hardware thread). Each file is analysed serially.
+    // With WORLD linked its estimator calls take turns (see worldMutex()), so only reading,
+    // encoding and writing overlap; the output matches a serial run either way.
+    unsigned threads{0};
+    // Analyse only from the earliest oto offset to the latest cutoff of each file, plus the
+    // context the estimators need; meta.json's startSample records where that begins.
+    bool otoRegions{false};
+    // Use <name>_wav.frq next to a WAV as its F0 track when present.
+    bool useFrq{false};
+    // Also write the analysed F0 as <outDir>/<relative>_wav.frq, mirroring the bank's
+    // layout so the files can be copied next to the samples.
+    bool writeFrq{false};
+    std::shared_ptr<PacketDiskCache> cache{};
+};
+
+struct VoicebankProgress {
+    size_t done{0};
+    size_t total{0};
+    size_t failed{0};
+    double audioSeconds{0.0};   // audio analysed so far
+    double elapsedSeconds{0.0};
+};
+
+// Analyses every WAV an oto.ini references. oto.ini files are collected from the bank
+// directory and all its subdirectories; each referenced WAV is analysed once however many
+// aliases use it, into <outDir>/<path relative to the bank without .wav>/ in the format
+// UtauWorldIO reads. Files run concurrently on a thread pool, largest first.
+class VoicebankAnalyzer {
+public:
+    struct File {
+        std::string wav;      // path on disk
+        std::string relative; // relative to the bank directory, without the extension
+        std::vector<OtoEntry> entries;
+    };
+    // Called after every file, from the thread that analysed it (calls are serialized).
+    using ProgressFn = std::function<void(const VoicebankProgress& progress, const File& file, bool ok)>;
+
+    VoicebankAnalyzer(std::string bankDir, std::string outDir, VoicebankOptions options = {});
+
+    // Find and parse the oto.ini files; false if there are none or none can be read.
+    bool load();
+    const std::vector<File>& files() const { return files_; }
+    size_t entryCount() const { return entries_; }
+
+    // Analyse all files; false if any failed (see failures()).
+    bool run(const ProgressFn& progress = nullptr);
+    const std::vector<std::string>& failures() const { return failures_; }
+    const VoicebankProgress& progress() const { return progress_; }
+
+private:
+    bool analyseFile(const File& file, double& audioSeconds) const;
+
+    std::string bankDir_;
+    std::string outDir_;
+    VoicebankOptions options_;
+    std::vector<File> files_;
+    size_t entries_{0};
+    std::vector<std::string> failures_;
+    VoicebankProgress progress_{};
+};
+
+} // namespace vv
@@ -2,19 +2,85 @@
 
 #include "core/ISynthesisNode.h"
 #include "core/DataPacket.h"
+#include "core/PacketDiskCache.h"
+#include "core/ThreadPool.h"
+#include "utils/Hash.h"
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace vv {
 
+// F0 estimator used by the WORLD analysis path, from most accurate to fastest:
+// Harvest; a DIO + StoneMask pass that Harvest re-estimates on voiced regions only;
+// DIO + StoneMask alone. The placeholder (non-WORLD) build has a single estimator and
+// only honours the F0 range.
+enum class F0Method : uint8_t { Harvest = 0, DioHarvest = 1, Dio = 2 };
+
+inline const char* f0MethodName(F0Method m) {
+    switch (m) {
+    case F0Method::Dio: return "dio";
+    case F0Method::DioHarvest: return "dio-harvest";
+    default: return "harvest";
+    }
+}
+inline bool parseF0Method(const std::string& s, F0Method& out) {
+    for (F0Method m : {F0Method::Harvest, F0Method::DioHarvest, F0Method::Dio}) {
+        if (s == f0MethodName(m)) { out = m; return true; }
+    }
+    return false;
+}
+
+// Input feature holding a precomputed F0 track (Hz, 0 = unvoiced), and the scalar giving
+// its spacing in samples; see WorldParams::externalF0 and UtauWorldIO::attachFrq().
+inline constexpr const char* kExternalF0Feature = "external_f0";
+inline constexpr const char* kExternalF0HopScalar = "external_f0_hop";
+
 struct WorldParams {
     uint32_t sampleRate{48000};
     size_t frameSize{1024};
     size_t hopSize{256};
+    F0Method f0Method{F0Method::Harvest};
+    double f0Floor{50.0};  // Hz; also the lowest F0 CheapTrick's window is sized for
+    double f0Ceil{1100.0}; // Hz
+    // DIO's filter-bank channels per octave (WORLD's channels_in_octave); more is
+    // slower and more robust. Harvest's channel count is fixed inside WORLD.
+    double f0Channels{2.0};
+    // Take F0 from the input's kExternalF0Feature track (e.g. a voicebank's .frq),
+    // resampled to the frame grid, instead of estimating it; the envelope and
+    // aperiodicity are computed against that track. Inputs without a track, such as
+    // ChunkedAnalysisSource windows, are estimated with f0Method as usual.
+    bool externalF0{false};
+    // > 0: emit the envelope and aperiodicity as a warped cepstrum of this order and band
+    // aperiodicity (FeatureKey::MelCepstrum / BandAperiodicity, see SpectralCodec.h)
+    // instead of full fft_size/2+1 matrices. WorldSynthesisNode decodes them on the fly.
+    size_t cepstrumOrder{0};
+    // Time-parallel analysis of the fallback estimators: 1 = serial; N = up to N threads;
+    // 0 = one per hardware thread. WORLD's estimators always run serially (see
+    // WorldAnalysisNode). Frame ranges of framesPerTask frames are the unit of work,
+    // serial or not. The thread count never changes the result, so it is not hashed;
+    // framesPerTask can (in WORLD's last bits) and is.
+    unsigned analysisThreads{1};
+    size_t framesPerTask{64};
 };
 
-// Analysis node: extracts F0, spectral envelope, aperiodicity
+// Analysis node: extracts F0, spectral envelope, aperiodicity.
+// The per-frame estimators (CheapTrick and D4C, or the placeholder estimators) always
+// run over ranges of WorldParams::framesPerTask frames. The placeholder ranges run on a
+// thread pool when analysisThreads != 1, otherwise in order on the calling thread; each
+// range is computed by the same calls, so the output is bit-identical for any thread
+// count. WORLD's ranges always run in order on the calling thread: CheapTrick and D4C
+// re-seed and draw from a process-global 1e-12 safeguard noise generator on every call,
+// which is not safe to share between threads, and which makes a different framesPerTask
+// change the last bits.
+// Held around every call into WORLD (analysis and synthesis): its estimators and
+// Synthesis share a process-global noise generator, so concurrent calls from different
+// nodes, clones or files would race on it. Each call re-seeds it, so serialized calls
+// give the same output as a single-threaded run whatever order they take.
+std::mutex& worldMutex();
+
 class WorldAnalysisNode : public ISynthesisNode {
 public:
     explicit WorldAnalysisNode(WorldParams p = {}) : params_(p) { setName("WorldAnalysisNode"); }
@@ -23,14 +89,86 @@ public:
 
     std::shared_ptr<DataPacket> process(const std::shared_ptr<const DataPacket>& input) override;
 
+    // Replicas share this node's pool, created here if need be, so lane replicas in
+    // ComputationGraph::executeBatch() do not each start their own.
+    std::shared_ptr<ISynthesisNode> clone() const override {
+        auto c = std::make_shared<WorldAnalysisNode>(params_);
+        c->setId(id_); c->setName(name_);
+        c->memory_ = memory_;
+        analysisPool();
+        c->pool_ = sharedPool();
+        c->diskCache_ = diskCache_;
+        return c;
+    }
+
+    bool parameterHash(uint64_t& h) const override {
+        h = hash::value(params_.sampleRate);
+        h = hash::combine(h, hash::value(params_.frameSize));
+        h = hash::combine(h, hash::value(params_.hopSize));
+        h = hash::combine(h, hash::value(params_.f0Method));
+        h = hash::combine(h, hash::value(params_.f0Floor));
+        h = hash::combine(h, hash::value(params_.f0Ceil));
+        h = hash::combine(h, hash::value(params_.f0Channels));
+        h = hash::combine(h, hash::value(params_.externalF0));
+        h = hash::combine(h, hash::value(params_.cepstrumOrder));
+        h = hash::combine(h, hash::value(params_.framesPerTask));
+        return true;
+    }
+
     std::vector<std::string> getInputs() const override { return {"wav"}; }
     std::vector<std::string> getOutputs() const override { return {"f0", "spectral_envelope", "aperiodicity"}; }
 
     void setParams(const WorldParams& p) { params_ = p; }
     const WorldParams& params() const { return params_; }
 
+    // Signal the estimators read around a frame, in samples before the frame's position
+    // and after it. A frame computed from a window holding this much context on both
+    // sides does not depend on where the window was cut (see ChunkedAnalysisSource).
+    struct Context {
+        size_t before{0};
+        size_t after{0};
+    };
+    Context analysisContext(uint32_t sampleRate) const;
+    // Frames process() emits for a mono input of `samples` samples (the longest per-frame
+    // output when estimators disagree on the count).
+    size_t frameCount(size_t samples, uint32_t sampleRate) const;
+
+    // Pool for the parallel mode; by default the node creates its own on first use (or
+    // clone()), shared with its clones.
+    void setThreadPool(std::shared_ptr<ThreadPool> pool) {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        pool_ = std::move(pool);
+    }
+    std::shared_ptr<ThreadPool> threadPool() const { return sharedPool(); }
+
+    // Persistent analysis cache shared across runs and processes (nullptr = none). Results
+    // are keyed by the input's content hash, parameterHash() and kAnalysisVersion, so a
+    // changed signal, parameter or estimator never hits a stale entry.
+    void setDiskCache(std::shared_ptr<PacketDiskCache> cache) { diskCache_ = std::move(cache); }
+    const std::shared_ptr<PacketDiskCache>& diskCache() const { return diskCache_; }
+    // Bump whenever an estimator's output changes for the same input and parameters.
+    static constexpr uint32_t kAnalysisVersion = 2;
+    uint64_t diskCacheKey(const DataPacket& input) const;
+
+    // Allocator for output matrices and WORLD scratch buffers (nullptr = default heap),
+    // e.g. an Arena reset once per render. Must outlive the packets this node produces.
+    void setMemoryResource(std::pmr::memory_resource* r) { memory_ = r; }
+    std::pmr::memory_resource* memoryResource() const { return memory_; }
+
 private:
+    std::shared_ptr<DataPacket> analyse(const std::shared_ptr<const DataPacket>& input);
+    std::shared_ptr<DataPacket> estimate(const std::shared_ptr<const DataPacket>& input);
+    ThreadPool* analysisPool() const;
+    std::shared_ptr<ThreadPool> sharedPool() const {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        return pool_;
+    }
+
     WorldParams params_{};
+    std::pmr::memory_resource* memory_{nullptr};
+    std::shared_ptr<PacketDiskCache> diskCache_{};
+    mutable std::mutex poolMutex_;
+    mutable std::shared_ptr<ThreadPool> pool_{}; // guarded by poolMutex_
 };
 
 } // namespace vv
@@ -3,7 +3,12 @@
 #include "core/ISynthesisNode.h"
 #include "core/DataPacket.h"
 #include "core/IPostFilter.h"
+#include "core/PostFilterChain.h"
+#include "core/ThreadPool.h"
+#include "world/RealtimeSynthesizer.h"
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -18,6 +23,22 @@ public:
 
     std::shared_ptr<DataPacket> process(const std::shared_ptr<const DataPacket>& input) override;
 
+    // Streaming: the synthesis engine and post-filter state carry over between blocks.
+    // Blocks with F0 and spectra (full or compact) feed one RealtimeSynthesizer per
+    // stream, so pulses, noise and overlap-add tails run on across block boundaries.
+    // A block returns the samples whose frames have all arrived (the engine needs one
+    // frame of look-ahead); the block marked last flushes the rest, so the concatenated
+    // blocks equal process() rendered with PulseVocoder. WORLD's Synthesis cannot carry
+    // state between calls, so streamed spectra always render with PulseVocoder, even
+    // when WORLD is linked and setNativeSynthesis(false).
+    void beginStream() override;
+    std::shared_ptr<DataPacket> processBlock(const std::shared_ptr<const DataPacket>& block,
+                                             const StreamBlock& info) override;
+
+    // Clones the post-filter chain too; returns null if any filter cannot be cloned.
+    // Replicas share this node's synthesis pool, created here if need be.
+    std::shared_ptr<ISynthesisNode> clone() const override;
+
     std::vector<std::string> getInputs() const override { return {"f0", "spectral_envelope", "aperiodicity"}; }
     std::vector<std::string> getOutputs() const override { return {"wav"}; }
 
@@ -25,15 +46,59 @@ public:
     void enablePostFilter(bool enabled) { postFilterEnabled_ = enabled; }
     bool isPostFilterEnabled() const { return postFilterEnabled_; }
 
-    void clearPostFilters() { filters_.clear(); prepared_ = false; }
-    void addPostFilter(std::shared_ptr<IPostFilter> filter) { if (filter) filters_.push_back(std::move(filter)); }
+    void clearPostFilters() { postFilters_.clear(); }
+    void addPostFilter(std::shared_ptr<IPostFilter> filter) { postFilters_.add(std::move(filter)); }
+    // The chain itself, for per-filter bypass and tiling.
+    PostFilterChain& postFilters() { return postFilters_; }
+    const PostFilterChain& postFilters() const { return postFilters_; }
+
+    // Packets with F0 and spectra (full or compact) are rendered by the in-tree
+    // PulseVocoder, a batched structure-of-arrays kernel, unless WORLD is linked: then
+    // WORLD's Synthesis renders them, or PulseVocoder if setNativeSynthesis(true).
+    void setNativeSynthesis(bool native) { nativeSynthesis_ = native; }
+    bool nativeSynthesis() const { return nativeSynthesis_; }
+
+    // Offline synthesis threads for PulseVocoder (1 = serial, the default; 0 = one per
+    // hardware thread): its segments are rendered concurrently and overlap-added to the
+    // serial result (see PulseVocoder::synthesize). The thread count never selects the
+    // synthesizer. WORLD's Synthesis cannot be split (its pulse phase runs from the start
+    // of the utterance and its noise generator is process-global), so with WORLD linked
+    // and setNativeSynthesis(false) it renders serially whatever this is set to; choose
+    // native synthesis to render in parallel. Streaming blocks are rendered serially.
+    void setSynthesisThreads(unsigned threads) { synthesisThreads_ = threads; }
+    unsigned synthesisThreads() const { return synthesisThreads_; }
+    // Share an existing pool instead of creating one on first use.
+    void setThreadPool(std::shared_ptr<ThreadPool> pool) {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        pool_ = std::move(pool);
+    }
+    std::shared_ptr<ThreadPool> threadPool() const {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        return pool_;
+    }
+
+    // Allocator for WORLD scratch buffers (nullptr = default heap).
+    void setMemoryResource(std::pmr::memory_resource* r) { memory_ = r; }
+    std::pmr::memory_resource* memoryResource() const { return memory_; }
 
 private:
+    std::shared_ptr<DataPacket> render(const std::shared_ptr<const DataPacket>& input, float& phase, bool parallel);
+    bool renderNative(const DataPacket& input, bool parallel, std::vector<float>& out);
+    bool renderStream(const DataPacket& block, bool last, std::vector<float>& out);
+    void applyPostFilters(DataPacket& out);
+    ThreadPool* synthesisPool() const;
+
+    std::pmr::memory_resource* memory_{nullptr};
+    float streamPhase_{0.0f};
+    std::unique_ptr<RealtimeSynthesizer> stream_; // created by the first spectral block
+    size_t streamFrames_{0};                      // frames pushed into stream_
+    std::vector<float> streamBlock_;
+    unsigned synthesisThreads_{1};
+    bool nativeSynthesis_{false};
+    mutable std::mutex poolMutex_;
+    mutable std::shared_ptr<ThreadPool> pool_{}; // guarded by poolMutex_
     bool postFilterEnabled_{false};
-    bool prepared_{false};
-    uint32_t preparedSampleRate_{0};
-    uint16_t preparedChannels_{0};
-    std::vector<std::shared_ptr<IPostFilter>> filters_;
+    PostFilterChain postFilters_;
 };
 
 } // namespace vv
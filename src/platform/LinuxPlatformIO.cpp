@@ -1,16 +1,81 @@
 #include "core/IPlatformIO.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VV_HAVE_MMAP 1
+#endif
+
 namespace vv {
 
 namespace {
 struct Deleter {
     void operator()(std::byte* p) const noexcept { delete[] p; }
 };
+
+// Anonymous page mappings; the kernel hands them out zero-filled and returns them on
+// munmap, so large matrices never fragment the malloc heap.
+class PageResource : public std::pmr::memory_resource {
+public:
+    explicit PageResource(bool hugePages) : huge_(hugePages) {}
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+#ifdef VV_HAVE_MMAP
+        if (align > pageSize()) throw std::bad_alloc();
+        const size_t size = roundUp(bytes);
+        void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (huge_) p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (p == MAP_FAILED) {
+            p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            if (huge_) ::madvise(p, size, MADV_HUGEPAGE); // transparent huge pages, best effort
+#endif
+        }
+        return p;
+#else
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+#endif
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+#ifdef VV_HAVE_MMAP
+        (void)align;
+        ::munmap(p, roundUp(bytes));
+#else
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+#endif
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+#ifdef VV_HAVE_MMAP
+    static size_t pageSize() {
+        static const size_t ps = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return ps;
+    }
+    size_t roundUp(size_t bytes) const {
+        const size_t unit = huge_ ? (size_t(2) << 20) : pageSize();
+        return (std::max<size_t>(bytes, 1) + unit - 1) / unit * unit;
+    }
+#endif
+
+    bool huge_;
+};
 }
 
 class LinuxPlatformIO : public IPlatformIO {
@@ -34,6 +99,30 @@ public:
         return ofs.good();
     }
 
+    MappedFile mapFile(const std::string& path) override {
+        MappedFile mf;
+#ifdef VV_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return mf;
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) { ::close(fd); return mf; }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference
+        if (addr == MAP_FAILED) return mf;
+        mf.data = static_cast<const std::byte*>(addr);
+        mf.size = size;
+        mf.owner = std::shared_ptr<const void>(addr, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+#else
+        auto buf = std::make_shared<std::vector<std::byte>>(readFile(path));
+        if (buf->empty()) return mf;
+        mf.data = buf->data();
+        mf.size = buf->size();
+        mf.owner = buf;
+#endif
+        return mf;
+    }
+
     MemoryBlock allocateMemory(size_t bytes) override {
         auto* raw = new std::byte[bytes]{};
         return MemoryBlock{ std::unique_ptr<std::byte[], void(*)(std::byte*)>(raw, [](std::byte* p){ delete[] p; }), bytes };
@@ -45,6 +134,14 @@ public:
             block.size = 0;
         }
     }
+
+    std::pmr::memory_resource* pageResource(bool hugePages) override {
+        return hugePages ? &hugePages_ : &pages_;
+    }
+
+private:
+    PageResource pages_{false};
+    PageResource hugePages_{true};
 };
 
 std::unique_ptr<IPlatformIO> makePlatformIO() {
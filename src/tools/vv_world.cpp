@@ -3,8 +3,18 @@
 #include <vector>
 #include <memory>
 #include <cmath>
+#include <chrono>
+#include <cstdlib>
 
+#include "core/ComputationGraph.h"
 #include "core/DataPacket.h"
+#include "core/GraphTrace.h"
+#include "core/IPlatformIO.h"
+#include "core/MemoryResource.h"
+#include "core/PacketDiskCache.h"
+#include "world/ChunkedAnalysis.h"
+#include "world/RealtimeSynthesizer.h"
+#include "world/Voicebank.h"
 #include "world/WorldAnalysisNode.h"
 #include "world/WorldSynthesisNode.h"
 #include "world/UtauWorldInterface.h"
@@ -14,73 +24,273 @@ using namespace vv;
 
 static void print_usage() {
     std::cout << "Usage:\n"
-              << "  vv_world analyze <wav> <out_dir>\n"
-              << "  vv_world synth <out_dir> <out_wav>\n"
-              << "Notes: analyze writes f0.txt, sp.bin, ap.bin, meta.json under out_dir.\n";
+              << "  vv_world analyze <wav> <out_dir> [options]\n"
+              << "  vv_world analyze-bank <voicebank_dir> <out_dir> [options]\n"
+              << "  vv_world synth <out_dir> <out_wav> [options]\n"
+              << "Options:\n"
+              << "  --trace <file.json>   record per-node timings, write a Chrome trace and print a summary\n"
+              << "  --threads <n>         analyze: split the time axis across n threads (0 = all cores;\n"
+              << "                        in-tree estimators only: with WORLD linked it analyses serially);\n"
+              << "                        analyze-bank: analyse n files at once (default: all cores);\n"
+              << "                        synth: render segments on n threads (in-tree vocoder only: with\n"
+              << "                        WORLD linked, add --native, else WORLD renders serially)\n"
+              << "  --chunk-frames <n>    analyze: stream the WAV in blocks of n frames (bounded memory)\n"
+              << "  --f0 <method>         analyze: harvest (default, best), dio-harvest, or dio (fastest)\n"
+              << "  --f0-range <lo> <hi>  analyze: F0 search range in Hz (default 50 1100)\n"
+              << "  --frq <file|auto>     analyze: use a UTAU .frq as the F0 track (auto = <name>_wav.frq beside the WAV)\n"
+              << "  --write-frq <file|auto> analyze: also write the analysed F0 as a UTAU .frq\n"
+              << "  --compact <order>     analyze: store the envelope as a warped cepstrum of this order (e.g. 60)\n"
+              << "                        and aperiodicity in bands (mcep.bin, bap.bin), decoded at synthesis\n"
+              << "  --block <n>           synth: render incrementally in blocks of n samples, as a live preview would\n"
+              << "  --native              synth: render with the in-tree vocoder even when WORLD is linked\n"
+              << "  --oto-regions         analyze-bank: analyse only the span between oto offsets and cutoffs\n"
+              << "  --cache-dir <dir>     analyze: reuse/store results in a persistent analysis cache\n"
+              << "  --cache-size <MiB>    analyze: cache size limit, least recently used files evicted (default 1024)\n"
+              << "Notes: analyze writes f0.txt, sp.bin, ap.bin (or mcep.bin, bap.bin), meta.json under out_dir;\n"
+              << "       analyze-bank does so for every WAV its oto.ini files reference, under\n"
+              << "       out_dir/<path in the bank>/.\n";
+}
+
+// Run a single node through a ComputationGraph so that graph instrumentation applies.
+static std::shared_ptr<DataPacket> runNode(const std::shared_ptr<ISynthesisNode>& node,
+                                           const std::shared_ptr<const DataPacket>& in,
+                                           const std::string& tracePath) {
+    ComputationGraph graph;
+    graph.addNode(node);
+    std::shared_ptr<GraphTracer> tracer;
+    if (!tracePath.empty()) { tracer = std::make_shared<GraphTracer>(); graph.setTracer(tracer); }
+    ExecutionPlan plan;
+    if (!graph.compile(plan)) return nullptr;
+    ExecutionState state(plan);
+    if (!graph.run(plan, in, state, 1)) return nullptr;
+    if (tracer) {
+        if (!tracer->writeChromeTrace(tracePath)) std::cerr << "Failed to write trace: " << tracePath << "\n";
+        std::cout << tracer->formatSummary();
+    }
+    return state.takeOutput(0);
+}
+
+// Analysis parameters for a file at sampleRate; options fill in everything else.
+static WorldParams analysisParams(uint32_t sampleRate, const WorldParams& options) {
+    WorldParams params = options;
+    params.sampleRate = sampleRate;
+    params.hopSize = static_cast<size_t>(0.005 * sampleRate);
+    params.frameSize = 1024;
+    return params;
+}
+
+static void reportCache(const std::shared_ptr<PacketDiskCache>& cache) {
+    if (!cache) return;
+    std::cout << "Analysis cache " << cache->directory() << ": " << cache->hits() << " hit(s), "
+              << cache->misses() << " miss(es), " << cache->evictions() << " eviction(s)\n";
+}
+
+static std::string frqPathFor(const std::string& wav, const std::string& opt) {
+    return opt == "auto" ? UtauWorldIO::frqPathFor(wav) : opt;
+}
+
+// synth --block: feed frames to a RealtimeSynthesizer as its queue frees up and pull
+// fixed-size blocks, as an editor's live preview would.
+static bool synthRealtime(const DataPacket& pkt, const UtauWorldMeta& meta, size_t blockSize, std::vector<float>& y) {
+    RealtimeSynthesisConfig cfg;
+    cfg.sampleRate = meta.sampleRate;
+    cfg.fftSize = static_cast<size_t>(meta.fftSize);
+    cfg.hopSize = pkt.getScalar(FeatureKey::WorldHopSize, meta.framePeriodMs * meta.sampleRate / 1000.0);
+    cfg.blockSize = blockSize;
+    RealtimeSynthesizer rt(cfg);
+    const auto* f0 = pkt.getFeature(FeatureKey::F0);
+    if (!f0 || rt.bins() != static_cast<size_t>(meta.fftSize) / 2 + 1) return false;
+    std::vector<float> block(blockSize);
+    size_t pushed = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    while (!rt.drained()) {
+        pushed += rt.pushFrames(pkt, pushed);
+        if (pushed == f0->size()) rt.finish();
+        if (!rt.pull(block.data())) return false;
+        y.insert(y.end(), block.begin(), block.end());
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double audio = static_cast<double>(y.size()) / meta.sampleRate;
+    std::cout << "Rendered " << rt.samplesPulled() / blockSize << " blocks of " << blockSize << " samples, latency "
+              << 1000.0 * static_cast<double>(rt.latencySamples()) / meta.sampleRate << " ms, "
+              << (seconds > 0.0 ? audio / seconds : 0.0) << "x realtime\n";
+    return true;
+}
+
+// analyze --chunk-frames: read, analyse and write block by block.
+static int analyzeChunked(const std::string& wav, const std::string& outdir, const WorldParams& options, size_t chunkFrames,
+                          const std::shared_ptr<PacketDiskCache>& cache) {
+    vv::wavio::WavReader reader;
+    if (!reader.open(wav)) { std::cerr << "Failed to read WAV\n"; return 2; }
+    const uint32_t sr = reader.info().sampleRate;
+    const WorldParams params = analysisParams(sr, options);
+    auto analysis = std::make_shared<WorldAnalysisNode>(params);
+    analysis->setId("world_analysis");
+    analysis->setDiskCache(cache);
+    ChunkedAnalysisSource source(analysis, reader, chunkFrames);
+    std::string mkdirCmd = std::string("mkdir -p \"") + outdir + "\"";
+    (void)std::system(mkdirCmd.c_str());
+    UtauWorldStreamWriter writer;
+    if (!writer.open(outdir, sr, 1000.0 * static_cast<double>(params.hopSize) / sr)) { std::cerr << "Open outputs failed\n"; return 4; }
+    bool writeOk = true;
+    const bool ok = source.run([&](const StreamBlock&, const std::shared_ptr<DataPacket>& block) {
+        return writeOk = writer.append(*block);
+    });
+    if (!writeOk) { std::cerr << "Write failed\n"; return 4; }
+    if (!ok) { std::cerr << "Analysis failed\n"; return 3; }
+    if (!writer.close(source.sampleCount())) { std::cerr << "Write meta.json failed\n"; return 4; }
+    std::cout << "Analysis complete: " << outdir << " (" << writer.frames() << " frames in "
+              << source.blockCount() << " blocks)\n";
+    reportCache(cache);
+    return 0;
 }
 
 int main(int argc, char** argv) {
     if (argc < 2) { print_usage(); return 1; }
     std::string cmd = argv[1];
+    std::string tracePath;
+    WorldParams options;
+    size_t chunkFrames = 0;
+    size_t blockSize = 0;
+    std::string cacheDir;
+    uint64_t cacheMiB = 1024;
+    std::string frqIn, frqOut;
+    bool threadsSet = false, otoRegions = false, native = false;
+    for (int i = 4; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (opt == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (opt == "--threads" && i + 1 < argc) {
+            options.analysisThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            threadsSet = true;
+        }
+        else if (opt == "--oto-regions") otoRegions = true;
+        else if (opt == "--native") native = true;
+        else if (opt == "--compact" && i + 1 < argc) options.cepstrumOrder = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        else if (opt == "--frq" && i + 1 < argc) frqIn = argv[++i];
+        else if (opt == "--write-frq" && i + 1 < argc) frqOut = argv[++i];
+        else if (opt == "--cache-dir" && i + 1 < argc) cacheDir = argv[++i];
+        else if (opt == "--cache-size" && i + 1 < argc) cacheMiB = std::strtoull(argv[++i], nullptr, 10);
+        else if (opt == "--f0" && i + 1 < argc) {
+            if (!parseF0Method(argv[++i], options.f0Method)) { std::cerr << "Unknown F0 method: " << argv[i] << "\n"; return 1; }
+        }
+        else if (opt == "--f0-range" && i + 2 < argc) {
+            options.f0Floor = std::strtod(argv[++i], nullptr);
+            options.f0Ceil = std::strtod(argv[++i], nullptr);
+            if (!(options.f0Floor > 0.0 && options.f0Ceil > options.f0Floor)) { std::cerr << "Invalid F0 range\n"; return 1; }
+        }
+        else if (opt == "--block" && i + 1 < argc) blockSize = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        else if (opt == "--chunk-frames" && i + 1 < argc) chunkFrames = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        else { std::cerr << "Unknown option: " << opt << "\n"; print_usage(); return 1; }
+    }
+
+    std::shared_ptr<PacketDiskCache> cache;
+    if (!cacheDir.empty()) {
+        cache = std::make_shared<PacketDiskCache>(cacheDir, cacheMiB << 20);
+        if (!cache->good()) { std::cerr << "Cannot use cache directory: " << cacheDir << "\n"; return 1; }
+    }
+
+    if (cmd == "analyze-bank") {
+        if (argc < 4) { print_usage(); return 1; }
+        if ((!frqIn.empty() && frqIn != "auto") || (!frqOut.empty() && frqOut != "auto")) {
+            std::cerr << "analyze-bank only supports --frq auto and --write-frq auto\n";
+            return 1;
+        }
+        VoicebankOptions bank;
+        bank.params = options;
+        bank.params.analysisThreads = 1;
+        bank.threads = threadsSet ? options.analysisThreads : 0;
+        bank.otoRegions = otoRegions;
+        bank.useFrq = !frqIn.empty();
+        bank.writeFrq = !frqOut.empty();
+        bank.cache = cache;
+        VoicebankAnalyzer analyzer(argv[2], argv[3], bank);
+        if (!analyzer.load()) { std::cerr << "No readable oto.ini under " << argv[2] << "\n"; return 2; }
+        std::cout << analyzer.files().size() << " WAV file(s) referenced by " << analyzer.entryCount() << " oto entries\n";
+        const bool ok = analyzer.run([](const VoicebankProgress& p, const VoicebankAnalyzer::File& file, bool fileOk) {
+            const double rate = p.elapsedSeconds > 0.0 ? p.audioSeconds / p.elapsedSeconds : 0.0;
+            std::cout << "[" << p.done << "/" << p.total << "] " << file.relative << (fileOk ? "" : " FAILED")
+                      << "  (" << rate << "x realtime)\n" << std::flush;
+        });
+        const auto& p = analyzer.progress();
+        std::cout << "Analysed " << (p.done - p.failed) << "/" << p.total << " files, " << p.audioSeconds << " s of audio in "
+                  << p.elapsedSeconds << " s (" << (p.elapsedSeconds > 0.0 ? p.audioSeconds / p.elapsedSeconds : 0.0)
+                  << "x realtime, " << (p.elapsedSeconds > 0.0 ? p.done / p.elapsedSeconds : 0.0) << " files/s)\n";
+        for (const auto& f : analyzer.failures()) std::cerr << "Failed: " << f << "\n";
+        reportCache(cache);
+        return ok ? 0 : 3;
+    }
 
     if (cmd == "analyze") {
         if (argc < 4) { print_usage(); return 1; }
         std::string wav = argv[2];
         std::string outdir = argv[3];
+        if (chunkFrames > 0 && (!frqIn.empty() || !frqOut.empty())) {
+            std::cerr << "--frq and --write-frq need a whole-file analysis (no --chunk-frames)\n";
+            return 1;
+        }
+        if (chunkFrames > 0) return analyzeChunked(wav, outdir, options, chunkFrames, cache);
         // Read WAV
         vv::wavio::WavData wd; if (!vv::wavio::readWav(wav, wd)) { std::cerr << "Failed to read WAV\n"; return 2; }
         auto in = std::make_shared<DataPacket>(wd.samples, wd.sampleRate, wd.channels, 32);
-        WorldParams params; params.sampleRate = wd.sampleRate; params.hopSize = static_cast<size_t>(0.005 * wd.sampleRate); params.frameSize = 1024;
-        WorldAnalysisNode analysis(params); analysis.initialize();
-        auto analyzed = analysis.process(in);
+        WorldParams params = analysisParams(wd.sampleRate, options);
+        if (!frqIn.empty()) {
+            UtauFrq frq;
+            const std::string path = frqPathFor(wav, frqIn);
+            if (!UtauWorldIO::readFrq(path, frq)) { std::cerr << "Failed to read " << path << "\n"; return 2; }
+            UtauWorldIO::attachFrq(*in, frq);
+            params.externalF0 = true;
+        }
+        // Matrices and WORLD scratch come from one huge-page-backed arena for the whole render
+        auto io = makePlatformIO();
+        Arena arena(io->pageResource(true));
+        auto analysis = std::make_shared<WorldAnalysisNode>(params);
+        analysis->setId("world_analysis");
+        analysis->setMemoryResource(&arena);
+        analysis->setDiskCache(cache);
+        auto analyzed = runNode(analysis, in, tracePath);
         if (!analyzed) { std::cerr << "Analysis failed\n"; return 3; }
-        // Prepare outputs
-        const auto* f0 = analyzed->getFeature("f0");
-        const auto* sp = analyzed->getFeature("spectral_envelope");
-        const auto* ap = analyzed->getFeature("aperiodicity");
-        if (!f0 || !sp || !ap) { std::cerr << "Missing analysis features\n"; return 3; }
-        UtauWorldMeta meta; meta.sampleRate = wd.sampleRate;
-        meta.fftSize = static_cast<int>(analyzed->getScalar("world_fft_size", 0));
-        meta.bins = static_cast<int>(analyzed->getScalar("world_bins", meta.fftSize>0? meta.fftSize/2+1:0));
-        meta.frames = static_cast<int>(analyzed->getScalar("world_f0_len", f0->size()));
-        meta.framePeriodMs = 1000.0 * analyzed->getScalar("world_hop_size", params.hopSize) / static_cast<double>(wd.sampleRate);
-        meta.sampleCount = wd.samples.size();
+        const auto* f0 = analyzed->getFeature(FeatureKey::F0);
+        if (!f0) { std::cerr << "Missing analysis features\n"; return 3; }
         // Ensure outdir exists (best effort)
         std::string mkdirCmd = std::string("mkdir -p \"") + outdir + "\"";
         (void)std::system(mkdirCmd.c_str());
-        // Write files
-        if (!UtauWorldIO::writeF0Txt(outdir+"/f0.txt", *f0)) { std::cerr << "Write f0.txt failed\n"; return 4; }
-        if (!UtauWorldIO::writeBinMatrix(outdir+"/sp.bin", *sp, meta.frames, meta.bins)) { std::cerr << "Write sp.bin failed\n"; return 4; }
-        if (!UtauWorldIO::writeBinMatrix(outdir+"/ap.bin", *ap, meta.frames, meta.bins)) { std::cerr << "Write ap.bin failed\n"; return 4; }
-        if (!UtauWorldIO::writeMetaJson(outdir+"/meta.json", meta)) { std::cerr << "Write meta.json failed\n"; return 4; }
+        if (!UtauWorldIO::writeAnalysis(outdir, *analyzed, params.hopSize, wd.samples.size())) {
+            std::cerr << "Write outputs failed\n";
+            return 4;
+        }
+        if (!frqOut.empty()) {
+            const std::string path = frqPathFor(wav, frqOut);
+            const double hop = analyzed->getScalar(FeatureKey::WorldHopSize, static_cast<double>(params.hopSize));
+            if (!UtauWorldIO::writeFrq(path, UtauWorldIO::makeFrq(wd.samples, *f0, hop))) { std::cerr << "Write " << path << " failed\n"; return 4; }
+        }
         std::cout << "Analysis complete: " << outdir << "\n";
+        reportCache(cache);
         return 0;
     } else if (cmd == "synth") {
         if (argc < 4) { print_usage(); return 1; }
         std::string dir = argv[2];
         std::string outwav = argv[3];
-        std::vector<float> f0, sp, ap;
-        int frames = 0, bins = 0;
+        auto pkt = std::make_shared<DataPacket>();
         UtauWorldMeta meta;
-        if (!UtauWorldIO::readF0Txt(dir + "/f0.txt", f0)) { std::cerr << "Failed to read f0.txt\n"; return 3; }
-        if (!UtauWorldIO::readBinMatrix(dir + "/sp.bin", sp, frames, bins)) { std::cerr << "Failed to read sp.bin\n"; return 3; }
-        if (!UtauWorldIO::readBinMatrix(dir + "/ap.bin", ap, frames, bins)) { std::cerr << "Failed to read ap.bin\n"; return 3; }
-        if (!UtauWorldIO::readMetaJson(dir + "/meta.json", meta)) { std::cerr << "Failed to read meta.json\n"; return 3; }
-
-        auto pkt = std::make_shared<DataPacket>(std::vector<float>{}, meta.sampleRate, 1, 32);
-        pkt->setFeature("f0", std::move(f0));
-        pkt->setFeature("spectral_envelope", std::move(sp));
-        pkt->setFeature("aperiodicity", std::move(ap));
-        pkt->setScalar("world_fft_size", meta.fftSize);
-        pkt->setScalar("world_bins", meta.bins);
-        pkt->setScalar("world_f0_len", meta.frames);
-        pkt->setScalar("world_hop_size", meta.framePeriodMs * meta.sampleRate / 1000.0);
+        if (!UtauWorldIO::readAnalysis(dir, *pkt, meta)) { std::cerr << "Failed to read analysis from " << dir << "\n"; return 3; }
 
-        WorldSynthesisNode synth;
-        synth.initialize();
-        auto out = synth.process(pkt);
-        if (!out) { std::cerr << "Synthesis failed\n"; return 4; }
-        vv::wavio::WavData wd; wd.sampleRate = meta.sampleRate; wd.channels = 1; wd.samples = out->samples();
+        vv::wavio::WavData wd; wd.sampleRate = meta.sampleRate; wd.channels = 1;
+        if (blockSize > 0) {
+            if (!synthRealtime(*pkt, meta, blockSize, wd.samples)) { std::cerr << "Synthesis failed\n"; return 4; }
+        } else {
+            auto synth = std::make_shared<WorldSynthesisNode>();
+            synth->setId("world_synthesis");
+            if (threadsSet) synth->setSynthesisThreads(options.analysisThreads);
+            synth->setNativeSynthesis(native);
+#ifdef VV_USE_WORLD
+            if (threadsSet && options.analysisThreads != 1 && !native) {
+                std::cerr << "Note: WORLD synthesis is serial; --threads applies with --native only\n";
+            }
+#endif
+            auto out = runNode(synth, pkt, tracePath);
+            if (!out) { std::cerr << "Synthesis failed\n"; return 4; }
+            wd.samples = out->samples();
+        }
         if (!vv::wavio::writeWav16(outwav, wd)) { std::cerr << "Failed to write WAV\n"; return 5; }
         std::cout << "Wrote: " << outwav << "\n";
         return 0;
@@ -0,0 +1,117 @@
+#include "world/ChunkedAnalysis.h"
+#include "utils/WavIO.h"
+#include <algorithm>
+
+namespace vv {
+
+std::shared_ptr<DataPacket> sliceAnalysisFrames(const DataPacket& analysed, size_t firstFrame, size_t frames,
+                                                std::vector<float> samples) {
+    auto out = std::make_shared<DataPacket>(std::move(samples), analysed.sampleRate(), 1, 32);
+    analysed.forEachFeature([&](const std::string& key, const std::vector<float>& v) {
+        const size_t b = std::min(firstFrame, v.size());
+        const size_t e = std::min(firstFrame + frames, v.size());
+        out->setFeature(key, std::vector<float>(v.begin() + static_cast<std::ptrdiff_t>(b),
+                                                v.begin() + static_cast<std::ptrdiff_t>(e)));
+    });
+    analysed.forEachMatrix([&](const std::string& key, const FeatureMatrix& m) {
+        out->setMatrix(key, m.sliceRows(firstFrame, frames));
+    });
+    analysed.forEachScalar([&](const std::string& key, double v) { out->setScalar(key, v); });
+    return out;
+}
+
+ChunkedAnalysisSource::ChunkedAnalysisSource(std::shared_ptr<WorldAnalysisNode> node, FrameReader reader,
+                                             size_t totalFrames, uint32_t sampleRate, uint16_t channels,
+                                             size_t framesPerBlock)
+    : node_(std::move(node)), reader_(std::move(reader)), totalSamples_(totalFrames),
+      sampleRate_(sampleRate), channels_(std::max<uint16_t>(1, channels)),
+      framesPerBlock_(std::max<size_t>(1, framesPerBlock))
+{
+    if (!node_ || !reader_) { failed_ = true; return; }
+    hop_ = std::max<size_t>(1, node_->params().hopSize);
+    context_ = node_->analysisContext(sampleRate_);
+    // Windows start on the frame grid so that window-local frames line up with global ones.
+    context_.before = (context_.before + hop_ - 1) / hop_ * hop_;
+    totalFrames_ = node_->frameCount(totalSamples_, sampleRate_);
+}
+
+ChunkedAnalysisSource::ChunkedAnalysisSource(std::shared_ptr<WorldAnalysisNode> node, wavio::WavReader& reader,
+                                             size_t framesPerBlock)
+    : ChunkedAnalysisSource(std::move(node),
+                            [&reader](float* dst, size_t maxFrames) { return reader.readFrames(dst, maxFrames); },
+                            reader.good() && reader.info().channels > 0 && reader.info().bitsPerSample >= 8
+                                ? static_cast<size_t>(reader.info().dataBytes /
+                                                      (reader.info().channels * (reader.info().bitsPerSample / 8)))
+                                : 0,
+                            reader.info().sampleRate, reader.info().channels, framesPerBlock)
+{
+    if (!reader.good()) failed_ = true;
+}
+
+bool ChunkedAnalysisSource::fill(size_t start, size_t end) {
+    // Drop what no later window needs, then read up to `end`.
+    const size_t drop = std::min(window_.size(), start - windowStart_);
+    window_.erase(window_.begin(), window_.begin() + static_cast<std::ptrdiff_t>(drop));
+    windowStart_ += drop;
+    while (samplesRead_ < end) {
+        const size_t want = end - samplesRead_;
+        interleaved_.resize(want * channels_);
+        const size_t got = reader_(interleaved_.data(), want);
+        if (got == 0) return false;
+        for (size_t i = 0; i < got; ++i) {
+            if (channels_ == 1) { window_.push_back(interleaved_[i]); continue; }
+            float sum = 0.0f;
+            for (uint16_t c = 0; c < channels_; ++c) sum += interleaved_[i * channels_ + c];
+            window_.push_back(sum / static_cast<float>(channels_));
+        }
+        samplesRead_ += got;
+    }
+    peakWindow_ = std::max(peakWindow_, window_.size());
+    return true;
+}
+
+std::shared_ptr<DataPacket> ChunkedAnalysisSource::analyseNext(StreamBlock& info) {
+    if (failed_ || nextFrame_ >= totalFrames_) return nullptr;
+    const size_t first = nextFrame_;
+    const size_t frames = std::min(framesPerBlock_, totalFrames_ - first);
+    const bool last = first + frames == totalFrames_;
+    const size_t s0 = std::min(totalSamples_, first * hop_);
+    const size_t s1 = last ? totalSamples_ : std::min(totalSamples_, (first + frames) * hop_);
+    const size_t start = s0 > context_.before ? s0 - context_.before : 0;
+    const size_t end = last ? totalSamples_ : std::min(totalSamples_, s1 + context_.after);
+    if (!fill(start, end)) { failed_ = true; return nullptr; }
+
+    auto in = std::make_shared<DataPacket>(std::vector<float>(window_.begin(), window_.end()), sampleRate_, 1, 32);
+    auto analysed = node_->process(in);
+    if (!analysed) { failed_ = true; return nullptr; }
+
+    // Keep the block's own frames; window frame 0 is global frame start / hop.
+    const size_t offset = (first * hop_ - start) / hop_;
+    auto out = sliceAnalysisFrames(*analysed, offset, frames,
+        std::vector<float>(window_.begin() + static_cast<std::ptrdiff_t>(s0 - windowStart_),
+                           window_.begin() + static_cast<std::ptrdiff_t>(s1 - windowStart_)));
+
+    info.index = blockIndex_++;
+    info.firstFrame = first;
+    info.frames = frames;
+    info.last = last;
+    nextFrame_ = first + frames;
+    return out;
+}
+
+bool ChunkedAnalysisSource::next(std::shared_ptr<const DataPacket>& block, StreamBlock& info) {
+    auto out = analyseNext(info);
+    if (!out) return false;
+    block = std::move(out);
+    return true;
+}
+
+bool ChunkedAnalysisSource::run(const BlockSink& sink) {
+    StreamBlock info;
+    while (auto block = analyseNext(info)) {
+        if (!sink(info, block)) return false;
+    }
+    return !failed_;
+}
+
+} // namespace vv
@@ -1,30 +1,137 @@
 #include <cmath>
+#include <complex>
 #include <vector>
 #include <algorithm>
 #include "world/AnalysisUtils.h"
+#include "utils/FFTWrapper.h"
 
 namespace vv {
 
-// Extremely simplified pitch extractor: autocorrelation-based, placeholder for DIO/Harvest
-std::vector<float> estimateF0(const std::vector<float>& x, uint32_t sr, size_t hop) {
-    const float fmin = 50.0f, fmax = 500.0f;
-    size_t minLag = static_cast<size_t>(sr / fmax);
-    size_t maxLag = static_cast<size_t>(sr / fmin);
-    if (x.empty() || minLag >= x.size()) return {};
-    std::vector<float> f0;
-    for (size_t i = 0; i + maxLag < x.size(); i += hop) {
-        float best = 0.0f; size_t bestLag = 0;
-        for (size_t lag = minLag; lag <= maxLag; ++lag) {
-            float sum = 0.0f;
-            for (size_t j = 0; j < maxLag && i + j + lag < x.size(); ++j) {
-                sum += x[i + j] * x[i + j + lag];
+namespace {
+constexpr float kYinThreshold = 0.15f;      // first normalized dip below this is the period
+constexpr float kUnvoicedThreshold = 0.35f; // best dip above this: unvoiced
+constexpr double kSilence = 1e-10;          // mean power (about -100 dBFS) below which a frame is unvoiced
+
+// Lag range in samples for an F0 range in Hz.
+size_t minLagFor(uint32_t sr, double f0Ceil) { return static_cast<size_t>(sr / std::max(f0Ceil, 1.0)); }
+size_t maxLagFor(uint32_t sr, double f0Floor) { return static_cast<size_t>(sr / std::max(f0Floor, 1.0)); }
+}
+
+size_t f0FrameCount(size_t samples, uint32_t sr, size_t hop, double f0Floor, double f0Ceil) {
+    size_t minLag = minLagFor(sr, f0Ceil);
+    size_t maxLag = maxLagFor(sr, f0Floor);
+    if (samples == 0 || minLag >= samples || samples <= maxLag || hop == 0) return 0;
+    return (samples - maxLag + hop - 1) / hop;
+}
+
+size_t f0ContextSamples(uint32_t sr, double f0Floor) {
+    // lag and offset within the correlation window each stay below maxLag + 1
+    return 2 * maxLagFor(sr, f0Floor) + 1;
+}
+
+// YIN (de Cheveigne & Kawahara 2002) with an integration window of one period at
+// f0Floor. The difference function d(tau) = e(0) + e(tau) - 2 r(tau) takes its cross
+// term r from one complex FFT of the frame (two real inputs packed as re/im) and one
+// inverse FFT, instead of a lags x window loop. The energies e(tau) slide in double.
+// The d / normalization / threshold loops are written as plain contiguous loops so the
+// compiler vectorizes them. Each frame reads only [i, i + 2 * maxLag) (zero past the
+// end of x), so results do not depend on how the signal is split into ranges.
+void estimateF0Frames(const std::vector<float>& x, uint32_t sr, size_t hop, size_t first, size_t count, float* out,
+                      double f0Floor, double f0Ceil) {
+    const size_t minLag = std::max<size_t>(2, minLagFor(sr, f0Ceil));
+    const size_t maxLag = maxLagFor(sr, f0Floor);
+    if (count == 0) return;
+    if (maxLag < minLag + 2) { std::fill(out, out + count, 0.0f); return; }
+    const size_t W = maxLag;          // integration window
+    const size_t span = W + maxLag;   // samples one frame reads
+    const fft::FFTPlan plan(fft::FFTPlan::nextPow2(span));
+    const size_t N = plan.size();
+    std::vector<std::complex<float>> z(N);
+    std::vector<double> energy(maxLag + 1);
+    std::vector<float> d(maxLag + 1), cum(maxLag + 1), cmnd(maxLag + 1);
+
+    for (size_t f = 0; f < count; ++f) {
+        const size_t i = (first + f) * hop;
+        const size_t avail = i < x.size() ? std::min(span, x.size() - i) : 0;
+        const float* s = x.data() + std::min(i, x.size());
+        auto at = [&](size_t k) { return k < avail ? s[k] : 0.0f; };
+
+        double e = 0.0;
+        for (size_t j = 0; j < W; ++j) e += static_cast<double>(at(j)) * at(j);
+        if (e < kSilence * static_cast<double>(W)) { out[f] = 0.0f; continue; }
+        energy[0] = e;
+        for (size_t tau = 1; tau <= maxLag; ++tau) {
+            const double drop = at(tau - 1), add = at(tau - 1 + W);
+            e += add * add - drop * drop;
+            energy[tau] = e;
+        }
+
+        // re = frame head a[0, W), im = whole span b[0, span); then P = conj(A) * B,
+        // whose inverse transform is r(tau) = sum_j a[j] b[j + tau] (no wrap: span <= N).
+        for (size_t k = 0; k < N; ++k) z[k] = {k < W ? at(k) : 0.0f, k < span ? at(k) : 0.0f};
+        plan.forward(z.data());
+        for (size_t k = 0; k <= N / 2; ++k) {
+            const size_t m = (N - k) & (N - 1);
+            const std::complex<float> zk = z[k], zm = std::conj(z[m]);
+            const std::complex<float> A = 0.5f * (zk + zm);
+            const std::complex<float> B = std::complex<float>(0.0f, -0.5f) * (zk - zm);
+            const std::complex<float> P = std::conj(A) * B;
+            z[k] = P;
+            z[m] = std::conj(P);
+        }
+        plan.inverse(z.data());
+
+        const float e0 = static_cast<float>(energy[0]);
+        for (size_t tau = 0; tau <= maxLag; ++tau)
+            d[tau] = std::max(0.0f, e0 + static_cast<float>(energy[tau]) - 2.0f * z[tau].real());
+        float running = 0.0f;
+        for (size_t tau = 1; tau <= maxLag; ++tau) { running += d[tau]; cum[tau] = running; }
+        cmnd[0] = 1.0f;
+        for (size_t tau = 1; tau <= maxLag; ++tau)
+            cmnd[tau] = cum[tau] > 0.0f ? d[tau] * static_cast<float>(tau) / cum[tau] : 1.0f;
+
+        // First dip under the threshold, followed down to its local minimum; otherwise
+        // the global minimum, which must still be periodic enough to count as voiced.
+        size_t best = 0;
+        for (size_t tau = minLag; tau < maxLag; ++tau) {
+            if (cmnd[tau] < kYinThreshold) {
+                while (tau + 1 < maxLag && cmnd[tau + 1] < cmnd[tau]) ++tau;
+                best = tau;
+                break;
             }
-            if (sum > best) { best = sum; bestLag = lag; }
         }
-        if (bestLag > 0) f0.push_back(static_cast<float>(sr) / static_cast<float>(bestLag));
-        else f0.push_back(0.0f);
+        if (best == 0) {
+            best = minLag;
+            for (size_t tau = minLag + 1; tau < maxLag; ++tau) if (cmnd[tau] < cmnd[best]) best = tau;
+            if (cmnd[best] > kUnvoicedThreshold) { out[f] = 0.0f; continue; }
+        }
+        // Parabolic refinement of the period around the chosen lag.
+        const float y0 = cmnd[best - 1], y1 = cmnd[best], y2 = cmnd[best + 1];
+        const float denom = y0 - 2.0f * y1 + y2;
+        const float shift = denom > 0.0f ? std::clamp(0.5f * (y0 - y2) / denom, -1.0f, 1.0f) : 0.0f;
+        out[f] = static_cast<float>(sr) / (static_cast<float>(best) + shift);
     }
+}
+
+std::vector<float> estimateF0(const std::vector<float>& x, uint32_t sr, size_t hop, double f0Floor, double f0Ceil) {
+    std::vector<float> f0(f0FrameCount(x.size(), sr, hop, f0Floor, f0Ceil));
+    estimateF0Frames(x, sr, hop, 0, f0.size(), f0.data(), f0Floor, f0Ceil);
     return f0;
 }
 
+void resampleF0(const float* src, size_t srcFrames, double srcHop, float* dst, size_t dstFrames, double dstHop,
+                double dstOffset) {
+    if (dstFrames == 0) return;
+    if (srcFrames == 0 || !(srcHop > 0.0)) { std::fill(dst, dst + dstFrames, 0.0f); return; }
+    for (size_t j = 0; j < dstFrames; ++j) {
+        const double pos = (dstOffset + static_cast<double>(j) * dstHop) / srcHop;
+        const size_t i = static_cast<size_t>(pos);
+        if (i + 1 >= srcFrames) { dst[j] = src[srcFrames - 1]; continue; }
+        const double frac = pos - static_cast<double>(i);
+        const float a = src[i], b = src[i + 1];
+        if (a > 0.0f && b > 0.0f) dst[j] = static_cast<float>(a + frac * (b - a));
+        else dst[j] = frac < 0.5 ? a : b;
+    }
+}
+
 } // namespace vv
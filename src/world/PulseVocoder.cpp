@@ -0,0 +1,253 @@
+#include "world/PulseVocoder.h"
+#include "core/ThreadPool.h"
+#include "utils/VectorMath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vv {
+
+namespace {
+constexpr double kUnvoicedRate = 500.0;   // pulses per second in unvoiced stretches, as WORLD
+constexpr float kSafeGuard = 1e-12f;      // keeps log() of an empty band finite
+constexpr double kPi = 3.14159265358979323846;
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// xorshift64* stream seeded per pulse. Uniform values in (0, 1); the Box-Muller
+// transform to normal values is applied to whole arrays in render().
+struct NoiseStream {
+    uint64_t s;
+    float uniform() {
+        s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+        return (static_cast<float>((s * 0x2545F4914F6CDD1Dull) >> 40) + 0.5f) * (1.0f / 16777216.0f);
+    }
+};
+}
+
+PulseVocoder::PulseVocoder(const PulseVocoderConfig& config)
+    : config_(config), plan_(fft::FFTPlan::nextPow2(std::max<size_t>(config.fftSize, 4))) {
+    config_.fftSize = plan_.size();
+    config_.hopSize = std::max(1.0, config_.hopSize);
+    bins_ = config_.fftSize / 2 + 1;
+    for (auto* v : {&zRe_, &zIm_, &pRe_, &pIm_, &nRe_, &nIm_, &scratch_}) v->assign(config_.fftSize * L, 0.0f);
+    // Hann window over the first half of a periodic response, normalized to unit sum: the
+    // response's DC is subtracted in this shape (WORLD's dc_remover).
+    const size_t half = config_.fftSize / 2;
+    dcRemover_.assign(half, 0.0f);
+    double sum = 0.0;
+    for (size_t i = 0; i < half; ++i) sum += 0.5 - 0.5 * std::cos(2.0 * kPi * (i + 1) / (half + 1));
+    for (size_t i = 0; i < half; ++i) {
+        dcRemover_[i] = static_cast<float>((0.5 - 0.5 * std::cos(2.0 * kPi * (i + 1) / (half + 1))) / sum);
+    }
+}
+
+VocoderPulse PulseVocoder::pulseAt(double time, uint64_t index, double hopSize, double f0a, double f0b,
+                                   uint32_t sampleRate, size_t fftSize) {
+    VocoderPulse p;
+    p.time = time;
+    p.index = index;
+    const double t = time / hopSize;
+    p.frame = static_cast<size_t>(t);
+    const double w = t - static_cast<double>(p.frame);
+    p.weight = static_cast<float>(w);
+    // Voicing from the nearer frame; F0 interpolated only between voiced frames.
+    p.voiced = (w < 0.5 ? f0a : f0b) > 0.0;
+    const double f0 = p.voiced ? (f0a > 0.0 && f0b > 0.0 ? f0a + w * (f0b - f0a) : std::max(f0a, f0b)) : 0.0;
+    p.period = static_cast<double>(sampleRate) / (p.voiced ? f0 : kUnvoicedRate);
+    p.noiseSize = std::clamp<size_t>(static_cast<size_t>(std::lround(p.period)), 1, fftSize);
+    return p;
+}
+
+template <typename T>
+void PulseVocoder::loadImpl(size_t lane, const VocoderPulse& pulse, const T* envA, const T* envB,
+                            const T* apA, const T* apB) {
+    const float w = pulse.weight;
+    float ratio0 = 1.0f;
+    for (size_t k = 0; k < bins_; ++k) {
+        const float e0 = static_cast<float>(envA[k]), e1 = static_cast<float>(envB[k]);
+        const float env = e0 + w * (e1 - e0);
+        const float p0 = static_cast<float>(apA[k]), p1 = static_cast<float>(apB[k]);
+        const float p = std::clamp(p0 + w * (p1 - p0), 0.001f, 0.999999f);
+        const float ratio = p * p; // aperiodic power ratio
+        if (k == 0) ratio0 = ratio;
+        // Powers here; render() takes the logs of all lanes at once.
+        zRe_[k * L + lane] = env * (1.0f - ratio) + kSafeGuard;
+        zIm_[k * L + lane] = env * (pulse.voiced ? ratio : 1.0f) + kSafeGuard;
+    }
+    noiseSize_[lane] = std::min(pulse.noiseSize, config_.fftSize);
+    index_[lane] = pulse.index;
+    const bool periodic = pulse.voiced && ratio0 <= 0.999f;
+    gain_[lane] = periodic ? std::sqrt(static_cast<float>(noiseSize_[lane])) : 0.0f;
+}
+
+void PulseVocoder::load(size_t lane, const VocoderPulse& pulse, const double* envA, const double* envB,
+                        const double* apA, const double* apB) {
+    loadImpl(lane, pulse, envA, envB, apA, apB);
+}
+
+void PulseVocoder::load(size_t lane, const VocoderPulse& pulse, const float* envA, const float* envB,
+                        const float* apA, const float* apB) {
+    loadImpl(lane, pulse, envA, envB, apA, apB);
+}
+
+void PulseVocoder::render(size_t count) {
+    const size_t n = config_.fftSize, half = n / 2;
+    float* zr = zRe_.data(); float* zi = zIm_.data();
+    float* pr = pRe_.data(); float* pi = pIm_.data();
+    float* nr = nRe_.data(); float* ni = nIm_.data();
+    // Lanes past count render whatever they hold; their output is never read.
+    for (size_t l = count; l < L; ++l) { gain_[l] = 0.0f; noiseSize_[l] = 0; }
+
+    // Log amplitudes (half the log powers) of both spectra.
+    vmath::log(zr, zr, (half + 1) * L);
+    vmath::log(zi, zi, (half + 1) * L);
+    for (size_t i = 0; i < (half + 1) * L; ++i) { zr[i] *= 0.5f; zi[i] *= 0.5f; }
+    // Real cepstra of both (real, even) log spectra with one inverse transform, folded
+    // onto positive quefrencies, then back to the spectra of their minimum-phase forms.
+    for (size_t k = half + 1; k < n; ++k) {
+        for (size_t l = 0; l < L; ++l) { zr[k * L + l] = zr[(n - k) * L + l]; zi[k * L + l] = zi[(n - k) * L + l]; }
+    }
+    plan_.inverse(zr, zi);
+    for (size_t i = L; i < half * L; ++i) { zr[i] *= 2.0f; zi[i] *= 2.0f; }
+    std::fill(zr + (half + 1) * L, zr + n * L, 0.0f);
+    std::fill(zi + (half + 1) * L, zi + n * L, 0.0f);
+    plan_.forward(zr, zi);
+    // Split Z = P + iA (P, A spectra of real sequences) into log amplitude and phase of
+    // each, staged in p (periodic) and n (aperiodic), then exponentiate; the negative
+    // frequencies are the conjugates.
+    const size_t pos = (half + 1) * L;
+    for (size_t k = 0; k <= half; ++k) {
+        const size_t m = (n - k) & (n - 1);
+        for (size_t l = 0; l < L; ++l) {
+            const float ar = zr[k * L + l], ai = zi[k * L + l], br = zr[m * L + l], bi = zi[m * L + l];
+            pr[k * L + l] = 0.5f * (ar + br); pi[k * L + l] = 0.5f * (ai - bi);
+            nr[k * L + l] = 0.5f * (ai + bi); ni[k * L + l] = -0.5f * (ar - br);
+        }
+    }
+    float* tmp = scratch_.data();
+    vmath::exp(pr, pr, pos);
+    vmath::sincos(pi, pi, tmp, pos);
+    for (size_t i = 0; i < pos; ++i) { pi[i] *= pr[i]; pr[i] *= tmp[i]; }
+    vmath::exp(nr, nr, pos);
+    vmath::sincos(ni, ni, tmp, pos);
+    for (size_t i = 0; i < pos; ++i) { zr[i] = nr[i] * tmp[i]; zi[i] = nr[i] * ni[i]; }
+    for (size_t k = half + 1; k < n; ++k) {
+        for (size_t l = 0; l < L; ++l) {
+            pr[k * L + l] = pr[(n - k) * L + l]; pi[k * L + l] = -pi[(n - k) * L + l];
+            zr[k * L + l] = zr[(n - k) * L + l]; zi[k * L + l] = -zi[(n - k) * L + l];
+        }
+    }
+
+    // White noise for each lane's pulse interval, keyed by the pulse index: uniform pairs
+    // per lane (u1 = 1 past the interval gives 0), then Box-Muller over all lanes.
+    size_t rows = 0;
+    for (size_t l = 0; l < count; ++l) rows = std::max(rows, noiseSize_[l]);
+    std::fill(nr, nr + rows * L, 1.0f);
+    std::fill(ni, ni + rows * L, 0.0f);
+    for (size_t l = 0; l < count; ++l) {
+        NoiseStream noise{splitmix64(config_.seed ^ splitmix64(index_[l])) | 1};
+        for (size_t i = 0; i < noiseSize_[l]; ++i) {
+            nr[i * L + l] = noise.uniform();
+            ni[i * L + l] = noise.uniform();
+        }
+    }
+    vmath::log(nr, nr, rows * L);
+    for (size_t i = 0; i < rows * L; ++i) ni[i] *= static_cast<float>(2.0 * kPi);
+    vmath::sincos(ni, ni, tmp, rows * L);
+    for (size_t i = 0; i < rows * L; ++i) nr[i] = std::sqrt(std::max(0.0f, -2.0f * nr[i])) * tmp[i];
+    std::fill(nr + rows * L, nr + n * L, 0.0f);
+    std::fill(ni, ni + n * L, 0.0f);
+    plan_.forward(nr, ni);
+    // Both responses are real, so one inverse transform yields the periodic one in the
+    // real part and the filtered noise in the imaginary part.
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t l = 0; l < L; ++l) {
+            const size_t i = k * L + l;
+            const float xr = zr[i] * nr[i] - zi[i] * ni[i];
+            const float xi = zr[i] * ni[i] + zi[i] * nr[i];
+            nr[i] = gain_[l] * pr[i] - xi;
+            ni[i] = gain_[l] * pi[i] + xr;
+        }
+    }
+    plan_.inverse(nr, ni);
+    float dc[L] = {};
+    for (size_t i = 0; i < half; ++i) {
+        for (size_t l = 0; l < L; ++l) dc[l] += nr[i * L + l];
+    }
+    for (size_t l = 0; l < L; ++l) if (gain_[l] == 0.0f) dc[l] = 0.0f;
+    for (size_t i = 0; i < half; ++i) {
+        for (size_t l = 0; l < L; ++l) nr[i * L + l] += ni[i * L + l] - dc[l] * dcRemover_[i];
+    }
+    for (size_t i = half * L; i < n * L; ++i) nr[i] += ni[i];
+}
+
+void PulseVocoder::addResponse(size_t lane, float* buffer, size_t at, size_t mask) const {
+    const float* r = nRe_.data() + lane;
+    for (size_t i = 0; i < config_.fftSize; ++i) buffer[(at + i) & mask] += r[i * L];
+}
+
+bool PulseVocoder::synthesize(const std::vector<float>& f0, const FeatureMatrix& env, const FeatureMatrix& ap,
+                              const PulseVocoderConfig& config, std::vector<float>& out, ThreadPool* pool, size_t segments) {
+    const size_t frames = f0.size();
+    const size_t fftSize = fft::FFTPlan::nextPow2(std::max<size_t>(config.fftSize, 4));
+    if (frames == 0 || env.rows() < frames || ap.rows() < frames || env.cols() != fftSize / 2 + 1 ||
+        ap.cols() != env.cols() || env.type() != ap.type()) {
+        return false;
+    }
+    const double hop = std::max(1.0, config.hopSize);
+    const size_t length = static_cast<size_t>(std::ceil(static_cast<double>(frames) * hop));
+    out.assign(length, 0.0f);
+
+    // The schedule is cheap and inherently serial (each pulse follows from the previous).
+    std::vector<VocoderPulse> pulses;
+    pulses.reserve(static_cast<size_t>(static_cast<double>(length) / (config.sampleRate / 1100.0)) + 1);
+    for (double t = 0.0; t < static_cast<double>(frames) * hop;) {
+        const size_t a = std::min(static_cast<size_t>(t / hop), frames - 1);
+        const size_t b = std::min(a + 1, frames - 1);
+        pulses.push_back(pulseAt(t, pulses.size(), hop, f0[a], f0[b], config.sampleRate, fftSize));
+        t += pulses.back().period;
+    }
+
+    if (!pool) segments = 1;
+    else if (segments == 0) segments = 4 * (static_cast<size_t>(pool->size()) + 1);
+    segments = std::clamp<size_t>(segments, 1, pulses.size());
+    // Each segment adds its pulses' responses into a private buffer spanning its first
+    // pulse to fftSize past its last; the buffers are then summed in segment order.
+    struct Segment { size_t first, last, start; std::vector<float> y; };
+    std::vector<Segment> parts(segments);
+    for (size_t s = 0; s < segments; ++s) {
+        parts[s].first = pulses.size() * s / segments;
+        parts[s].last = pulses.size() * (s + 1) / segments;
+    }
+    parallelFor(pool, segments, [&](size_t s) {
+        Segment& part = parts[s];
+        PulseVocoder vocoder(config);
+        part.start = static_cast<size_t>(pulses[part.first].time);
+        part.y.assign(static_cast<size_t>(pulses[part.last - 1].time) - part.start + fftSize, 0.0f);
+        for (size_t i = part.first; i < part.last; i += kBatch) {
+            const size_t count = std::min(kBatch, part.last - i);
+            for (size_t l = 0; l < count; ++l) {
+                const VocoderPulse& p = pulses[i + l];
+                const size_t a = std::min(p.frame, frames - 1), b = std::min(p.frame + 1, frames - 1);
+                if (env.is<double>()) vocoder.load(l, p, env.row<double>(a), env.row<double>(b), ap.row<double>(a), ap.row<double>(b));
+                else vocoder.load(l, p, env.row<float>(a), env.row<float>(b), ap.row<float>(a), ap.row<float>(b));
+            }
+            vocoder.render(count);
+            for (size_t l = 0; l < count; ++l) {
+                vocoder.addResponse(l, part.y.data(), static_cast<size_t>(pulses[i + l].time) - part.start);
+            }
+        }
+    });
+    for (const Segment& part : parts) {
+        const size_t n = std::min(part.y.size(), length - std::min(length, part.start));
+        for (size_t i = 0; i < n; ++i) out[part.start + i] += part.y[i];
+    }
+    return true;
+}
+
+} // namespace vv
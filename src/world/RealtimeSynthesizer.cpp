@@ -0,0 +1,185 @@
+#include "world/RealtimeSynthesizer.h"
+#include "world/SpectralCodec.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vv {
+
+namespace {
+PulseVocoderConfig vocoderConfig(const RealtimeSynthesisConfig& c) {
+    PulseVocoderConfig v;
+    v.sampleRate = c.sampleRate;
+    v.fftSize = c.fftSize;
+    v.hopSize = c.hopSize;
+    v.seed = c.seed;
+    return v;
+}
+}
+
+RealtimeSynthesizer::RealtimeSynthesizer(const RealtimeSynthesisConfig& config)
+    : config_(config), vocoder_(vocoderConfig(config)) {
+    config_.fftSize = vocoder_.fftSize();
+    config_.hopSize = vocoder_.config().hopSize;
+    config_.blockSize = std::max<size_t>(1, config_.blockSize);
+    // One block's pulses touch frames spanning blockSize / hop + 2 slots.
+    config_.maxFrames = std::max(config_.maxFrames, static_cast<size_t>(std::ceil(config_.blockSize / config_.hopSize)) + 4);
+    bins_ = vocoder_.bins();
+    const size_t ring = fft::FFTPlan::nextPow2(config_.fftSize + config_.blockSize);
+    ringMask_ = ring - 1;
+
+    qf0_.assign(config_.maxFrames, 0.0);
+    qenv_.assign(config_.maxFrames * bins_, 0.0);
+    qap_.assign(config_.maxFrames * bins_, 0.0);
+    ola_.assign(ring, 0.0f);
+    reset();
+}
+
+RealtimeSynthesizer::~RealtimeSynthesizer() = default;
+
+void RealtimeSynthesizer::reset() {
+    head_.store(0);
+    tail_.store(0);
+    finished_.store(false);
+    position_ = 0;
+    nextPulse_ = 0.0;
+    pulses_ = 0;
+    underruns_ = 0;
+    std::fill(ola_.begin(), ola_.end(), 0.0f);
+    if (postFilters_) postFilters_->reset();
+}
+
+void RealtimeSynthesizer::setPostFilters(std::shared_ptr<PostFilterChain> chain) {
+    postFilters_ = std::move(chain);
+    if (postFilters_) postFilters_->prepare(config_.sampleRate, 1);
+}
+
+size_t RealtimeSynthesizer::latencySamples() const {
+    return config_.blockSize + static_cast<size_t>(std::ceil(config_.hopSize));
+}
+
+size_t RealtimeSynthesizer::freeFrames() const {
+    return config_.maxFrames - (head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+}
+
+template <typename T>
+bool RealtimeSynthesizer::pushImpl(double f0, const T* env, const T* ap) {
+    if (finished_.load(std::memory_order_relaxed) || freeFrames() == 0) return false;
+    const size_t i = head_.load(std::memory_order_relaxed);
+    const size_t slot = i % config_.maxFrames;
+    qf0_[slot] = f0 > 0.0 ? f0 : 0.0;
+    std::copy(env, env + bins_, qenv_.begin() + static_cast<std::ptrdiff_t>(slot * bins_));
+    std::copy(ap, ap + bins_, qap_.begin() + static_cast<std::ptrdiff_t>(slot * bins_));
+    head_.store(i + 1, std::memory_order_release);
+    return true;
+}
+
+bool RealtimeSynthesizer::pushFrame(double f0, const double* env, const double* ap) { return pushImpl(f0, env, ap); }
+bool RealtimeSynthesizer::pushFrame(double f0, const float* env, const float* ap) { return pushImpl(f0, env, ap); }
+
+size_t RealtimeSynthesizer::pushFrames(const DataPacket& pkt, size_t first) {
+    const auto* f0 = pkt.getFeature(FeatureKey::F0);
+    if (!f0) return 0;
+    const auto* env = pkt.getMatrix(FeatureKey::SpectralEnvelope);
+    const auto* ap = pkt.getMatrix(FeatureKey::Aperiodicity);
+    const auto* cep = pkt.getMatrix(FeatureKey::MelCepstrum);
+    const auto* band = pkt.getMatrix(FeatureKey::BandAperiodicity);
+    const bool full = env && ap && env->cols() == bins_ && ap->cols() == bins_ && env->type() == ap->type() &&
+                      env->rows() >= f0->size() && ap->rows() >= f0->size();
+    if (!full) {
+        if (!cep || !band || !cep->is<float>() || !band->is<float>() || cep->rows() < f0->size() || band->rows() < f0->size())
+            return 0;
+        const double alpha = pkt.getScalar(FeatureKey::MelCepstrumAlpha, melCepstrumAlpha(pkt.sampleRate()));
+        const double bandHz = pkt.getScalar(FeatureKey::BandAperiodicityHz, 3000.0);
+        if (!mcep_ || mcep_->order() != cep->cols() || mcep_->alpha() != alpha)
+            mcep_ = std::make_unique<MelCepstrumCodec>(bins_, cep->cols(), alpha);
+        if (!bap_ || bap_->bandHz() != bandHz) bap_ = std::make_unique<BandAperiodicityCodec>(bins_, config_.sampleRate, bandHz);
+        if (bap_->bands() != band->cols()) return 0;
+        decodedEnv_.resize(bins_);
+        decodedAp_.resize(bins_);
+    }
+    size_t n = 0;
+    for (size_t i = first; i < f0->size(); ++i, ++n) {
+        bool ok;
+        if (!full) {
+            mcep_->decode(cep->row<float>(i), decodedEnv_.data());
+            bap_->decode(band->row<float>(i), decodedAp_.data());
+            ok = pushFrame((*f0)[i], decodedEnv_.data(), decodedAp_.data());
+        } else if (env->is<double>()) {
+            ok = pushFrame((*f0)[i], env->row<double>(i), ap->row<double>(i));
+        } else {
+            ok = pushFrame((*f0)[i], env->row<float>(i), ap->row<float>(i));
+        }
+        if (!ok) break;
+    }
+    return n;
+}
+
+void RealtimeSynthesizer::finish() { finished_.store(true, std::memory_order_release); }
+
+// Frames needed to place every pulse before sample `end`: each pulse interpolates
+// between the frame at or before it and the next one.
+size_t RealtimeSynthesizer::requiredFrames(size_t end) const {
+    if (end == 0) return 0;
+    return static_cast<size_t>(std::floor(static_cast<double>(end - 1) / config_.hopSize)) + 2;
+}
+
+bool RealtimeSynthesizer::ready() const {
+    if (finished_.load(std::memory_order_acquire)) return !drained();
+    return head_.load(std::memory_order_acquire) >= requiredFrames(position_ + config_.blockSize);
+}
+
+bool RealtimeSynthesizer::drained() const {
+    if (!finished_.load(std::memory_order_acquire)) return false;
+    const double end = static_cast<double>(head_.load(std::memory_order_acquire)) * config_.hopSize;
+    return static_cast<double>(position_) >= std::ceil(end) + static_cast<double>(config_.fftSize);
+}
+
+bool RealtimeSynthesizer::pull(float* out) {
+    const size_t blockSize = config_.blockSize;
+    if (!ready()) {
+        std::fill(out, out + blockSize, 0.0f);
+        if (!drained()) ++underruns_;
+        return false;
+    }
+    const size_t available = head_.load(std::memory_order_acquire);
+    const double hop = config_.hopSize;
+    const size_t end = position_ + blockSize;
+    // Pulses stop where the last frame's hop ends.
+    const double stop = finished_.load(std::memory_order_acquire)
+        ? std::min(static_cast<double>(end), static_cast<double>(available) * hop)
+        : static_cast<double>(end);
+    // The block's pulses are rendered in batches of PulseVocoder::kBatch.
+    size_t at[PulseVocoder::kBatch];
+    size_t lanes = 0;
+    auto flush = [&] {
+        vocoder_.render(lanes);
+        for (size_t l = 0; l < lanes; ++l) vocoder_.addResponse(l, ola_.data(), at[l], ringMask_);
+        lanes = 0;
+    };
+    while (available > 0 && nextPulse_ < stop) {
+        // Past the last frame (after finish()) it is held, as in PulseVocoder::synthesize().
+        const size_t a = std::min(static_cast<size_t>(nextPulse_ / hop), available - 1);
+        const size_t b = std::min(a + 1, available - 1);
+        const size_t sa = a % config_.maxFrames, sb = b % config_.maxFrames;
+        const VocoderPulse p = PulseVocoder::pulseAt(nextPulse_, pulses_++, hop, qf0_[sa], qf0_[sb],
+                                                     config_.sampleRate, config_.fftSize);
+        vocoder_.load(lanes, p, &qenv_[sa * bins_], &qenv_[sb * bins_], &qap_[sa * bins_], &qap_[sb * bins_]);
+        at[lanes++] = static_cast<size_t>(nextPulse_);
+        if (lanes == PulseVocoder::kBatch) flush();
+        nextPulse_ += p.period;
+    }
+    if (lanes > 0) flush();
+    if (nextPulse_ < stop) nextPulse_ = stop; // nothing queued yet after finish()
+    for (size_t i = 0; i < blockSize; ++i) {
+        float& s = ola_[(position_ + i) & ringMask_];
+        out[i] = s;
+        s = 0.0f;
+    }
+    if (postFilters_) postFilters_->process(out, blockSize);
+    position_ = end;
+    // Frames before the next pulse's are no longer needed.
+    tail_.store(std::min(available, static_cast<size_t>(nextPulse_ / hop)), std::memory_order_release);
+    return true;
+}
+
+} // namespace vv
@@ -1,40 +1,98 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <complex>
 #include "world/AnalysisUtils.h"
+#include "utils/SignalUtils.h"
 
 namespace vv {
 
-// Placeholder spectral envelope using simple magnitude smoothing via moving average
-std::vector<float> simpleSpectralEnvelope(const std::vector<float>& x, size_t frameSize, size_t hop) {
-    if (x.empty()) return {};
-    std::vector<float> env;
-    for (size_t i = 0; i < x.size(); i += hop) {
-        size_t end = std::min(x.size(), i + frameSize);
-        float sum = 0.0f; size_t n = 0;
-        for (size_t j = i; j < end; ++j) { sum += std::abs(x[j]); ++n; }
-        env.push_back(n ? sum / static_cast<float>(n) : 0.0f);
-    }
-    return env;
+namespace {
+constexpr double kEnvelopeSmoothingHz = 300.0; // width of the envelope's smoothing band
+constexpr double kApBandHz = 3000.0;           // aperiodicity band width (as in D4C)
+constexpr float kPowerFloor = 1e-12f;          // keeps the envelope positive and logs finite
+}
+
+size_t envelopeFrameCount(size_t samples, size_t hop) {
+    return hop == 0 ? 0 : (samples + hop - 1) / hop;
+}
+
+StftEngine::StftEngine(size_t frameSize, size_t hop)
+    : frameSize_(std::max<size_t>(frameSize, 4)),
+      hop_(hop),
+      plan_(fft::FFTPlan::nextPow2(frameSize_)),
+      window_(frameSize_)
+{
+    signal::hanning(window_);
+    double energy = 0.0;
+    for (float w : window_) energy += static_cast<double>(w) * w;
+    norm_ = energy > 0.0 ? static_cast<float>(1.0 / energy) : 1.0f;
+}
+
+void StftEngine::powerSpectrum(const std::vector<float>& x, size_t frame, float* power,
+                               std::complex<float>* scratch) const {
+    const size_t n = fftSize();
+    const size_t i = frame * hop_;
+    const size_t avail = i < x.size() ? std::min(frameSize_, x.size() - i) : 0;
+    // The windowed frame is built in the scratch buffer itself: RealFFTPlan packs sample
+    // pairs into complex values in place, which is exactly the float layout of scratch.
+    float* t = reinterpret_cast<float*>(scratch);
+    const float* src = x.data() + (avail ? i : 0);
+    const float* w = window_.data();
+    for (size_t k = 0; k < avail; ++k) t[k] = src[k] * w[k];
+    std::fill(t + avail, t + n, 0.0f);
+    plan_.forward(t, scratch);
+    const float norm = norm_;
+    for (size_t k = 0; k < bins(); ++k) power[k] = std::norm(scratch[k]) * norm;
 }
 
-// Placeholder aperiodicity: 1 - normalized autocorrelation peak
-std::vector<float> simpleAperiodicity(const std::vector<float>& x, size_t frameSize, size_t hop) {
-    if (x.empty()) return {};
-    std::vector<float> ap;
-    for (size_t i = 0; i < x.size(); i += hop) {
-        size_t end = std::min(x.size(), i + frameSize);
-        float mean = 0.0f; size_t n = 0;
-        for (size_t j = i; j < end; ++j) { mean += x[j]; ++n; }
-        mean = n ? mean / static_cast<float>(n) : 0.0f;
-        float num = 0.0f, den = 0.0f;
-        for (size_t j = i; j < end; ++j) {
-            float v = x[j] - mean; num += v * v; den += std::abs(v);
+void stftEnvelopeAperiodicityFrames(const StftEngine& stft, const std::vector<float>& x, uint32_t sr,
+                                    size_t first, size_t count, float* const* envRows, float* const* apRows) {
+    const size_t bins = stft.bins();
+    if (bins == 0 || count == 0) return;
+    const double binHz = static_cast<double>(sr) / static_cast<double>(stft.fftSize());
+    const size_t radius = std::max<size_t>(1, static_cast<size_t>(std::lround(0.5 * kEnvelopeSmoothingHz / binHz)));
+    const size_t bandBins = std::max<size_t>(1, static_cast<size_t>(std::lround(kApBandHz / binHz)));
+    const size_t bands = (bins + bandBins - 1) / bandBins;
+
+    std::vector<std::complex<float>> scratch(bins);
+    std::vector<float> power(bins), logPower(bins), flatness(bands);
+    std::vector<double> prefix(bins + 1, 0.0);
+
+    for (size_t f = 0; f < count; ++f) {
+        stft.powerSpectrum(x, first + f, power.data(), scratch.data());
+        for (size_t k = 0; k < bins; ++k) power[k] += kPowerFloor;
+        for (size_t k = 0; k < bins; ++k) logPower[k] = std::log(power[k]);
+        for (size_t k = 0; k < bins; ++k) prefix[k + 1] = prefix[k] + power[k];
+
+        // Envelope: moving average of the power spectrum (edges use the bins available).
+        float* env = envRows[f];
+        for (size_t k = 0; k < bins; ++k) {
+            const size_t lo = k > radius ? k - radius : 0;
+            const size_t hi = std::min(bins, k + radius + 1);
+            env[k] = static_cast<float>((prefix[hi] - prefix[lo]) / static_cast<double>(hi - lo));
+        }
+
+        // Aperiodicity: flatness per band, then linear between band centres.
+        for (size_t b = 0; b < bands; ++b) {
+            const size_t lo = b * bandBins, hi = std::min(bins, lo + bandBins);
+            float meanLog = 0.0f;
+            for (size_t k = lo; k < hi; ++k) meanLog += logPower[k];
+            meanLog /= static_cast<float>(hi - lo);
+            const double mean = (prefix[hi] - prefix[lo]) / static_cast<double>(hi - lo);
+            flatness[b] = std::clamp(static_cast<float>(std::exp(meanLog) / mean), 0.0f, 1.0f);
+        }
+        float* ap = apRows[f];
+        const float half = 0.5f * static_cast<float>(bandBins - 1);
+        for (size_t k = 0; k < bins; ++k) {
+            const float pos = (static_cast<float>(k) - half) / static_cast<float>(bandBins); // in band-centre units
+            if (pos <= 0.0f) { ap[k] = flatness[0]; continue; }
+            const size_t b = static_cast<size_t>(pos);
+            if (b + 1 >= bands) { ap[k] = flatness[bands - 1]; continue; }
+            const float frac = pos - static_cast<float>(b);
+            ap[k] = flatness[b] + frac * (flatness[b + 1] - flatness[b]);
         }
-        float r = (den > 0.0f) ? (num / (den * den)) : 0.0f;
-        ap.push_back(std::clamp(1.0f - r, 0.0f, 1.0f));
     }
-    return ap;
 }
 
 } // namespace vv
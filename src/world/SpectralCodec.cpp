@@ -0,0 +1,246 @@
+#include "world/SpectralCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace vv {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kLogFloor = -60.0;  // natural-log power floor, keeps silent bins finite
+constexpr float kApFloorDb = -120.0f;
+
+// All-pass frequency warping of w in [0, pi]; warp(w, -alpha) inverts warp(w, alpha).
+double warp(double w, double alpha) {
+    return w + 2.0 * std::atan2(alpha * std::sin(w), 1.0 - alpha * std::cos(w));
+}
+
+// Codecs are pure functions of their shape: build each shape once per process.
+template <typename Codec, typename... Args>
+std::shared_ptr<const Codec> sharedCodec(Args... args) {
+    static std::mutex m;
+    static std::map<std::tuple<Args...>, std::shared_ptr<const Codec>> cache;
+    std::lock_guard<std::mutex> lk(m);
+    auto& c = cache[std::make_tuple(args...)];
+    if (!c) c = std::make_shared<const Codec>(args...);
+    return c;
+}
+}
+
+double melCepstrumAlpha(uint32_t sr) {
+    // SPTK's customary values, interpolated in log sample rate.
+    static const double table[][2] = {{8000, 0.31}, {16000, 0.42}, {22050, 0.45}, {32000, 0.50},
+                                      {44100, 0.53}, {48000, 0.55}};
+    const double s = static_cast<double>(sr);
+    if (s <= table[0][0]) return table[0][1];
+    for (size_t i = 1; i < sizeof(table) / sizeof(table[0]); ++i) {
+        if (s <= table[i][0]) {
+            const double t = std::log(s / table[i - 1][0]) / std::log(table[i][0] / table[i - 1][0]);
+            return table[i - 1][1] + t * (table[i][1] - table[i - 1][1]);
+        }
+    }
+    return table[5][1];
+}
+
+MelCepstrumCodec::MelCepstrumCodec(size_t bins, size_t order, double alpha)
+    : bins_(std::max<size_t>(bins, 2)), order_(std::max<size_t>(order, 1)), alpha_(alpha),
+      analysis_(bins_ * order_, 0.0f), synthesis_(order_ * bins_)
+{
+    // Encoding: the log spectrum is sampled at bins_ points evenly spaced on the warped
+    // axis (linear interpolation between bins on the linear axis), then expanded with a
+    // DCT-I, c[m] = sum_k w[k] cos(m theta_k) L(theta_k). Both steps are linear in the
+    // bins' log power, so they fold into one bins x order table.
+    const size_t points = bins_;
+    const double last = static_cast<double>(points - 1);
+    std::vector<double> acc(bins_ * order_, 0.0);
+    for (size_t k = 0; k < points; ++k) {
+        const double theta = kPi * static_cast<double>(k) / last;
+        const double pos = std::clamp(warp(theta, -alpha_) / kPi, 0.0, 1.0) * static_cast<double>(bins_ - 1);
+        const size_t i0 = std::min(static_cast<size_t>(pos), bins_ - 2);
+        const double f = pos - static_cast<double>(i0);
+        const double w = (k == 0 || k == points - 1 ? 0.5 : 1.0) / last;
+        for (size_t m = 0; m < order_; ++m) {
+            const double c = w * std::cos(static_cast<double>(m) * theta);
+            acc[i0 * order_ + m] += (1.0 - f) * c;
+            acc[(i0 + 1) * order_ + m] += f * c;
+        }
+    }
+    for (size_t i = 0; i < acc.size(); ++i) analysis_[i] = static_cast<float>(acc[i]);
+    // Decoding: L(bin) = c[0] + 2 sum_m c[m] cos(m theta(bin)).
+    for (size_t i = 0; i < bins_; ++i) {
+        const double theta = warp(kPi * static_cast<double>(i) / static_cast<double>(bins_ - 1), alpha_);
+        for (size_t m = 0; m < order_; ++m) {
+            synthesis_[m * bins_ + i] = static_cast<float>((m == 0 ? 1.0 : 2.0) * std::cos(static_cast<double>(m) * theta));
+        }
+    }
+}
+
+template <typename T>
+void MelCepstrumCodec::encodeImpl(const T* env, float* cep) const {
+    std::fill(cep, cep + order_, 0.0f);
+    const float* a = analysis_.data();
+    for (size_t i = 0; i < bins_; ++i, a += order_) {
+        const double p = static_cast<double>(env[i]);
+        const float l = static_cast<float>(p > 0.0 ? std::max(std::log(p), kLogFloor) : kLogFloor);
+        for (size_t m = 0; m < order_; ++m) cep[m] += l * a[m];
+    }
+}
+
+template <typename T>
+void MelCepstrumCodec::decodeImpl(const float* cep, T* env) const {
+    // Accumulate coefficient by coefficient (unit stride over bins), then exponentiate.
+    thread_local std::vector<float> logp;
+    logp.assign(bins_, 0.0f);
+    float* l = logp.data();
+    const float* s = synthesis_.data();
+    for (size_t m = 0; m < order_; ++m, s += bins_) {
+        const float c = cep[m];
+        for (size_t i = 0; i < bins_; ++i) l[i] += c * s[i];
+    }
+    for (size_t i = 0; i < bins_; ++i) env[i] = static_cast<T>(std::exp(static_cast<double>(l[i])));
+}
+
+void MelCepstrumCodec::encode(const double* env, float* cep) const { encodeImpl(env, cep); }
+void MelCepstrumCodec::encode(const float* env, float* cep) const { encodeImpl(env, cep); }
+void MelCepstrumCodec::decode(const float* cep, double* env) const { decodeImpl(cep, env); }
+void MelCepstrumCodec::decode(const float* cep, float* env) const { decodeImpl(cep, env); }
+
+BandAperiodicityCodec::BandAperiodicityCodec(size_t bins, uint32_t sampleRate, double bandHz)
+    : bins_(std::max<size_t>(bins, 2)), bandHz_(bandHz > 0.0 ? bandHz : 3000.0)
+{
+    const double nyquist = 0.5 * static_cast<double>(sampleRate);
+    const double binHz = nyquist / static_cast<double>(bins_ - 1);
+    // Centres at 0, bandHz, 2 bandHz, ... and Nyquist; always at least 0 and Nyquist, so
+    // every bin has a centre on either side even when Nyquist is below bandHz / 2.
+    std::vector<double> centres{0.0};
+    for (double c = bandHz_; c < nyquist - 0.5 * bandHz_; c += bandHz_) centres.push_back(c);
+    centres.push_back(nyquist);
+    bands_ = centres.size();
+    lo_.resize(bins_);
+    frac_.resize(bins_);
+    for (size_t i = 0, lo = 0; i < bins_; ++i) {
+        const double hz = static_cast<double>(i) * binHz;
+        while (lo + 2 < bands_ && hz >= centres[lo + 1]) ++lo;
+        lo_[i] = static_cast<uint32_t>(lo);
+        const double span = centres[lo + 1] - centres[lo];
+        frac_[i] = span > 0.0 ? static_cast<float>(std::clamp((hz - centres[lo]) / span, 0.0, 1.0)) : 0.0f;
+    }
+    // Decoding is db -> H db with H the bins x bands interpolation matrix; the encoder is
+    // its least-squares inverse (H^T H)^-1 H^T, solved once here by Gauss-Jordan
+    // elimination on the small bands x bands normal matrix.
+    const size_t n = bands_;
+    std::vector<double> g(n * n, 0.0), rhs(n * bins_, 0.0);
+    for (size_t i = 0; i < bins_; ++i) {
+        const size_t a = lo_[i], b = a + 1;
+        const double wa = 1.0 - frac_[i], wb = frac_[i];
+        g[a * n + a] += wa * wa; g[a * n + b] += wa * wb;
+        g[b * n + a] += wa * wb; g[b * n + b] += wb * wb;
+        rhs[a * bins_ + i] = wa;
+        rhs[b * bins_ + i] = wb;
+    }
+    for (size_t c = 0; c < n; ++c) {
+        size_t pivot = c;
+        for (size_t r = c + 1; r < n; ++r) if (std::fabs(g[r * n + c]) > std::fabs(g[pivot * n + c])) pivot = r;
+        if (pivot != c) {
+            for (size_t k = 0; k < n; ++k) std::swap(g[c * n + k], g[pivot * n + k]);
+            for (size_t k = 0; k < bins_; ++k) std::swap(rhs[c * bins_ + k], rhs[pivot * bins_ + k]);
+        }
+        const double d = g[c * n + c];
+        if (d == 0.0) continue; // a band no bin falls near (bandHz below the bin spacing)
+        for (size_t r = 0; r < n; ++r) {
+            if (r == c || g[r * n + c] == 0.0) continue;
+            const double f = g[r * n + c] / d;
+            for (size_t k = 0; k < n; ++k) g[r * n + k] -= f * g[c * n + k];
+            for (size_t k = 0; k < bins_; ++k) rhs[r * bins_ + k] -= f * rhs[c * bins_ + k];
+        }
+    }
+    analysis_.assign(bins_ * n, 0.0f);
+    for (size_t r = 0; r < n; ++r) {
+        const double d = g[r * n + r];
+        if (d == 0.0) continue;
+        for (size_t i = 0; i < bins_; ++i) analysis_[i * n + r] = static_cast<float>(rhs[r * bins_ + i] / d);
+    }
+}
+
+template <typename T>
+void BandAperiodicityCodec::encodeImpl(const T* ap, float* db) const {
+    std::fill(db, db + bands_, 0.0f);
+    const float* w = analysis_.data();
+    for (size_t i = 0; i < bins_; ++i, w += bands_) {
+        const double a = static_cast<double>(ap[i]);
+        const float v = a > 0.0 ? std::max(static_cast<float>(20.0 * std::log10(a)), kApFloorDb) : kApFloorDb;
+        for (size_t b = 0; b < bands_; ++b) db[b] += v * w[b];
+    }
+    for (size_t b = 0; b < bands_; ++b) db[b] = std::clamp(db[b], kApFloorDb, 0.0f);
+}
+
+template <typename T>
+void BandAperiodicityCodec::decodeImpl(const float* db, T* ap) const {
+    for (size_t i = 0; i < bins_; ++i) {
+        const float a = db[lo_[i]], b = db[lo_[i] + 1];
+        const float v = a + frac_[i] * (b - a);
+        ap[i] = static_cast<T>(std::min(1.0, std::pow(10.0, static_cast<double>(v) / 20.0)));
+    }
+}
+
+void BandAperiodicityCodec::encode(const double* ap, float* db) const { encodeImpl(ap, db); }
+void BandAperiodicityCodec::encode(const float* ap, float* db) const { encodeImpl(ap, db); }
+void BandAperiodicityCodec::decode(const float* db, double* ap) const { decodeImpl(db, ap); }
+void BandAperiodicityCodec::decode(const float* db, float* ap) const { decodeImpl(db, ap); }
+
+bool encodeSpectralFeatures(DataPacket& pkt, size_t order, double alpha, double bandHz) {
+    const auto* env = pkt.getMatrix(FeatureKey::SpectralEnvelope);
+    const auto* ap = pkt.getMatrix(FeatureKey::Aperiodicity);
+    if (!env || !ap || env->cols() < 2 || ap->rows() != env->rows() || ap->cols() != env->cols() || order == 0) return false;
+    const size_t bins = env->cols(), frames = env->rows();
+    if (alpha == 0.0) alpha = melCepstrumAlpha(pkt.sampleRate());
+    const auto mcep = sharedCodec<MelCepstrumCodec>(bins, order, alpha);
+    const auto bap = sharedCodec<BandAperiodicityCodec>(bins, pkt.sampleRate(), bandHz);
+    FeatureMatrix cep(frames, order, ElementType::Float32);
+    FeatureMatrix band(frames, bap->bands(), ElementType::Float32);
+    for (size_t r = 0; r < frames; ++r) {
+        if (env->is<double>()) mcep->encode(env->row<double>(r), cep.row<float>(r));
+        else mcep->encode(env->row<float>(r), cep.row<float>(r));
+        if (ap->is<double>()) bap->encode(ap->row<double>(r), band.row<float>(r));
+        else bap->encode(ap->row<float>(r), band.row<float>(r));
+    }
+    pkt.setScalar(FeatureKey::WorldFftSize, pkt.getScalar(FeatureKey::WorldFftSize, static_cast<double>((bins - 1) * 2)));
+    pkt.setScalar(FeatureKey::MelCepstrumAlpha, alpha);
+    pkt.setScalar(FeatureKey::BandAperiodicityHz, bap->bandHz());
+    pkt.setMatrix(FeatureKey::MelCepstrum, std::move(cep));
+    pkt.setMatrix(FeatureKey::BandAperiodicity, std::move(band));
+    pkt.removeMatrix(FeatureKey::SpectralEnvelope);
+    pkt.removeMatrix(FeatureKey::Aperiodicity);
+    return true;
+}
+
+bool decodeSpectralFeatures(const DataPacket& pkt, ElementType type, FeatureMatrix& env, FeatureMatrix& ap,
+                            std::pmr::memory_resource* mem) {
+    const auto* cep = pkt.getMatrix(FeatureKey::MelCepstrum);
+    const auto* band = pkt.getMatrix(FeatureKey::BandAperiodicity);
+    const double fft = pkt.getScalar(FeatureKey::WorldFftSize, 0.0);
+    if (!cep || !band || !cep->is<float>() || !band->is<float>() || cep->rows() != band->rows() || fft < 2.0) return false;
+    const size_t bins = static_cast<size_t>(fft) / 2 + 1;
+    const double alpha = pkt.getScalar(FeatureKey::MelCepstrumAlpha, melCepstrumAlpha(pkt.sampleRate()));
+    const auto mcep = sharedCodec<MelCepstrumCodec>(bins, cep->cols(), alpha);
+    const auto bap = sharedCodec<BandAperiodicityCodec>(bins, pkt.sampleRate(), pkt.getScalar(FeatureKey::BandAperiodicityHz, 3000.0));
+    if (band->cols() != bap->bands()) return false;
+    FeatureMatrix e(cep->rows(), bins, type, mem), a(cep->rows(), bins, type, mem);
+    for (size_t r = 0; r < cep->rows(); ++r) {
+        if (type == ElementType::Float64) {
+            mcep->decode(cep->row<float>(r), e.row<double>(r));
+            bap->decode(band->row<float>(r), a.row<double>(r));
+        } else {
+            mcep->decode(cep->row<float>(r), e.row<float>(r));
+            bap->decode(band->row<float>(r), a.row<float>(r));
+        }
+    }
+    env = std::move(e);
+    ap = std::move(a);
+    return true;
+}
+
+} // namespace vv
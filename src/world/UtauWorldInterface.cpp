@@ -1,7 +1,13 @@
 #include "world/UtauWorldInterface.h"
+#include "core/PacketFormat.h"
+#include "world/AnalysisUtils.h"
+#include "world/WorldAnalysisNode.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 
 namespace vv {
@@ -13,6 +19,43 @@ namespace {
         return static_cast<bool>(os);
     }
     template <typename T>
+    bool writeRowsAs(std::ofstream& os, const FeatureMatrix& m) {
+        const FeatureMatrix conv = m.is<T>() ? FeatureMatrix() : m.converted(elementTypeOf<T>());
+        const FeatureMatrix& src = m.is<T>() ? m : conv;
+        for (size_t r = 0; r < src.rows(); ++r) {
+            if (!writeAll(os, src.row<T>(r), src.cols())) return false;
+        }
+        return true;
+    }
+    bool writeRows(std::ofstream& os, const FeatureMatrix& m, ElementType stored = ElementType::Float64) {
+        return stored == ElementType::Float32 ? writeRowsAs<float>(os, m) : writeRowsAs<double>(os, m);
+    }
+    bool compactSpectra(const DataPacket& p) {
+        return !p.hasMatrix(FeatureKey::SpectralEnvelope) && p.hasMatrix(FeatureKey::MelCepstrum) &&
+               p.hasMatrix(FeatureKey::BandAperiodicity);
+    }
+    // Fill the spectral fields of meta from a packet (compact or full).
+    void describeSpectra(const DataPacket& p, UtauWorldMeta& meta) {
+        if (compactSpectra(p)) {
+            meta.fftSize = static_cast<int>(p.getScalar(FeatureKey::WorldFftSize, 0.0));
+            meta.bins = meta.fftSize / 2 + 1;
+            meta.cepstrumOrder = static_cast<int>(p.getMatrix(FeatureKey::MelCepstrum)->cols());
+            meta.cepstrumAlpha = p.getScalar(FeatureKey::MelCepstrumAlpha, 0.0);
+            meta.apBands = static_cast<int>(p.getMatrix(FeatureKey::BandAperiodicity)->cols());
+            meta.apBandHz = p.getScalar(FeatureKey::BandAperiodicityHz, 0.0);
+            return;
+        }
+        const auto* sp = p.getMatrix(FeatureKey::SpectralEnvelope);
+        meta.bins = sp ? static_cast<int>(sp->cols()) : 0;
+        meta.fftSize = static_cast<int>(p.getScalar(FeatureKey::WorldFftSize, meta.bins > 1 ? (meta.bins - 1) * 2 : 0));
+    }
+    void writeF0Lines(std::ostream& os, const std::vector<float>& f0) {
+        os.setf(std::ios::fixed); os.precision(8);
+        for (float v : f0) os << v << "\n";
+    }
+    constexpr char kFrqMagic[8] = {'F', 'R', 'E', 'Q', '0', '0', '0', '3'};
+    constexpr size_t kFrqHeaderBytes = 40;
+    template <typename T>
     bool readAll(std::ifstream& is, T* data, size_t count) {
         is.read(reinterpret_cast<char*>(data), sizeof(T) * count);
         return static_cast<bool>(is);
@@ -22,8 +65,7 @@ namespace {
 bool UtauWorldIO::writeF0Txt(const std::string& path, const std::vector<float>& f0) {
     std::ofstream os(path);
     if (!os) return false;
-    os.setf(std::ios::fixed); os.precision(8);
-    for (float v : f0) os << v << "\n";
+    writeF0Lines(os, f0);
     return static_cast<bool>(os);
 }
 
@@ -39,28 +81,30 @@ bool UtauWorldIO::readF0Txt(const std::string& path, std::vector<float>& f0) {
     return true;
 }
 
-bool UtauWorldIO::writeBinMatrix(const std::string& path, const std::vector<float>& flat, int frames, int bins) {
+bool UtauWorldIO::writeBinMatrix(const std::string& path, const FeatureMatrix& m, ElementType stored) {
     std::ofstream os(path, std::ios::binary);
     if (!os) return false;
-    // store as double row-major for compatibility
-    std::vector<double> buf(flat.begin(), flat.end());
-    if (!writeAll(os, buf.data(), buf.size())) return false;
-    return true;
+    return writeRows(os, m, stored);
 }
 
-bool UtauWorldIO::readBinMatrix(const std::string& path, std::vector<float>& flat, int& frames, int& bins) {
+bool UtauWorldIO::readBinMatrix(const std::string& path, int bins, FeatureMatrix& m, ElementType stored) {
     std::ifstream is(path, std::ios::binary | std::ios::ate);
-    if (!is) return false;
+    if (!is || bins <= 0) return false;
     auto sz = is.tellg();
     if (sz <= 0) return false;
     is.seekg(0, std::ios::beg);
-    size_t nDoubles = static_cast<size_t>(sz) / sizeof(double);
-    std::vector<double> buf(nDoubles);
-    if (!readAll(is, buf.data(), nDoubles)) return false;
-    flat.resize(nDoubles);
-    for (size_t i = 0; i < nDoubles; ++i) flat[i] = static_cast<float>(buf[i]);
-    // frames/bins will be provided by meta json; fall back to 0 if unknown
-    if (frames <= 0 || bins <= 0) { frames = 0; bins = 0; }
+    const size_t esize = elementSize(stored);
+    const size_t count = static_cast<size_t>(sz) / esize;
+    const size_t cols = static_cast<size_t>(bins);
+    if (count % cols != 0 || static_cast<size_t>(sz) % esize != 0) return false;
+    // read rows straight into the aligned matrix storage
+    FeatureMatrix out(count / cols, cols, stored);
+    for (size_t r = 0; r < out.rows(); ++r) {
+        const bool ok = stored == ElementType::Float32 ? readAll(is, out.row<float>(r), cols)
+                                                       : readAll(is, out.row<double>(r), cols);
+        if (!ok) return false;
+    }
+    m = std::move(out);
     return true;
 }
 
@@ -73,7 +117,12 @@ bool UtauWorldIO::writeMetaJson(const std::string& path, const UtauWorldMeta& m)
        << "  \"bins\": " << m.bins << ",\n"
        << "  \"frames\": " << m.frames << ",\n"
        << "  \"framePeriodMs\": " << m.framePeriodMs << ",\n"
-       << "  \"sampleCount\": " << m.sampleCount << "\n"
+       << "  \"sampleCount\": " << m.sampleCount << ",\n"
+       << "  \"startSample\": " << m.startSample << ",\n"
+       << "  \"cepstrumOrder\": " << m.cepstrumOrder << ",\n"
+       << "  \"cepstrumAlpha\": " << std::setprecision(17) << m.cepstrumAlpha << std::setprecision(6) << ",\n"
+       << "  \"apBands\": " << m.apBands << ",\n"
+       << "  \"apBandHz\": " << m.apBandHz << "\n"
        << "}\n";
     return static_cast<bool>(os);
 }
@@ -97,7 +146,191 @@ bool UtauWorldIO::readMetaJson(const std::string& path, UtauWorldMeta& m) {
     m.frames = static_cast<int>(findNum("\"frames\"", 0));
     m.framePeriodMs = findNum("\"framePeriodMs\"", 5.0);
     m.sampleCount = static_cast<size_t>(findNum("\"sampleCount\"", 0));
+    m.startSample = static_cast<size_t>(findNum("\"startSample\"", 0));
+    m.cepstrumOrder = static_cast<int>(findNum("\"cepstrumOrder\"", 0));
+    m.cepstrumAlpha = findNum("\"cepstrumAlpha\"", 0.0);
+    m.apBands = static_cast<int>(findNum("\"apBands\"", 0));
+    m.apBandHz = findNum("\"apBandHz\"", 0.0);
+    return true;
+}
+
+bool UtauWorldIO::writeAnalysis(const std::string& dir, const DataPacket& analysed, size_t hopSize,
+                                size_t sampleCount, size_t startSample) {
+    const auto* f0 = analysed.getFeature(FeatureKey::F0);
+    const bool compact = compactSpectra(analysed);
+    const auto* sp = analysed.getMatrix(compact ? FeatureKey::MelCepstrum : FeatureKey::SpectralEnvelope);
+    const auto* ap = analysed.getMatrix(compact ? FeatureKey::BandAperiodicity : FeatureKey::Aperiodicity);
+    const uint32_t sr = analysed.sampleRate();
+    if (!f0 || !sp || !ap || sr == 0) return false;
+    UtauWorldMeta meta;
+    meta.sampleRate = sr;
+    describeSpectra(analysed, meta);
+    meta.frames = static_cast<int>(sp->rows());
+    meta.framePeriodMs = 1000.0 * analysed.getScalar(FeatureKey::WorldHopSize, static_cast<double>(hopSize)) / static_cast<double>(sr);
+    meta.sampleCount = sampleCount;
+    meta.startSample = startSample;
+    const bool spectra = compact
+        ? writeBinMatrix(dir + "/mcep.bin", *sp, ElementType::Float32) && writeBinMatrix(dir + "/bap.bin", *ap, ElementType::Float32)
+        : writeBinMatrix(dir + "/sp.bin", *sp) && writeBinMatrix(dir + "/ap.bin", *ap);
+    return writeF0Txt(dir + "/f0.txt", *f0) && spectra && writeMetaJson(dir + "/meta.json", meta);
+}
+
+bool UtauWorldIO::readAnalysis(const std::string& dir, DataPacket& pkt, UtauWorldMeta& meta) {
+    std::vector<float> f0;
+    FeatureMatrix sp, ap;
+    if (!readF0Txt(dir + "/f0.txt", f0) || !readMetaJson(dir + "/meta.json", meta)) return false;
+    const bool compact = meta.cepstrumOrder > 0;
+    if (compact) {
+        if (!readBinMatrix(dir + "/mcep.bin", meta.cepstrumOrder, sp, ElementType::Float32) ||
+            !readBinMatrix(dir + "/bap.bin", meta.apBands, ap, ElementType::Float32)) return false;
+    } else if (!readBinMatrix(dir + "/sp.bin", meta.bins, sp) || !readBinMatrix(dir + "/ap.bin", meta.bins, ap)) {
+        return false;
+    }
+    pkt = DataPacket(std::vector<float>{}, meta.sampleRate, 1, 32);
+    pkt.setFeature(FeatureKey::F0, std::move(f0));
+    pkt.setMatrix(compact ? FeatureKey::MelCepstrum : FeatureKey::SpectralEnvelope, std::move(sp));
+    pkt.setMatrix(compact ? FeatureKey::BandAperiodicity : FeatureKey::Aperiodicity, std::move(ap));
+    pkt.setScalar(FeatureKey::WorldFftSize, meta.fftSize);
+    pkt.setScalar(FeatureKey::WorldHopSize, meta.framePeriodMs * meta.sampleRate / 1000.0);
+    if (compact) {
+        pkt.setScalar(FeatureKey::MelCepstrumAlpha, meta.cepstrumAlpha);
+        pkt.setScalar(FeatureKey::BandAperiodicityHz, meta.apBandHz);
+    }
+    return true;
+}
+
+bool UtauWorldIO::readFrq(const std::string& path, UtauFrq& frq) {
+    using packetio::detail::get;
+    std::ifstream is(path, std::ios::binary | std::ios::ate);
+    if (!is) return false;
+    const auto sz = is.tellg();
+    if (sz < static_cast<std::streamoff>(kFrqHeaderBytes)) return false;
+    std::vector<std::byte> buf(static_cast<size_t>(sz));
+    is.seekg(0, std::ios::beg);
+    if (!readAll(is, buf.data(), buf.size())) return false;
+    if (std::memcmp(buf.data(), kFrqMagic, sizeof(kFrqMagic)) != 0) return false;
+    const int32_t spf = get<int32_t>(buf.data() + 8);
+    const double avg = get<double>(buf.data() + 12);
+    const int32_t count = get<int32_t>(buf.data() + 36);
+    if (spf <= 0 || count < 0) return false;
+    const size_t n = static_cast<size_t>(count);
+    if (buf.size() < kFrqHeaderBytes + n * 2 * sizeof(double)) return false;
+    UtauFrq out;
+    out.samplesPerFrame = spf;
+    out.averageF0 = avg;
+    out.f0.resize(n);
+    out.amplitude.resize(n);
+    const std::byte* p = buf.data() + kFrqHeaderBytes;
+    for (size_t i = 0; i < n; ++i, p += 2 * sizeof(double)) {
+        out.f0[i] = get<double>(p);
+        out.amplitude[i] = get<double>(p + sizeof(double));
+    }
+    frq = std::move(out);
+    return true;
+}
+
+bool UtauWorldIO::writeFrq(const std::string& path, const UtauFrq& frq) {
+    using packetio::detail::put;
+    if (frq.samplesPerFrame <= 0 || frq.amplitude.size() != frq.f0.size()) return false;
+    std::vector<std::byte> buf(kFrqHeaderBytes + frq.f0.size() * 2 * sizeof(double), std::byte{0});
+    std::memcpy(buf.data(), kFrqMagic, sizeof(kFrqMagic));
+    put<int32_t>(buf, 8, frq.samplesPerFrame);
+    put<double>(buf, 12, frq.averageF0);
+    put<int32_t>(buf, 36, static_cast<int32_t>(frq.f0.size()));
+    size_t at = kFrqHeaderBytes;
+    for (size_t i = 0; i < frq.f0.size(); ++i, at += 2 * sizeof(double)) {
+        put<double>(buf, at, frq.f0[i]);
+        put<double>(buf, at + sizeof(double), frq.amplitude[i]);
+    }
+    std::ofstream os(path, std::ios::binary);
+    if (!os) return false;
+    return writeAll(os, buf.data(), buf.size());
+}
+
+UtauFrq UtauWorldIO::makeFrq(const std::vector<float>& samples, const std::vector<float>& f0, double f0Hop,
+                             int32_t samplesPerFrame) {
+    UtauFrq frq;
+    frq.samplesPerFrame = samplesPerFrame > 0 ? samplesPerFrame : 256;
+    const size_t spf = static_cast<size_t>(frq.samplesPerFrame);
+    const size_t n = (samples.size() + spf - 1) / spf;
+    std::vector<float> grid(n);
+    resampleF0(f0.data(), f0.size(), f0Hop, grid.data(), n, static_cast<double>(spf));
+    frq.f0.assign(grid.begin(), grid.end());
+    frq.amplitude.resize(n);
+    double sum = 0.0;
+    size_t voiced = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t a = i * spf, b = std::min(samples.size(), a + spf);
+        double s = 0.0;
+        for (size_t k = a; k < b; ++k) s += std::fabs(samples[k]);
+        frq.amplitude[i] = 32768.0 * s / static_cast<double>(b - a);
+        if (frq.f0[i] > 0.0) { sum += frq.f0[i]; ++voiced; }
+    }
+    frq.averageF0 = voiced ? sum / static_cast<double>(voiced) : 0.0;
+    return frq;
+}
+
+void UtauWorldIO::attachFrq(DataPacket& input, const UtauFrq& frq, size_t startSample) {
+    std::vector<float> track(frq.f0.begin(), frq.f0.end());
+    const size_t spf = static_cast<size_t>(std::max<int32_t>(1, frq.samplesPerFrame));
+    if (startSample > 0) {
+        // Same spacing, shifted to start at the input's first sample.
+        const size_t span = track.size() * spf;
+        std::vector<float> shifted(span > startSample ? (span - startSample + spf - 1) / spf : 0);
+        resampleF0(track.data(), track.size(), static_cast<double>(spf), shifted.data(), shifted.size(),
+                   static_cast<double>(spf), static_cast<double>(startSample));
+        track = std::move(shifted);
+    }
+    input.setFeature(kExternalF0Feature, std::move(track));
+    input.setScalar(kExternalF0HopScalar, static_cast<double>(spf));
+}
+
+std::string UtauWorldIO::frqPathFor(const std::string& wavPath) {
+    const size_t dot = wavPath.find_last_of('.');
+    const size_t slash = wavPath.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return wavPath + "_wav.frq";
+    return wavPath.substr(0, dot) + "_" + wavPath.substr(dot + 1) + ".frq";
+}
+
+bool UtauWorldStreamWriter::open(const std::string& dir, uint32_t sampleRate, double framePeriodMs) {
+    dir_ = dir;
+    meta_ = UtauWorldMeta{};
+    meta_.sampleRate = sampleRate;
+    meta_.framePeriodMs = framePeriodMs;
+    f0_.open(dir + "/f0.txt");
+    return static_cast<bool>(f0_);
+}
+
+bool UtauWorldStreamWriter::append(const DataPacket& block) {
+    const auto* f0 = block.getFeature(FeatureKey::F0);
+    const bool compact = compactSpectra(block);
+    const auto* sp = block.getMatrix(compact ? FeatureKey::MelCepstrum : FeatureKey::SpectralEnvelope);
+    const auto* ap = block.getMatrix(compact ? FeatureKey::BandAperiodicity : FeatureKey::Aperiodicity);
+    if (!f0 || !sp || !ap || !f0_) return false;
+    if (!sp_.is_open()) {
+        // The first block decides the representation and the shape.
+        describeSpectra(block, meta_);
+        sp_.open(dir_ + (compact ? "/mcep.bin" : "/sp.bin"), std::ios::binary);
+        ap_.open(dir_ + (compact ? "/bap.bin" : "/ap.bin"), std::ios::binary);
+        if (!sp_ || !ap_) return false;
+    }
+    const size_t spCols = static_cast<size_t>(compact ? meta_.cepstrumOrder : meta_.bins);
+    const size_t apCols = static_cast<size_t>(compact ? meta_.apBands : meta_.bins);
+    if ((meta_.cepstrumOrder > 0) != compact || sp->cols() != spCols || ap->cols() != apCols) return false;
+    const ElementType stored = compact ? ElementType::Float32 : ElementType::Float64;
+    writeF0Lines(f0_, *f0);
+    if (!f0_ || !writeRows(sp_, *sp, stored) || !writeRows(ap_, *ap, stored)) return false;
+    meta_.frames += static_cast<int>(sp->rows());
     return true;
 }
 
+bool UtauWorldStreamWriter::close(size_t sampleCount) {
+    meta_.sampleCount = sampleCount;
+    const bool spectra = sp_.is_open(); // false if no block was appended
+    f0_.close();
+    if (spectra) { sp_.close(); ap_.close(); }
+    if (f0_.fail() || sp_.fail() || ap_.fail()) return false;
+    return UtauWorldIO::writeMetaJson(dir_ + "/meta.json", meta_);
+}
+
 } // namespace vv
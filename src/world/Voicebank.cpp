@@ -0,0 +1,250 @@
+#include "world/Voicebank.h"
+#include "world/ChunkedAnalysis.h"
+#include "world/UtauWorldInterface.h"
+#include "core/ThreadPool.h"
+#include "utils/WavIO.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace vv {
+
+namespace fs = std::filesystem;
+
+namespace {
+bool validUtf8(const std::string& s) {
+    for (size_t i = 0; i < s.size();) {
+        const auto c = static_cast<unsigned char>(s[i]);
+        const size_t n = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        if (n == 0 || i + n > s.size()) return false;
+        for (size_t k = 1; k < n; ++k) {
+            if ((static_cast<unsigned char>(s[i + k]) & 0xC0) != 0x80) return false;
+        }
+        i += n;
+    }
+    return true;
+}
+
+bool shiftJisLead(unsigned char c) { return (c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC); }
+
+// Windows separators to '/', leaving the second byte of Shift-JIS characters alone.
+std::string normalizeSeparators(const std::string& name, bool shiftJis) {
+    std::string out;
+    out.reserve(name.size());
+    for (size_t i = 0; i < name.size(); ++i) {
+        const auto c = static_cast<unsigned char>(name[i]);
+        if (shiftJis && shiftJisLead(c) && i + 1 < name.size()) {
+            out += name[i];
+            out += name[++i];
+            continue;
+        }
+        out += c == '\\' ? '/' : name[i];
+    }
+    return out;
+}
+
+double field(const std::vector<std::string>& f, size_t i) {
+    return i < f.size() ? std::strtod(f[i].c_str(), nullptr) : 0.0;
+}
+
+std::vector<float> downmix(const wavio::WavData& wd) {
+    if (wd.channels <= 1) return wd.samples;
+    std::vector<float> mono(wd.samples.size() / wd.channels);
+    for (size_t i = 0; i < mono.size(); ++i) {
+        float sum = 0.0f;
+        for (uint16_t c = 0; c < wd.channels; ++c) sum += wd.samples[i * wd.channels + c];
+        mono[i] = sum / static_cast<float>(wd.channels);
+    }
+    return mono;
+}
+}
+
+bool OtoIni::parse(const std::string& text, std::vector<OtoEntry>& entries) {
+    size_t pos = text.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+    const bool shiftJis = !validUtf8(text);
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) eol = text.size();
+        std::string line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos || eq == 0) continue;
+        std::vector<std::string> fields;
+        std::stringstream ss(line.substr(eq + 1));
+        for (std::string f; std::getline(ss, f, ',');) fields.push_back(f);
+        OtoEntry e;
+        e.file = normalizeSeparators(line.substr(0, eq), shiftJis);
+        e.alias = fields.empty() ? std::string() : fields[0];
+        if (e.alias.empty()) e.alias = fs::path(e.file).stem().string(); // UTAU's default alias
+        e.offsetMs = field(fields, 1);
+        e.consonantMs = field(fields, 2);
+        e.cutoffMs = field(fields, 3);
+        e.preutterMs = field(fields, 4);
+        e.overlapMs = field(fields, 5);
+        entries.push_back(std::move(e));
+    }
+    return true;
+}
+
+bool OtoIni::read(const std::string& path, std::vector<OtoEntry>& entries) {
+    std::ifstream is(path, std::ios::binary);
+    if (!is) return false;
+    std::stringstream ss; ss << is.rdbuf();
+    return parse(ss.str(), entries);
+}
+
+VoicebankAnalyzer::VoicebankAnalyzer(std::string bankDir, std::string outDir, VoicebankOptions options)
+    : bankDir_(std::move(bankDir)), outDir_(std::move(outDir)), options_(std::move(options)) {}
+
+bool VoicebankAnalyzer::load() {
+    files_.clear();
+    entries_ = 0;
+    std::error_code ec;
+    std::vector<fs::path> otos;
+    for (auto it = fs::recursive_directory_iterator(bankDir_, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        std::string name = it->path().filename().string();
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (name == "oto.ini") otos.push_back(it->path());
+    }
+    std::sort(otos.begin(), otos.end());
+    std::unordered_map<std::string, size_t> index;
+    bool any = false;
+    for (const auto& oto : otos) {
+        std::vector<OtoEntry> entries;
+        if (!OtoIni::read(oto.string(), entries)) continue;
+        any = true;
+        for (auto& e : entries) {
+            const fs::path wav = (oto.parent_path() / e.file).lexically_normal();
+            auto [it, added] = index.emplace(wav.string(), files_.size());
+            if (added) {
+                File f;
+                f.wav = wav.string();
+                f.relative = wav.lexically_relative(bankDir_).replace_extension().string();
+                files_.push_back(std::move(f));
+            }
+            files_[it->second].entries.push_back(std::move(e));
+            ++entries_;
+        }
+    }
+    return any;
+}
+
+bool VoicebankAnalyzer::analyseFile(const File& file, double& audioSeconds) const {
+    wavio::WavData wd;
+    if (!wavio::readWav(file.wav, wd) || wd.sampleRate == 0 || wd.channels == 0) return false;
+    const std::vector<float> mono = downmix(wd);
+    const uint32_t sr = wd.sampleRate;
+    // Same analysis grid as vv_world analyze.
+    WorldParams params = options_.params;
+    params.sampleRate = sr;
+    params.hopSize = std::max<size_t>(1, static_cast<size_t>(0.005 * sr));
+    params.frameSize = 1024;
+    params.analysisThreads = 1; // files are the unit of parallelism
+
+    UtauFrq frq;
+    const bool haveFrq = options_.useFrq && UtauWorldIO::readFrq(UtauWorldIO::frqPathFor(file.wav), frq);
+    params.externalF0 = haveFrq;
+    WorldAnalysisNode node(params);
+    node.setDiskCache(options_.cache);
+
+    // [begin, end): the samples the oto entries use (all of them by default).
+    size_t begin = 0, end = mono.size();
+    if (options_.otoRegions && !file.entries.empty() && !mono.empty()) {
+        const double durationMs = 1000.0 * static_cast<double>(mono.size()) / sr;
+        double lo = durationMs, hi = 0.0;
+        for (const auto& e : file.entries) {
+            lo = std::min(lo, std::max(0.0, e.beginMs()));
+            hi = std::max(hi, std::min(durationMs, e.endMs(durationMs)));
+        }
+        if (hi > lo) {
+            begin = static_cast<size_t>(std::floor(lo * sr / 1000.0));
+            end = std::min(mono.size(), static_cast<size_t>(std::ceil(hi * sr / 1000.0)));
+        }
+    }
+    const size_t hop = params.hopSize;
+    const size_t first = begin / hop;
+    const bool partial = begin > 0 || end < mono.size();
+    // A partial window carries the estimators' context on both sides and starts on the
+    // frame grid, as in ChunkedAnalysisSource; only frames covering [begin, end) are kept.
+    size_t start = 0, stop = mono.size();
+    if (partial) {
+        const auto context = node.analysisContext(sr);
+        const size_t before = (context.before + hop - 1) / hop * hop;
+        start = first * hop > before ? first * hop - before : 0;
+        stop = std::min(mono.size(), end + context.after);
+    }
+    auto in = std::make_shared<DataPacket>(std::vector<float>(mono.begin() + static_cast<std::ptrdiff_t>(start),
+                                                              mono.begin() + static_cast<std::ptrdiff_t>(stop)),
+                                           sr, 1, 32);
+    if (haveFrq) UtauWorldIO::attachFrq(*in, frq, start);
+    auto analysed = node.process(in);
+    if (!analysed || !analysed->getFeature(FeatureKey::F0)) return false;
+    size_t startSample = 0, sampleCount = mono.size();
+    if (partial) {
+        const size_t frames = std::min(node.frameCount(mono.size(), sr), (end + hop - 1) / hop + 1) - first;
+        analysed = sliceAnalysisFrames(*analysed, first - start / hop, frames, {});
+        startSample = first * hop;
+        sampleCount = end - startSample;
+    }
+
+    const fs::path dir = fs::path(outDir_) / file.relative;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec || !UtauWorldIO::writeAnalysis(dir.string(), *analysed, hop, sampleCount, startSample)) return false;
+    if (options_.writeFrq) {
+        // F0 on the whole recording's grid (zero before the analysed span).
+        const auto& f0 = *analysed->getFeature(FeatureKey::F0);
+        std::vector<float> track(first, 0.0f);
+        track.insert(track.end(), f0.begin(), f0.end());
+        const std::string path = UtauWorldIO::frqPathFor((fs::path(outDir_) / file.relative).string() + ".wav");
+        if (!UtauWorldIO::writeFrq(path, UtauWorldIO::makeFrq(mono, track, static_cast<double>(hop)))) return false;
+    }
+    audioSeconds = static_cast<double>(end - begin) / sr;
+    return true;
+}
+
+bool VoicebankAnalyzer::run(const ProgressFn& progress) {
+    failures_.clear();
+    progress_ = VoicebankProgress{};
+    progress_.total = files_.size();
+    // Largest files first, so a long file does not start last and leave cores idle.
+    std::vector<std::pair<uintmax_t, size_t>> order;
+    order.reserve(files_.size());
+    for (size_t i = 0; i < files_.size(); ++i) {
+        std::error_code ec;
+        const uintmax_t size = fs::file_size(files_[i].wav, ec);
+        order.emplace_back(ec ? 0 : size, i);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    const unsigned n = options_.threads ? options_.threads : std::max(1u, std::thread::hardware_concurrency());
+    // The calling thread works too, so n threads in total need n - 1 workers.
+    std::unique_ptr<ThreadPool> pool = n > 1 ? std::make_unique<ThreadPool>(n - 1) : nullptr;
+    const auto t0 = std::chrono::steady_clock::now();
+    std::mutex mutex;
+    parallelFor(pool.get(), order.size(), [&](size_t k) {
+        const File& file = files_[order[k].second];
+        double seconds = 0.0;
+        const bool ok = analyseFile(file, seconds);
+        std::lock_guard<std::mutex> lk(mutex);
+        ++progress_.done;
+        progress_.audioSeconds += seconds;
+        progress_.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!ok) { ++progress_.failed; failures_.push_back(file.wav); }
+        if (progress) progress(progress_, file, ok);
+    });
+    return failures_.empty();
+}
+
+} // namespace vv
@@ -1,12 +1,15 @@
 #include "world/WorldAnalysisNode.h"
 #include "world/AnalysisUtils.h"
+#include "world/SpectralCodec.h"
 #include <algorithm>
 #include <cmath>
+#include <thread>
 #ifdef VV_USE_WORLD
 // WORLD headers
 extern "C" {
 #include <world/dio.h>
 #include <world/harvest.h>
+#include <world/stonemask.h>
 #include <world/cheaptrick.h>
 #include <world/d4c.h>
 }
@@ -14,74 +17,270 @@ extern "C" {
 
 namespace vv {
 
+std::mutex& worldMutex() {
+    static std::mutex m;
+    return m;
+}
+
+namespace {
+// Split [0, frames) into ranges of at most `per` frames.
+struct FrameChunks {
+    FrameChunks(size_t frames, size_t per) : total(frames), per(std::max<size_t>(1, per)), count((frames + this->per - 1) / this->per) {}
+    size_t first(size_t c) const { return c * per; }
+    size_t size(size_t c) const { return std::min(per, total - c * per); }
+    size_t total;
+    size_t per;
+    size_t count;
+};
+
+#ifdef VV_USE_WORLD
+void harvestF0(const WorldParams& p, const double* x, int x_length, int sr, double frame_period_ms,
+               double* time_axis, double* f0) {
+    HarvestOption hopts; InitializeHarvestOption(&hopts);
+    hopts.frame_period = frame_period_ms;
+    hopts.f0_floor = p.f0Floor; hopts.f0_ceil = p.f0Ceil;
+    Harvest(x, x_length, sr, &hopts, time_axis, f0);
+}
+
+// F0 contour on WORLD's frame grid with the configured estimator; resizes both outputs
+// to the frame count.
+void worldF0(const WorldParams& p, const double* x, int x_length, int sr, double frame_period_ms,
+             std::pmr::vector<double>& time_axis, std::pmr::vector<double>& f0) {
+    if (p.f0Method == F0Method::Harvest) {
+        const int n = GetSamplesForHarvest(sr, x_length, frame_period_ms);
+        time_axis.resize(n); f0.resize(n);
+        harvestF0(p, x, x_length, sr, frame_period_ms, time_axis.data(), f0.data());
+        return;
+    }
+    DioOption dopts; InitializeDioOption(&dopts);
+    dopts.frame_period = frame_period_ms;
+    dopts.f0_floor = p.f0Floor; dopts.f0_ceil = p.f0Ceil;
+    dopts.channels_in_octave = p.f0Channels;
+    // The coarse pass only has to find voiced regions: let DIO decimate harder.
+    if (p.f0Method == F0Method::DioHarvest) dopts.speed = 4;
+    const int n = GetSamplesForDIO(sr, x_length, frame_period_ms);
+    time_axis.resize(n); f0.resize(n);
+    std::pmr::vector<double> raw(static_cast<size_t>(n), 0.0, f0.get_allocator());
+    Dio(x, x_length, sr, &dopts, time_axis.data(), raw.data());
+    StoneMask(x, x_length, sr, time_axis.data(), raw.data(), n, f0.data());
+    if (p.f0Method == F0Method::Dio) return;
+
+    // Re-estimate each voiced run with Harvest, over the run plus a few periods of
+    // f0Floor on either side; runs closer than that are merged. Unvoiced frames keep
+    // DIO's zero.
+    const size_t hop = std::max<size_t>(1, p.hopSize);
+    const size_t margin = static_cast<size_t>(std::ceil(3.0 * sr / std::max(p.f0Floor, 1.0) / hop)) + 1;
+    const size_t frames = static_cast<size_t>(n);
+    std::pmr::vector<double> ht(f0.get_allocator()), hf(f0.get_allocator());
+    for (size_t a = 0; a < frames;) {
+        if (f0[a] <= 0.0) { ++a; continue; }
+        size_t b = a;
+        for (size_t gap = 0; b < frames && gap <= 2 * margin; ++b) gap = f0[b] > 0.0 ? 0 : gap + 1;
+        while (b > a && f0[b - 1] <= 0.0) --b;
+        const size_t wa = a > margin ? a - margin : 0;
+        const size_t wb = std::min(frames, b + margin);
+        const size_t s0 = wa * hop;
+        const int len = static_cast<int>(std::min(static_cast<size_t>(x_length), wb * hop) - s0);
+        const int m = GetSamplesForHarvest(sr, len, frame_period_ms);
+        ht.resize(m); hf.resize(m);
+        harvestF0(p, x + s0, len, sr, frame_period_ms, ht.data(), hf.data());
+        // Window frame j is global frame wa + j (the window starts on the frame grid).
+        for (size_t k = a; k < b && k - wa < static_cast<size_t>(m); ++k) f0[k] = hf[k - wa];
+        a = b;
+    }
+}
+#endif
+
+// The input's external F0 track, if the parameters ask for one and the input has one.
+const std::vector<float>* externalTrack(const WorldParams& p, const DataPacket& in, double& hop) {
+    if (!p.externalF0) return nullptr;
+    const auto* track = in.getFeature(kExternalF0Feature);
+    hop = in.getScalar(kExternalF0HopScalar, 0.0);
+    return track && !track->empty() && hop > 0.0 ? track : nullptr;
+}
+}
+
+ThreadPool* WorldAnalysisNode::analysisPool() const {
+    if (params_.analysisThreads == 1) return nullptr;
+    std::lock_guard<std::mutex> lk(poolMutex_);
+    if (!pool_) {
+        const unsigned n = params_.analysisThreads ? params_.analysisThreads : std::thread::hardware_concurrency();
+        // The calling thread works too, so n threads in total need n - 1 workers.
+        if (n > 1) pool_ = std::make_shared<ThreadPool>(n - 1);
+    }
+    return pool_.get();
+}
+
+WorldAnalysisNode::Context WorldAnalysisNode::analysisContext(uint32_t sr) const {
+#ifdef VV_USE_WORLD
+    // CheapTrick and D4C window at most a few periods of f0_floor, all within one
+    // fft_size; Harvest's filters are shorter. Twice that leaves room for Harvest's
+    // contour tracking, which is not strictly local (see ChunkedAnalysisSource).
+    CheapTrickOption copts; InitializeCheapTrickOption(sr, &copts);
+    copts.f0_floor = params_.f0Floor;
+    const size_t span = 2 * static_cast<size_t>(GetFFTSizeForCheapTrick(sr, &copts));
+    return Context{span, span};
+#else
+    // The placeholder estimators only look forward from a frame's first sample.
+    return Context{0, std::max(params_.frameSize, f0ContextSamples(sr, params_.f0Floor))};
+#endif
+}
+
+size_t WorldAnalysisNode::frameCount(size_t samples, uint32_t sr) const {
+    if (samples == 0 || sr == 0) return 0;
+#ifdef VV_USE_WORLD
+    const double frame_period_ms = 1000.0 * static_cast<double>(params_.hopSize) / static_cast<double>(sr);
+    return static_cast<size_t>(GetSamplesForHarvest(sr, static_cast<int>(samples), frame_period_ms));
+#else
+    return std::max(f0FrameCount(samples, sr, params_.hopSize, params_.f0Floor, params_.f0Ceil),
+                    envelopeFrameCount(samples, params_.hopSize));
+#endif
+}
+
+uint64_t WorldAnalysisNode::diskCacheKey(const DataPacket& input) const {
+    uint64_t params = 0;
+    parameterHash(params);
+    uint64_t h = hash::combine(input.contentHash(), params);
+    h = hash::combine(h, hash::value(kAnalysisVersion));
+    h = hash::combine(h, hash::value(packetio::kVersion));
+#ifdef VV_USE_WORLD
+    h = hash::combine(h, hash::string("world"));
+#else
+    h = hash::combine(h, hash::string("fallback"));
+#endif
+    return h;
+}
+
 std::shared_ptr<DataPacket> WorldAnalysisNode::process(const std::shared_ptr<const DataPacket>& input) {
     if (!input) return nullptr;
+    if (!diskCache_ || input->samples().empty()) return analyse(input);
+    const uint64_t key = diskCacheKey(*input);
+    DataPacket cached;
+    if (diskCache_->load(key, cached)) {
+        auto out = std::make_shared<DataPacket>(*input);
+        cached.forEachFeature([&](const std::string& k, const std::vector<float>&) { out->setFeature(k, cached.sharedFeature(k)); });
+        cached.forEachMatrix([&](const std::string& k, const FeatureMatrix&) { out->setMatrix(k, cached.sharedMatrix(k)); });
+        cached.forEachScalar([&](const std::string& k, double v) { out->setScalar(k, v); });
+        return out;
+    }
+    auto out = analyse(input);
+    if (out) {
+        // Everything but the samples, which the key already stands for.
+        DataPacket entry(std::vector<float>{}, out->sampleRate(), out->channels(), out->bitDepth());
+        out->forEachFeature([&](const std::string& k, const std::vector<float>&) { entry.setFeature(k, out->sharedFeature(k)); });
+        out->forEachMatrix([&](const std::string& k, const FeatureMatrix&) { entry.setMatrix(k, out->sharedMatrix(k)); });
+        out->forEachScalar([&](const std::string& k, double v) { entry.setScalar(k, v); });
+        diskCache_->store(key, entry);
+    }
+    return out;
+}
+
+std::shared_ptr<DataPacket> WorldAnalysisNode::analyse(const std::shared_ptr<const DataPacket>& input) {
+    auto out = estimate(input);
+    if (out && params_.cepstrumOrder > 0) encodeSpectralFeatures(*out, params_.cepstrumOrder);
+    return out;
+}
+
+std::shared_ptr<DataPacket> WorldAnalysisNode::estimate(const std::shared_ptr<const DataPacket>& input) {
     auto out = std::make_shared<DataPacket>(*input);
     const auto& x = input->samples();
     const uint32_t sr = input->sampleRate();
 #ifdef VV_USE_WORLD
     if (!x.empty()) {
+        std::lock_guard<std::mutex> world(worldMutex());
         // Parameters
         const double frame_period_ms = 1000.0 * static_cast<double>(params_.hopSize) / static_cast<double>(sr);
         // F0 using Harvest (robust) or DIO
+        std::pmr::memory_resource* mem = memory_ ? memory_ : std::pmr::get_default_resource();
     int x_length = static_cast<int>(x.size());
-        std::vector<double> x_d(x.begin(), x.end());
-    int f0_length = 1;
-    std::vector<double> time_axis;
-    std::vector<double> f0_d;
-        HarvestOption hopts; InitializeHarvestOption(&hopts);
-        hopts.frame_period = frame_period_ms;
-        hopts.f0_floor = 50.0; hopts.f0_ceil = 1100.0;
-    f0_length = GetSamplesForHarvest(sr, x_length, hopts.frame_period);
-    time_axis.resize(f0_length); f0_d.resize(f0_length);
-        Harvest(x_d.data(), x_length, sr, &hopts, time_axis.data(), f0_d.data());
-
-        // Spectral envelope (CheapTrick)
+        std::pmr::vector<double> x_d(x.begin(), x.end(), mem);
+    std::pmr::vector<double> time_axis(mem);
+    std::pmr::vector<double> f0_d(mem);
+        double trackHop = 0.0;
+        if (const auto* track = externalTrack(params_, *input, trackHop)) {
+            // Supplied F0 on Harvest's frame grid, so the frame count does not depend on it.
+            const int n = GetSamplesForHarvest(sr, x_length, frame_period_ms);
+            std::vector<float> f(static_cast<size_t>(n));
+            resampleF0(track->data(), track->size(), trackHop, f.data(), f.size(), static_cast<double>(params_.hopSize));
+            time_axis.resize(n); f0_d.resize(n);
+            for (int i = 0; i < n; ++i) {
+                time_axis[i] = i * frame_period_ms / 1000.0;
+                f0_d[i] = f[i];
+            }
+        } else {
+            worldF0(params_, x_d.data(), x_length, sr, frame_period_ms, time_axis, f0_d);
+        }
+        const int f0_length = static_cast<int>(f0_d.size());
+
+        // Spectral envelope (CheapTrick) and aperiodicity (D4C) are written straight into
+        // packet-owned f0_length x (fft_size/2+1) matrices through their row pointers.
         CheapTrickOption copts; InitializeCheapTrickOption(sr, &copts);
-        copts.f0_floor = 50.0;
+        copts.f0_floor = params_.f0Floor;
         int fft_size = GetFFTSizeForCheapTrick(sr, &copts);
-        // out matrices: f0_length x (fft_size/2+1)
         int freq_bins = fft_size / 2 + 1;
-        std::vector<double> spectrogram(static_cast<size_t>(f0_length) * freq_bins);
-        std::vector<double*> spec_rows(f0_length);
-        for (int t = 0; t < f0_length; ++t) spec_rows[t] = spectrogram.data() + static_cast<size_t>(t) * freq_bins;
-        CheapTrick(x_d.data(), x_length, sr, time_axis.data(), f0_d.data(), f0_length, &copts, spec_rows.data());
-
-        // Aperiodicity (D4C)
+        FeatureMatrix spectrogram(static_cast<size_t>(f0_length), static_cast<size_t>(freq_bins), ElementType::Float64, mem);
+        auto spec_rows = spectrogram.rowPointers<double>();
         D4COption d4c_opts; InitializeD4COption(&d4c_opts);
-        std::vector<double> ap_mat(static_cast<size_t>(f0_length) * freq_bins);
-        std::vector<double*> ap_rows(f0_length);
-        for (int t = 0; t < f0_length; ++t) ap_rows[t] = ap_mat.data() + static_cast<size_t>(t) * freq_bins;
-        D4C(x_d.data(), x_length, sr, time_axis.data(), f0_d.data(), f0_length, fft_size, &d4c_opts, ap_rows.data());
+        FeatureMatrix ap_mat(static_cast<size_t>(f0_length), static_cast<size_t>(freq_bins), ElementType::Float64, mem);
+        auto ap_rows = ap_mat.rowPointers<double>();
+
+        // Both estimators are per-frame given F0 and run over the same frame ranges as the
+        // fallback path, but in order on this thread: CheapTrick and D4C re-seed and draw
+        // from WORLD's process-global safeguard noise generator, which concurrent calls
+        // would race on. Each call re-seeds, so the output depends on framesPerTask only.
+        const FrameChunks chunks(static_cast<size_t>(f0_length), params_.framesPerTask);
+        parallelFor(nullptr, 2 * chunks.count, [&](size_t t) {
+            const size_t first = chunks.first(t % chunks.count);
+            const int n = static_cast<int>(chunks.size(t % chunks.count));
+            if (t < chunks.count) {
+                CheapTrick(x_d.data(), x_length, sr, time_axis.data() + first, f0_d.data() + first, n,
+                           &copts, spec_rows.data() + first);
+            } else {
+                D4C(x_d.data(), x_length, sr, time_axis.data() + first, f0_d.data() + first, n,
+                    fft_size, &d4c_opts, ap_rows.data() + first);
+            }
+        });
 
-        // Flatten to float features. We also store meta: fft_size, bins, hopSize
         std::vector<float> f0(f0_length);
         for (int i = 0; i < f0_length; ++i) f0[i] = static_cast<float>(f0_d[i]);
-        std::vector<float> env; env.reserve(static_cast<size_t>(f0_length) * freq_bins);
-        for (int t = 0; t < f0_length; ++t) {
-            for (int k = 0; k < freq_bins; ++k) env.push_back(static_cast<float>(spec_rows[t][k]));
-        }
-        std::vector<float> ap; ap.reserve(static_cast<size_t>(f0_length) * freq_bins);
-        for (int t = 0; t < f0_length; ++t) {
-            for (int k = 0; k < freq_bins; ++k) ap.push_back(static_cast<float>(ap_rows[t][k]));
-        }
-        out->setFeature("f0", std::move(f0));
-        out->setFeature("spectral_envelope", std::move(env));
-        out->setFeature("aperiodicity", std::move(ap));
-        out->setScalar("world_fft_size", static_cast<double>(fft_size));
-        out->setScalar("world_bins", static_cast<double>(freq_bins));
-        out->setScalar("world_f0_len", static_cast<double>(f0_length));
-        out->setScalar("world_hop_size", static_cast<double>(params_.hopSize));
+        out->setFeature(FeatureKey::F0, std::move(f0));
+        out->setMatrix(FeatureKey::SpectralEnvelope, std::move(spectrogram));
+        out->setMatrix(FeatureKey::Aperiodicity, std::move(ap_mat));
+        out->setScalar(FeatureKey::WorldFftSize, static_cast<double>(fft_size));
+        out->setScalar(FeatureKey::WorldHopSize, static_cast<double>(params_.hopSize));
         return out;
     }
 #endif
-    // Fallback simple implementations
-    auto f0 = estimateF0(x, sr, params_.hopSize);
-    auto env = simpleSpectralEnvelope(x, params_.frameSize, params_.hopSize);
-    auto ap = simpleAperiodicity(x, params_.frameSize, params_.hopSize);
-    out->setFeature("f0", std::move(f0));
-    out->setFeature("spectral_envelope", std::move(env));
-    out->setFeature("aperiodicity", std::move(ap));
+    // Fallback estimators: YIN for F0, and envelope plus aperiodicity from one shared
+    // STFT pass. All are per-frame, so the parallel mode splits them into frame ranges
+    // and is bit-identical to the serial one.
+    const size_t hop = params_.hopSize;
+    const StftEngine stft(params_.frameSize, hop);
+    std::vector<float> f0(f0FrameCount(x.size(), sr, hop, params_.f0Floor, params_.f0Ceil));
+    const size_t frames = stft.frameCount(x.size());
+    FeatureMatrix env(frames, stft.bins(), ElementType::Float32, memory_);
+    FeatureMatrix ap(frames, stft.bins(), ElementType::Float32, memory_);
+    auto envRows = env.rowPointers<float>();
+    auto apRows = ap.rowPointers<float>();
+    double trackHop = 0.0;
+    const auto* track = externalTrack(params_, *input, trackHop);
+    if (track) resampleF0(track->data(), track->size(), trackHop, f0.data(), f0.size(), static_cast<double>(hop));
+    const FrameChunks f0Chunks(track ? 0 : f0.size(), params_.framesPerTask);
+    const FrameChunks envChunks(frames, params_.framesPerTask);
+    parallelFor(analysisPool(), f0Chunks.count + envChunks.count, [&](size_t t) {
+        if (t < f0Chunks.count) {
+            estimateF0Frames(x, sr, hop, f0Chunks.first(t), f0Chunks.size(t), f0.data() + f0Chunks.first(t),
+                             params_.f0Floor, params_.f0Ceil);
+            return;
+        }
+        const size_t c = t - f0Chunks.count;
+        const size_t first = envChunks.first(c);
+        stftEnvelopeAperiodicityFrames(stft, x, sr, first, envChunks.size(c), envRows.data() + first, apRows.data() + first);
+    });
+    out->setFeature(FeatureKey::F0, std::move(f0));
+    out->setMatrix(FeatureKey::SpectralEnvelope, std::move(env));
+    out->setMatrix(FeatureKey::Aperiodicity, std::move(ap));
+    out->setScalar(FeatureKey::WorldHopSize, static_cast<double>(hop));
     return out;
 }
 
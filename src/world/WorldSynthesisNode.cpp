@@ -1,6 +1,10 @@
 #include "world/WorldSynthesisNode.h"
+#include "world/PulseVocoder.h"
+#include "world/WorldAnalysisNode.h"
+#include "world/SpectralCodec.h"
 #include <algorithm>
 #include <cmath>
+#include <thread>
 #ifdef VV_USE_WORLD
 extern "C" {
 #include <world/synthesis.h>
@@ -10,100 +14,212 @@ extern "C" {
 namespace vv {
 
 std::shared_ptr<DataPacket> WorldSynthesisNode::process(const std::shared_ptr<const DataPacket>& input) {
+    float phase = 0.0f;
+    return render(input, phase, synthesisThreads_ != 1);
+}
+
+std::shared_ptr<ISynthesisNode> WorldSynthesisNode::clone() const {
+    auto c = std::make_shared<WorldSynthesisNode>();
+    c->setId(id_); c->setName(name_);
+    c->postFilterEnabled_ = postFilterEnabled_;
+    c->memory_ = memory_;
+    c->synthesisThreads_ = synthesisThreads_;
+    c->nativeSynthesis_ = nativeSynthesis_;
+    synthesisPool();
+    {
+        std::lock_guard<std::mutex> lk(poolMutex_);
+        c->pool_ = pool_;
+    }
+    if (!postFilters_.clone(c->postFilters_)) return nullptr;
+    return c;
+}
+
+void WorldSynthesisNode::beginStream() {
+    streamPhase_ = 0.0f;
+    stream_.reset();
+    streamFrames_ = 0;
+    postFilters_.reset();
+}
+
+std::shared_ptr<DataPacket> WorldSynthesisNode::processBlock(const std::shared_ptr<const DataPacket>& block,
+                                                             const StreamBlock& info) {
+    if (block && block->samples().empty()) {
+        auto voc = std::make_shared<DataPacket>(std::vector<float>{}, block->sampleRate(), 1, block->bitDepth());
+        if (renderStream(*block, info.last, voc->samples())) {
+            applyPostFilters(*voc);
+            return voc;
+        }
+    }
+    return render(block, streamPhase_, false);
+}
+
+// False if the block lacks F0 or spectra of a consistent layout.
+bool WorldSynthesisNode::renderStream(const DataPacket& block, bool last, std::vector<float>& out) {
+    const auto* f0 = block.getFeature(FeatureKey::F0);
+    if (!f0 || f0->empty()) return false;
+    const uint32_t sr = block.sampleRate();
+    size_t fftSize = 0;
+    if (const auto* env = block.getMatrix(FeatureKey::SpectralEnvelope)) fftSize = env->cols() > 1 ? (env->cols() - 1) * 2 : 0;
+    else if (block.hasMatrix(FeatureKey::MelCepstrum)) fftSize = static_cast<size_t>(block.getScalar(FeatureKey::WorldFftSize, 0.0));
+    if (fftSize < 4) return false;
+    const double hop = block.getScalar(FeatureKey::WorldHopSize, static_cast<double>(sr) / 200.0);
+    if (!stream_ || stream_->config().sampleRate != sr || stream_->config().fftSize != fftSize ||
+        stream_->config().hopSize != hop) {
+        RealtimeSynthesisConfig cfg;
+        cfg.sampleRate = sr;
+        cfg.fftSize = fftSize;
+        cfg.hopSize = hop;
+        stream_ = std::make_unique<RealtimeSynthesizer>(cfg);
+        if (stream_->config().fftSize != fftSize) { stream_.reset(); return false; } // not a power of two
+        streamFrames_ = 0;
+    }
+    RealtimeSynthesizer& rt = *stream_;
+    streamBlock_.resize(rt.config().blockSize);
+    auto pullBlock = [&] {
+        rt.pull(streamBlock_.data());
+        out.insert(out.end(), streamBlock_.begin(), streamBlock_.end());
+    };
+    // Frames go in as fast as the queue drains; every block whose frames are complete
+    // comes out.
+    for (size_t pushed = 0;;) {
+        const size_t n = rt.pushFrames(block, pushed);
+        pushed += n;
+        streamFrames_ += n;
+        if (pushed == f0->size()) break;
+        // Nothing taken with room left: spectra missing or of another layout. (A full
+        // queue always covers the next block.)
+        if (n == 0 && (rt.freeFrames() > 0 || !rt.ready())) return false;
+        while (rt.ready() && rt.freeFrames() == 0) pullBlock();
+    }
+    if (!last) {
+        while (rt.ready()) pullBlock();
+        return true;
+    }
+    // The stream ends where process() does: ceil(frames * hop) samples in all.
+    rt.finish();
+    const size_t length = static_cast<size_t>(std::ceil(static_cast<double>(streamFrames_) * hop));
+    while (rt.samplesPulled() < length && rt.ready()) pullBlock();
+    const size_t excess = std::min(out.size(), rt.samplesPulled() - std::min(rt.samplesPulled(), length));
+    out.resize(out.size() - excess);
+    return true;
+}
+
+void WorldSynthesisNode::applyPostFilters(DataPacket& out) {
+    if (!postFilterEnabled_ || postFilters_.empty() || out.channels() < 1 || out.samples().empty()) return;
+    postFilters_.prepare(out.sampleRate(), out.channels());
+    postFilters_.process(out.samples().data(), out.samples().size() / out.channels());
+}
+
+// False if the packet lacks F0 or matching spectra.
+bool WorldSynthesisNode::renderNative(const DataPacket& input, bool parallel, std::vector<float>& out) {
+    const auto* f0 = input.getFeature(FeatureKey::F0);
+    if (!f0 || f0->empty()) return false;
+    const auto* env = input.getMatrix(FeatureKey::SpectralEnvelope);
+    const auto* ap = input.getMatrix(FeatureKey::Aperiodicity);
+    FeatureMatrix env_dec, ap_dec;
+    if (!env && decodeSpectralFeatures(input, ElementType::Float32, env_dec, ap_dec, memory_)) {
+        env = &env_dec;
+        ap = &ap_dec;
+    }
+    if (!env || !ap || env->cols() < 3) return false;
+    const uint32_t sr = input.sampleRate();
+    PulseVocoderConfig cfg;
+    cfg.sampleRate = sr;
+    cfg.fftSize = (env->cols() - 1) * 2;
+    cfg.hopSize = input.getScalar(FeatureKey::WorldHopSize, static_cast<double>(sr) / 200.0);
+    return PulseVocoder::synthesize(*f0, *env, *ap, cfg, out, parallel ? synthesisPool() : nullptr);
+}
+
+ThreadPool* WorldSynthesisNode::synthesisPool() const {
+    if (synthesisThreads_ == 1) return nullptr;
+    std::lock_guard<std::mutex> lk(poolMutex_);
+    if (!pool_) {
+        const unsigned n = synthesisThreads_ ? synthesisThreads_ : std::max(1u, std::thread::hardware_concurrency());
+        // The calling thread works too, so n threads in total need n - 1 workers.
+        if (n > 1) pool_ = std::make_shared<ThreadPool>(n - 1);
+    }
+    return pool_.get();
+}
+
+std::shared_ptr<DataPacket> WorldSynthesisNode::render(const std::shared_ptr<const DataPacket>& input, float& phase,
+                                                       bool parallel) {
     if (!input) return nullptr;
     // Very naive synthesis: passthrough samples if available, else synthesize sin from f0
     if (!input->samples().empty()) {
         auto out = std::make_shared<DataPacket>(*input);
-        // Apply optional post-filters
-        if (postFilterEnabled_ && !filters_.empty() && out->channels() >= 1) {
-            const uint32_t sr = out->sampleRate();
-            const uint16_t ch = out->channels();
-            if (!prepared_ || preparedSampleRate_ != sr || preparedChannels_ != ch) {
-                for (auto& f : filters_) if (f) { f->prepare(sr, ch); }
-                prepared_ = true; preparedSampleRate_ = sr; preparedChannels_ = ch;
-            }
-            // DataPacket stores interleaved mono/stereo in samples(); compute frames
-            size_t frames = ch > 0 ? out->samples().size() / ch : out->samples().size();
-            float* data = out->samples().data();
-            for (auto& f : filters_) if (f && frames > 0) { f->process(data, frames); }
-        }
+        applyPostFilters(*out);
         return out;
     }
     auto out = std::make_shared<DataPacket>(std::vector<float>{}, input->sampleRate(), input->channels(), input->bitDepth());
-    const auto* f0 = input->getFeature("f0");
+    const auto* f0 = input->getFeature(FeatureKey::F0);
     if (!f0 || f0->empty()) return out;
     const uint32_t sr = input->sampleRate();
 
 #ifdef VV_USE_WORLD
-    // Attempt WORLD resynthesis if we have spectral envelopes and aperiodicity
-    const auto* env = input->getFeature("spectral_envelope");
-    const auto* ap = input->getFeature("aperiodicity");
-    const int f0_length = static_cast<int>(input->getScalar("world_f0_len", 0.0));
-    const int fft_size = static_cast<int>(input->getScalar("world_fft_size", 0.0));
-    const int bins = static_cast<int>(input->getScalar("world_bins", 0.0));
-    if (env && ap && f0_length > 0 && bins > 0 && fft_size > 0 && static_cast<int>(f0->size()) == f0_length && static_cast<int>(env->size()) == f0_length * bins && static_cast<int>(ap->size()) == f0_length * bins) {
-        std::vector<double> f0_d(f0->begin(), f0->end());
-        std::vector<double> time_axis(f0_length);
+    const bool native = nativeSynthesis_; // WORLD renders serially (see setSynthesisThreads)
+#else
+    const bool native = true;
+#endif
+    if (native) {
+        auto voc = std::make_shared<DataPacket>(std::vector<float>{}, sr, 1, input->bitDepth());
+        if (renderNative(*input, parallel, voc->samples())) {
+            applyPostFilters(*voc);
+            return voc;
+        }
+    }
+
+#ifdef VV_USE_WORLD
+    // Attempt WORLD resynthesis if we have spectral envelope and aperiodicity matrices
+    // with one row per f0 frame and fft_size/2+1 columns.
+    const auto* env = input->getMatrix(FeatureKey::SpectralEnvelope);
+    const auto* ap = input->getMatrix(FeatureKey::Aperiodicity);
+    const int f0_length = static_cast<int>(f0->size());
+    // Compact spectra are expanded for this packet (or block) only, straight into doubles.
+    FeatureMatrix env_dec, ap_dec;
+    if (!env && decodeSpectralFeatures(*input, ElementType::Float64, env_dec, ap_dec, memory_)) {
+        env = &env_dec;
+        ap = &ap_dec;
+    }
+    if (!native && env && ap && env->cols() > 1 && env->rows() == f0->size() && ap->rows() == env->rows() && ap->cols() == env->cols()) {
+        const int fft_size = static_cast<int>((env->cols() - 1) * 2);
+        std::pmr::memory_resource* mem = memory_ ? memory_ : std::pmr::get_default_resource();
+        std::pmr::vector<double> f0_d(f0->begin(), f0->end(), mem);
         // Use frame period from f0 spacing: assume constant; default to 5 ms
         double frame_period_ms = 5.0;
         if (f0_length > 1) {
-            frame_period_ms = 1000.0 * input->getScalar("world_hop_size", static_cast<double>(sr / 200.0)) / static_cast<double>(sr);
-        }
-        for (int i = 0; i < f0_length; ++i) time_axis[i] = i * frame_period_ms / 1000.0;
-        // Rebuild matrices
-        std::vector<const double*> spec_rows(f0_length);
-        std::vector<const double*> ap_rows(f0_length);
-        std::vector<double> spec_d(env->begin(), env->end());
-        std::vector<double> ap_d(ap->begin(), ap->end());
-        for (int t = 0; t < f0_length; ++t) {
-            spec_rows[t] = spec_d.data() + static_cast<size_t>(t) * bins;
-            ap_rows[t] = ap_d.data() + static_cast<size_t>(t) * bins;
+            frame_period_ms = 1000.0 * input->getScalar(FeatureKey::WorldHopSize, static_cast<double>(sr / 200.0)) / static_cast<double>(sr);
         }
+        // WORLD reads the packet's double rows in place; float matrices are widened once.
+        FeatureMatrix env_d, ap_d;
+        if (!env->is<double>()) { env_d = env->converted(ElementType::Float64, mem); env = &env_d; }
+        if (!ap->is<double>()) { ap_d = ap->converted(ElementType::Float64, mem); ap = &ap_d; }
+        auto spec_rows = env->rowPointers<double>();
+        auto ap_rows = ap->rowPointers<double>();
         // Output length
     int y_length = static_cast<int>(std::ceil((f0_length * frame_period_ms / 1000.0) * static_cast<double>(sr)));
-        std::vector<double> y(y_length);
+        std::pmr::vector<double> y(static_cast<size_t>(y_length), mem);
+        std::lock_guard<std::mutex> world(worldMutex());
         Synthesis(f0_d.data(), f0_length, spec_rows.data(), ap_rows.data(), fft_size, frame_period_ms, sr, y_length, y.data());
         out->samples().reserve(y.size());
         for (double v : y) out->samples().push_back(static_cast<float>(v));
-        // Apply optional post-filters
-        if (postFilterEnabled_ && !filters_.empty() && out->channels() >= 1 && !out->samples().empty()) {
-            const uint32_t sr2 = out->sampleRate();
-            const uint16_t ch2 = out->channels();
-            if (!prepared_ || preparedSampleRate_ != sr2 || preparedChannels_ != ch2) {
-                for (auto& f : filters_) if (f) { f->prepare(sr2, ch2); }
-                prepared_ = true; preparedSampleRate_ = sr2; preparedChannels_ = ch2;
-            }
-            size_t frames2 = ch2 > 0 ? out->samples().size() / ch2 : out->samples().size();
-            float* data2 = out->samples().data();
-            for (auto& f : filters_) if (f && frames2 > 0) { f->process(data2, frames2); }
-        }
+        applyPostFilters(*out);
         return out;
     }
 #endif
 
-    // Fallback: Synthesize 1 frame per f0 hop, 10ms per hop as placeholder
+    // Fallback for F0-only packets: a tone, 10 ms per F0 value, as placeholder
     const size_t hopSamples = static_cast<size_t>(0.01 * sr);
-    float phase = 0.0f;
+    out->samples().resize(f0->size() * hopSamples);
+    float* y = out->samples().data();
     for (float f : *f0) {
-        size_t N = hopSamples;
-        for (size_t n = 0; n < N; ++n) {
-            float omega = 2.0f * 3.1415926535f * (f > 0.0f ? f : 100.0f) / static_cast<float>(sr);
+        const float omega = 2.0f * 3.1415926535f * (f > 0.0f ? f : 100.0f) / static_cast<float>(sr);
+        for (size_t n = 0; n < hopSamples; ++n) {
             phase += omega;
-            out->samples().push_back(std::sin(phase) * 0.1f);
-        }
-    }
-    // Apply optional post-filters
-    if (postFilterEnabled_ && !filters_.empty() && out->channels() >= 1 && !out->samples().empty()) {
-        const uint32_t sr3 = out->sampleRate();
-        const uint16_t ch3 = out->channels();
-        if (!prepared_ || preparedSampleRate_ != sr3 || preparedChannels_ != ch3) {
-            for (auto& f : filters_) if (f) { f->prepare(sr3, ch3); }
-            prepared_ = true; preparedSampleRate_ = sr3; preparedChannels_ = ch3;
+            if (phase > 2.0f * 3.1415926535f) phase -= 2.0f * 3.1415926535f; // bounded across long streams
+            *y++ = std::sin(phase) * 0.1f;
         }
-        size_t frames3 = ch3 > 0 ? out->samples().size() / ch3 : out->samples().size();
-        float* data3 = out->samples().data();
-        for (auto& f : filters_) if (f && frames3 > 0) { f->process(data3, frames3); }
     }
+    applyPostFilters(*out);
     return out;
 }
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <cmath>
@@ -7,12 +8,22 @@
 #include <filesystem>
 
 #include "core/DataPacket.h"
+#include "core/BlockSource.h"
 #include "core/ComputationGraph.h"
 #include "core/IPlatformIO.h"
+#include "core/MemoryResource.h"
+#include "core/NodeResultCache.h"
+#include "core/PacketDiskCache.h"
+#include "core/PacketFormat.h"
 #include "core/ISynthesisNode.h"
+#include "core/PostFilterChain.h"
+#include "core/ParameterExchange.h"
+#include "core/DspFilters.h"
 #include "utils/WavIO.h"
 #include "utils/SignalUtils.h"
 #include "utils/FFTWrapper.h"
+#include "utils/VectorMath.h"
+#include "utils/Biquad.h"
 
 using namespace vv;
 
@@ -26,18 +37,192 @@ public:
         for (auto& s : out->samples()) s *= gain_;
         return out;
     }
+    std::shared_ptr<ISynthesisNode> clone() const override { return std::make_shared<GainNode>(gain_, id_); }
     std::vector<std::string> getInputs() const override { return {"in"}; }
     std::vector<std::string> getOutputs() const override { return {"out"}; }
 private:
     float gain_;
 };
 
+// Stateful, non-clonable node: tags each packet with the number of packets seen so far
+class SequenceNode : public ISynthesisNode {
+public:
+    explicit SequenceNode(std::string id) { setId(std::move(id)); setName("Sequence"); }
+    bool initialize() override { return true; }
+    std::shared_ptr<DataPacket> process(const std::shared_ptr<const DataPacket>& input) override {
+        auto out = std::make_shared<DataPacket>(*input);
+        out->setScalar("seq", static_cast<double>(seen_++));
+        return out;
+    }
+    std::vector<std::string> getInputs() const override { return {"in"}; }
+    std::vector<std::string> getOutputs() const override { return {"out"}; }
+private:
+    size_t seen_{0};
+};
+
+// Memoizable gain that counts how often it actually runs
+class CountingGainNode : public ISynthesisNode {
+public:
+    CountingGainNode(float g, std::string id) : gain_(g) { setId(std::move(id)); setName("CountingGain"); }
+    bool initialize() override { return true; }
+    std::shared_ptr<DataPacket> process(const std::shared_ptr<const DataPacket>& input) override {
+        ++calls;
+        auto out = std::make_shared<DataPacket>(*input);
+        for (auto& s : out->samples()) s *= gain_;
+        return out;
+    }
+    bool parameterHash(uint64_t& h) const override { h = hash::value(gain_); return true; }
+    std::vector<std::string> getInputs() const override { return {"in"}; }
+    std::vector<std::string> getOutputs() const override { return {"out"}; }
+    void setGain(float g) { gain_ = g; }
+    int calls{0};
+private:
+    float gain_;
+};
+
+// Stateful post-filter (per-channel one-pole smoother) that records how it is driven
+class SmoothingFilter : public IPostFilter {
+public:
+    explicit SmoothingFilter(float a) : a_(a) {}
+    void prepare(uint32_t /*sampleRate*/, uint16_t channels) override { channels_ = channels; reset(); }
+    void reset() override { state_.assign(channels_, 0.0f); }
+    void process(float* interleaved, size_t frames) override {
+        ++calls;
+        largestBlock = std::max(largestBlock, frames);
+        for (size_t i = 0; i < frames; ++i)
+            for (uint16_t c = 0; c < channels_; ++c) {
+                float& y = state_[c];
+                y += a_ * (interleaved[i * channels_ + c] - y);
+                interleaved[i * channels_ + c] = y;
+            }
+    }
+    std::shared_ptr<IPostFilter> clone() const override { return std::make_shared<SmoothingFilter>(a_); }
+    size_t calls{0}, largestBlock{0};
+private:
+    float a_;
+    uint16_t channels_{1};
+    std::vector<float> state_;
+};
+
 int main() {
     // DataPacket basic behavior
     std::vector<float> samples = {0.5f, -0.5f, 1.0f};
     DataPacket pkt(samples, 48000, 1, 32);
     assert(pkt.samples().size() == samples.size());
 
+    // Copy-on-write: copies share storage until one side mutates
+    {
+        DataPacket base(samples, 48000, 1, 32);
+        base.setFeature("f0", std::vector<float>{100.0f, 110.0f});
+        DataPacket copy = base;
+        const DataPacket& cbase = base;
+        const DataPacket& ccopy = copy;
+        assert(ccopy.samples().data() == cbase.samples().data());
+        assert(ccopy.getFeature("f0")->data() == cbase.getFeature("f0")->data());
+        copy.samples()[0] = 9.0f;            // detaches samples only
+        (*copy.getFeature("f0"))[1] = 1.0f;  // detaches f0 only
+        assert(cbase.samples()[0] == samples[0] && ccopy.samples()[0] == 9.0f);
+        assert((*cbase.getFeature("f0"))[1] == 110.0f && (*ccopy.getFeature("f0"))[1] == 1.0f);
+        (void)ccopy;
+        // sharing an immutable buffer into another packet does not copy it
+        auto shared = cbase.sharedFeature("f0");
+        DataPacket other;
+        other.setFeature("f0", shared);
+        const DataPacket& cother = other;
+        assert(cother.getFeature("f0")->data() == shared->data());
+        (void)cother;
+        (*other.getFeature("f0"))[0] = 0.0f;
+        assert((*shared)[0] == 100.0f);
+    }
+
+    // Interned keys: fixed ids for WORLD keys, runtime ids for custom ones, same slots either way
+    {
+        auto& reg = FeatureRegistry::global();
+        assert(reg.intern("f0") == FeatureKey::F0 && reg.name(FeatureKey::Aperiodicity) == "aperiodicity");
+        FeatureKey unknown;
+        assert(!reg.find("vv_test_never_set", unknown));
+        const FeatureKey custom = reg.intern("vv_test_custom");
+        assert(keyIndex(custom) >= keyIndex(FeatureKey::WellKnownCount) && reg.intern("vv_test_custom") == custom);
+        DataPacket k(samples);
+        k.setFeature(FeatureKey::F0, std::vector<float>{1.0f, 2.0f});
+        k.setScalar("vv_test_custom", 3.0);
+        k.setFeature(custom, std::vector<float>{4.0f}); // feature and scalar namespaces are separate
+        assert(k.getFeature("f0")->size() == 2 && k.getScalar(custom) == 3.0 && (*k.getFeature(custom))[0] == 4.0f);
+        assert(!k.hasScalar(FeatureKey::F0) && !k.hasFeature("vv_test_never_set") && k.getScalar("vv_test_never_set", 7.0) == 7.0);
+        assert(!reg.find("vv_test_never_set", unknown)); // lookups do not register names
+        (void)unknown;
+        size_t features = 0;
+        k.forEachFeature([&](const std::string& name, const std::vector<float>&) {
+            assert(name == "f0" || name == "vv_test_custom");
+            (void)name;
+            ++features;
+        });
+        assert(features == 2);
+        k.removeFeature(custom);
+        assert(!k.hasFeature(custom) && k.hasScalar(custom));
+    }
+
+    // FeatureMatrix: aligned rows, typed views, copy-on-write inside DataPacket
+    {
+        FeatureMatrix m(3, 5, ElementType::Float64);
+        assert(m.stride() == 8 && m.byteSize() == 3 * 8 * sizeof(double));
+        for (size_t r = 0; r < m.rows(); ++r) {
+            assert(reinterpret_cast<uintptr_t>(m.row<double>(r)) % FeatureMatrix::kAlignment == 0);
+            for (size_t c = 0; c < m.cols(); ++c) m.row<double>(r)[c] = static_cast<double>(r * 10 + c);
+        }
+        assert(m.row<float>(0) == nullptr); // wrong element type
+        auto col = m.column<double>(4);
+        assert(col.size == 3 && col[2] == 24.0);
+        (void)col;
+        auto ptrs = m.rowPointers<double>();
+        assert(ptrs.size() == 3 && ptrs[1][2] == 12.0);
+        auto f = m.converted(ElementType::Float32);
+        assert(f.is<float>() && f.stride() == 16 && f.at(2, 3) == 23.0);
+        auto tail = m.sliceRows(1, 5);
+        assert(tail.rows() == 2 && tail.at(0, 0) == 10.0);
+        std::vector<float> flat = {1, 2, 3, 4, 5, 6};
+        auto fm = FeatureMatrix::fromRowMajor(flat.data(), 2, 3);
+        assert(fm.at(1, 0) == 4.0 && fm.contentHash() == FeatureMatrix(fm).contentHash());
+
+        DataPacket a(samples);
+        a.setMatrix("sp", std::move(m));
+        DataPacket b = a;
+        const DataPacket& ca = a;
+        const DataPacket& cb = b;
+        assert(ca.getMatrix("sp")->data() == cb.getMatrix("sp")->data());
+        assert(a.contentHash() == b.contentHash());
+        b.getMatrix("sp")->set(0, 0, -1.0); // detaches b's copy only
+        assert(ca.getMatrix("sp")->at(0, 0) == 0.0 && cb.getMatrix("sp")->at(0, 0) == -1.0);
+        (void)cb;
+        assert(a.contentHash() != b.contentHash());
+        assert(a.byteSize() > samples.size() * sizeof(float) + 3 * 5 * sizeof(double));
+
+        // binary format keeps matrices, zero-copy and aligned
+        auto bytes = packetio::encode(a);
+        packetio::PacketView view;
+        const bool opened = view.open(bytes.data(), bytes.size());
+        assert(opened); (void)opened;
+        auto mv = view.matrix("sp");
+        assert(mv.rows == 3 && mv.cols == 5 && mv.row<double>(2)[4] == 24.0);
+        assert((reinterpret_cast<const std::byte*>(mv.data) - bytes.data()) % packetio::kAlign == 0);
+        (void)mv;
+        DataPacket back;
+        const bool decoded = packetio::decode(bytes.data(), bytes.size(), back);
+        assert(decoded && back.contentHash() == a.contentHash()); (void)decoded;
+
+        // block slicing cuts per-frame matrices by rows
+        auto framed = std::make_shared<DataPacket>(std::vector<float>(12, 0.0f), 48000, 1, 32);
+        framed->setFeature("f0", std::vector<float>{100, 101, 102});
+        framed->setMatrix("sp", *ca.getMatrix("sp"));
+        PacketBlockSource src(framed, 2, 4);
+        std::shared_ptr<const DataPacket> blk; StreamBlock info;
+        bool next = src.next(blk, info);
+        assert(next && blk->getMatrix("sp")->rows() == 2);
+        next = src.next(blk, info);
+        assert(next && blk->getMatrix("sp")->rows() == 1 && blk->getMatrix("sp")->at(0, 4) == 24.0);
+        (void)next;
+    }
+
     // PlatformIO
     auto io = makePlatformIO();
     auto mem = io->allocateMemory(1024);
@@ -45,6 +230,141 @@ int main() {
     io->deallocateMemory(mem);
     assert(mem.size == 0);
 
+    // Allocators: page-backed arena with one-shot reset, size-class pool reuse
+    {
+        for (bool huge : {false, true}) {
+            auto* pages = io->pageResource(huge);
+            void* p = pages->allocate(10000, 64);
+            assert(p && reinterpret_cast<uintptr_t>(p) % 4096 == 0);
+            static_cast<char*>(p)[9999] = 1;
+            pages->deallocate(p, 10000, 64);
+        }
+        Arena arena(io->pageResource(true), 1 << 16);
+        void* a1 = arena.allocate(100, 8);
+        void* a2 = arena.allocate(100, 64);
+        assert(reinterpret_cast<uintptr_t>(a2) % 64 == 0 && a2 > a1);
+        (void)a2;
+        {
+            FeatureMatrix big(100, 513, ElementType::Float64, &arena); // larger than a chunk
+            assert(big.row<double>(99)[512] == 0.0 && reinterpret_cast<uintptr_t>(big.row<double>(1)) % 64 == 0);
+        }
+        const size_t reserved = arena.bytesReserved();
+        assert(arena.chunkCount() == 2 && arena.bytesUsed() >= 100 * 520 * sizeof(double));
+        arena.reset();
+        assert(arena.bytesUsed() == 0);
+        void* first = arena.allocate(100, 8);
+        assert(first == a1);
+        (void)first; (void)a1;
+        FeatureMatrix again(100, 513, ElementType::Float64, &arena); // reuses the retained chunk
+        assert(arena.bytesReserved() == reserved);
+        (void)reserved;
+        std::pmr::vector<double> scratch(1000, 1.0, &arena);
+        assert(scratch[999] == 1.0);
+
+        SizeClassPool pool;
+        assert(SizeClassPool::classIndex(64) == 0 && SizeClassPool::classIndex(65) == 1);
+        void* b1 = pool.allocate(200, 16);
+        pool.deallocate(b1, 200, 16);
+        void* b2 = pool.allocate(256, 64); // same class, comes back from the free list
+        assert(b2 == b1 && pool.reused() == 1 && pool.upstreamAllocations() == 1);
+        void* large = pool.allocate(SizeClassPool::kMaxPooled + 1, 8);
+        assert(pool.upstreamAllocations() == 2);
+        pool.deallocate(large, SizeClassPool::kMaxPooled + 1, 8);
+        pool.deallocate(b2, 256, 64);
+    }
+
+    // Binary packet format: lossless round-trip, zero-copy views, mmap load, corruption
+    {
+        DataPacket p({0.25f, -0.5f, 1.0f}, 22050, 1, 16);
+        p.setFeature("f0", std::vector<float>{100.0f, 110.0f, 120.0f, 130.0f});
+        p.setFeature("empty", std::vector<float>{});
+        p.setScalar("world_f0_len", 4.0);
+        p.setScalar("pi", 3.141592653589793);
+        auto bytes = packetio::encode(p);
+        assert(bytes.size() % 8 == 0);
+
+        DataPacket q;
+        const bool decoded = packetio::decode(bytes.data(), bytes.size(), q);
+        assert(decoded); (void)decoded;
+        assert(q.sampleRate() == 22050 && q.bitDepth() == 16 && q.contentHash() == p.contentHash());
+        assert(q.getScalar("pi") == 3.141592653589793);
+
+        packetio::PacketView view;
+        bool opened = view.open(bytes.data(), bytes.size());
+        assert(opened);
+        auto f0 = view.feature("f0");
+        const auto* base = reinterpret_cast<const float*>(bytes.data());
+        assert(f0.size == 4 && f0[3] == 130.0f);
+        assert(f0.data > base && f0.data < base + bytes.size() / sizeof(float)); // points into the buffer
+        assert((reinterpret_cast<const std::byte*>(f0.data) - bytes.data()) % packetio::kAlign == 0);
+        assert(view.hasFeature("empty") && view.feature("empty").empty());
+        assert(view.scalar("world_f0_len") == 4.0 && view.scalar("missing", -1.0) == -1.0);
+        (void)f0; (void)base;
+
+        namespace fs = std::filesystem;
+        const auto path = (fs::temp_directory_path() / "vv_test_packet.vvpk").string();
+        const bool wrote = packetio::writeFile(*io, path, p);
+        assert(wrote); (void)wrote;
+        packetio::MappedPacket mapped;
+        const bool mappedOk = mapped.open(*io, path);
+        assert(mappedOk); (void)mappedOk;
+        assert(mapped.view().samples().size == 3 && mapped.view().feature("f0")[0] == 100.0f);
+        DataPacket r;
+        const bool read = packetio::readFile(*io, path, r);
+        assert(read && r.contentHash() == p.contentHash()); (void)read;
+        std::error_code ec; fs::remove(path, ec);
+
+        opened = view.open(bytes.data(), bytes.size() - 8);
+        assert(!opened);                                      // truncated
+        auto bad = bytes; bad[0] = std::byte{'X'};
+        opened = view.open(bad.data(), bad.size());
+        assert(!opened);                                      // bad magic
+        bad = bytes; bad[40] = std::byte{0xFF}; bad[41] = std::byte{0xFF}; bad[42] = std::byte{0xFF};
+        opened = view.open(bad.data(), bad.size());
+        assert(!opened); (void)opened;                        // directory out of range
+        assert(!packetio::decode(nullptr, 0, r));
+    }
+
+    // Disk cache: round-trip across instances, corrupt entries miss, LRU eviction by budget
+    {
+        namespace fs = std::filesystem;
+        const auto dir = (fs::temp_directory_path() / "vv_test_disk_cache").string();
+        std::error_code ec; fs::remove_all(dir, ec);
+        DataPacket p({0.5f, -0.5f}, 22050, 1, 16);
+        p.setFeature("f0", std::vector<float>(64, 200.0f));
+        {
+            PacketDiskCache cache(dir);
+            assert(cache.good());
+            DataPacket q;
+            const bool hit = cache.load(1, q);
+            assert(!hit && cache.misses() == 1); (void)hit;
+            const bool stored = cache.store(1, p);
+            assert(stored && cache.bytes() > 0); (void)stored;
+        }
+        PacketDiskCache cache(dir);
+        DataPacket q;
+        bool hit = cache.load(1, q);
+        assert(hit && q.contentHash() == p.contentHash() && cache.hits() == 1);
+        { std::FILE* f = std::fopen((dir + "/0000000000000002.vvpk").c_str(), "wb"); std::fputs("junk", f); std::fclose(f); }
+        hit = cache.load(2, q);
+        assert(!hit && !fs::exists(dir + "/0000000000000002.vvpk"));
+        // an entry that cannot be read (here: a directory in its place) is a miss, not deleted
+        fs::create_directory(dir + "/0000000000000003.vvpk");
+        hit = cache.load(3, q);
+        assert(!hit && fs::exists(dir + "/0000000000000003.vvpk"));
+        fs::remove(dir + "/0000000000000003.vvpk");
+
+        const uint64_t entry = cache.bytes();
+        PacketDiskCache small(dir, entry * 2 + entry / 2);
+        const bool stored = small.store(2, p) && small.store(3, p);
+        assert(stored && small.evictions() == 1); (void)stored;
+        hit = small.load(1, q);
+        assert(!hit);
+        hit = small.load(2, q) && small.load(3, q);
+        assert(hit && small.bytes() <= small.budget()); (void)hit;
+        fs::remove_all(dir, ec);
+    }
+
     // Graph topology and processing order
     ComputationGraph g;
     auto n1 = std::make_shared<GainNode>(2.0f, "n1");
@@ -69,6 +389,346 @@ int main() {
         assert(std::abs(out2->samples()[i] - samples[i]) < 1e-6f);
     }
 
+    // Dependency-driven execution on the work-stealing pool: a diamond n1 -> {a, b} -> join
+    {
+        ComputationGraph dg;
+        auto src = std::make_shared<GainNode>(2.0f, "src");
+        auto a = std::make_shared<GainNode>(3.0f, "a");
+        auto b = std::make_shared<GainNode>(5.0f, "b");
+        auto join = std::make_shared<GainNode>(0.5f, "join");
+        bool built = dg.addNode(src) && dg.addNode(a) && dg.addNode(b) && dg.addNode(join);
+        built = built && dg.connectNodes("src", "a") && dg.connectNodes("src", "b");
+        built = built && dg.connectNodes("a", "join") && dg.connectNodes("b", "join");
+        assert(built); (void)built;
+        for (unsigned threads : {1u, 4u}) {
+            for (int rep = 0; rep < 20; ++rep) {
+                std::unordered_map<std::string, std::shared_ptr<DataPacket>> outs;
+                const bool ok = dg.execute(in, outs, threads);
+                assert(ok); (void)ok;
+                assert(outs.size() == 4);
+                assert(std::abs(outs["a"]->samples()[0] - samples[0] * 6.0f) < 1e-6f);
+                assert(std::abs(outs["b"]->samples()[0] - samples[0] * 10.0f) < 1e-6f);
+                // join consumes one of its (completed) predecessors
+                float j = outs["join"]->samples()[0];
+                assert(std::abs(j - samples[0] * 3.0f) < 1e-6f || std::abs(j - samples[0] * 5.0f) < 1e-6f);
+                (void)j;
+            }
+        }
+        // Compiled plan: dense indices in topological order, reusable run state
+        ExecutionPlan plan;
+        const bool compiled = dg.compile(plan);
+        assert(compiled); (void)compiled;
+        assert(plan.size() == 4 && plan.sources().size() == 1 && plan.sinks().size() == 1);
+        const uint32_t srcIdx = plan.indexOf("src");
+        const uint32_t joinIdx = plan.indexOf("join");
+        assert(srcIdx == 0 && joinIdx == 3 && plan.predCount(joinIdx) == 2 && plan.succCount(srcIdx) == 2);
+        (void)srcIdx; (void)joinIdx;
+        ExecutionState state(plan);
+        for (unsigned threads : {1u, 4u}) {
+            for (int rep = 0; rep < 20; ++rep) {
+                const bool ok = dg.run(plan, in, state, threads);
+                assert(ok); (void)ok;
+                assert(std::abs(state.output(srcIdx)->samples()[2] - samples[2] * 2.0f) < 1e-6f);
+                assert(state.output(joinIdx));
+            }
+        }
+
+        // Block streaming: 1000 samples in blocks of 3 frames x 64 samples, pipelined
+        {
+            std::vector<float> ramp(1000);
+            for (size_t i = 0; i < ramp.size(); ++i) ramp[i] = static_cast<float>(i) * 1e-3f;
+            auto whole = std::make_shared<const DataPacket>(ramp);
+            for (unsigned threads : {1u, 4u}) {
+                PacketBlockSource blocks(whole, 3, 64);
+                assert(blocks.totalFrames() == 16 && blocks.blockCount() == 6);
+                std::vector<float> streamed;
+                size_t expectIndex = 0;
+                StreamOptions so; so.maxThreads = threads; so.maxInFlight = 3;
+                bool ok = dg.runStreaming(plan,
+                    [&](std::shared_ptr<const DataPacket>& b, StreamBlock& info) { return blocks.next(b, info); },
+                    [&](const StreamBlock& info, const std::shared_ptr<DataPacket>& o) {
+                        assert(info.index == expectIndex);
+                        ++expectIndex; (void)info;
+                        streamed.insert(streamed.end(), o->samples().begin(), o->samples().end());
+                        return true;
+                    }, so);
+                assert(ok && expectIndex == 6 && streamed.size() == ramp.size());
+                (void)ok;
+                assert(std::abs(streamed[999] - ramp[999] * 3.0f) < 1e-4f || std::abs(streamed[999] - ramp[999] * 5.0f) < 1e-4f);
+            }
+        }
+
+        // Batch mode: packets run concurrently, results come back in input order
+        {
+            ComputationGraph bg;
+            bool built = bg.addNode(std::make_shared<GainNode>(2.0f, "pre"));
+            built = built && bg.addNode(std::make_shared<SequenceNode>("seq"));
+            built = built && bg.addNode(std::make_shared<GainNode>(3.0f, "post"));
+            built = built && bg.connectNodes("pre", "seq") && bg.connectNodes("seq", "post");
+            ExecutionPlan bplan;
+            built = built && bg.compile(bplan);
+            assert(built); (void)built;
+            std::vector<std::shared_ptr<const DataPacket>> batch;
+            for (int k = 0; k < 50; ++k) batch.push_back(std::make_shared<DataPacket>(std::vector<float>{static_cast<float>(k)}));
+            for (unsigned threads : {1u, 4u}) {
+                for (size_t inflight : {1u, 3u, 8u}) {
+                    std::vector<std::shared_ptr<DataPacket>> results;
+                    BatchOptions bo; bo.maxThreads = threads; bo.maxInFlight = inflight;
+                    const bool ok = bg.executeBatch(bplan, batch, results, bo);
+                    assert(ok); (void)ok;
+                    assert(results.size() == batch.size());
+                    for (size_t k = 0; k < results.size(); ++k) {
+                        assert(results[k] && std::abs(results[k]->samples()[0] - 6.0f * k) < 1e-4f);
+                    }
+                    // the non-clonable node saw packets one at a time, in order
+                    for (size_t k = 1; k < results.size(); ++k) {
+                        assert(results[k]->getScalar("seq") == results[k - 1]->getScalar("seq") + 1.0);
+                    }
+                }
+            }
+        }
+
+        // Tracing: one process event per node, plus initialize events; silent when disabled
+        {
+            auto tracer = std::make_shared<GraphTracer>(false);
+            dg.setTracer(tracer);
+            bool ran = dg.run(plan, in, state, 4);
+            assert(ran && tracer->events().empty());
+            tracer->setEnabled(true);
+            ran = dg.run(plan, in, state, 4);
+            assert(ran); (void)ran;
+            auto events = tracer->events();
+            size_t processEvents = 0;
+            for (const auto& e : events) {
+                assert(e.endNs >= e.startNs);
+                if (e.phase == TraceEvent::Phase::Process) {
+                    ++processEvents;
+                    assert(e.startNs >= e.readyNs);
+                    assert(e.inSamples == samples.size() && e.outSamples == samples.size());
+                }
+            }
+            assert(processEvents == 4 && events.size() == 8);
+            auto summary = tracer->summary();
+            assert(summary.size() == 4 && summary[0].calls == 1);
+            // feature sizes count matrix cells as well as vector features
+            DataPacket sized(samples);
+            sized.setFeature(FeatureKey::F0, std::vector<float>(10));
+            sized.setMatrix(FeatureKey::SpectralEnvelope, FeatureMatrix(10, 513, ElementType::Float32));
+            uint64_t ns = 0, nv = 0;
+            GraphTracer::measure(&sized, ns, nv);
+            assert(ns == samples.size() && nv == 10 + 10 * 513);
+            auto json = tracer->toChromeTrace();
+            assert(json.find("\"traceEvents\"") != std::string::npos && json.find("\"name\":\"join\"") != std::string::npos);
+            dg.setTracer(nullptr);
+        }
+
+        // Memoization: unchanged nodes are skipped on re-run, edits recompute downstream only
+        {
+            ComputationGraph mg;
+            auto up = std::make_shared<CountingGainNode>(2.0f, "up");
+            auto down = std::make_shared<CountingGainNode>(3.0f, "down");
+            bool built = mg.addNode(up) && mg.addNode(down) && mg.connectNodes("up", "down");
+            auto cache = std::make_shared<NodeResultCache>(1 << 20);
+            mg.setResultCache(cache);
+            ExecutionPlan mplan;
+            built = built && mg.compile(mplan);
+            assert(built); (void)built;
+            ExecutionState mstate(mplan);
+            bool ran = mg.run(mplan, in, mstate, 1);
+            assert(ran && up->calls == 1 && down->calls == 1);
+            ran = mg.run(mplan, in, mstate, 4);
+            assert(ran && up->calls == 1 && down->calls == 1);
+            down->setGain(4.0f);
+            ran = mg.run(mplan, in, mstate, 1);
+            assert(ran && up->calls == 1 && down->calls == 2);
+            assert(std::abs(mstate.output(1)->samples()[0] - samples[0] * 8.0f) < 1e-6f);
+            // equal content from a different packet object still hits
+            auto same = std::make_shared<DataPacket>(samples);
+            ran = mg.run(mplan, same, mstate, 1);
+            assert(ran && up->calls == 1 && down->calls == 2);
+            // outputs do not alias cache entries: editing one leaves later hits intact
+            mstate.output(1)->samples()[0] = 99.0f;
+            mstate.output(1)->setScalar("edited", 1.0);
+            ran = mg.run(mplan, in, mstate, 1);
+            assert(ran && up->calls == 1 && down->calls == 2);
+            assert(std::abs(mstate.output(1)->samples()[0] - samples[0] * 8.0f) < 1e-6f && !mstate.output(1)->hasScalar("edited"));
+            (void)ran;
+            // budget: shrinking evicts least-recently-used entries
+            assert(cache->entries() == 3);
+            cache->setBudget(cache->bytes() - 1);
+            assert(cache->entries() < 3 && cache->bytes() < cache->budget() + 1);
+            // content hash ignores key insertion order
+            DataPacket a(samples), b(samples);
+            a.setScalar("x", 1.0); a.setScalar("y", 2.0);
+            b.setScalar("y", 2.0); b.setScalar("x", 1.0);
+            assert(a.contentHash() == b.contentHash());
+            b.setScalar("x", 1.5);
+            assert(a.contentHash() != b.contentHash());
+        }
+
+        // Cycles are rejected
+        const bool connected = dg.connectNodes("join", "src");
+        assert(connected); (void)connected;
+        ExecutionPlan cyclic;
+        const bool compiledCyclic = dg.compile(cyclic);
+        assert(!compiledCyclic); (void)compiledCyclic;
+        std::unordered_map<std::string, std::shared_ptr<DataPacket>> outs;
+        const bool ran = dg.execute(in, outs);
+        assert(!ran); (void)ran;
+    }
+
+    // Post-filter chain: tiles give the whole-buffer result, bypassed filters never run
+    {
+        std::vector<float> x(2 * 5000);
+        for (size_t i = 0; i < x.size(); ++i) x[i] = std::sin(0.01f * i) + ((i * 7919) % 13) * 0.05f;
+        std::vector<float> ref = x;
+        SmoothingFilter f1(0.3f), f2(0.05f);
+        f1.prepare(48000, 2); f2.prepare(48000, 2);
+        f1.process(ref.data(), 5000); f2.process(ref.data(), 5000);
+
+        PostFilterChain chain;
+        auto a = std::make_shared<SmoothingFilter>(0.3f), b = std::make_shared<SmoothingFilter>(0.05f);
+        auto skipped = std::make_shared<SmoothingFilter>(0.9f);
+        chain.add(a); chain.add(skipped); chain.add(b);
+        chain.setBypassed(1, true);
+        assert(chain.size() == 3 && chain.activeCount() == 2 && chain.isBypassed(1));
+        chain.setTileSamples(2 * 256);
+        chain.prepare(48000, 2);
+        assert(chain.tileFrames() == 256);
+        std::vector<float> y = x;
+        chain.process(y.data(), 5000);
+        assert(y == ref);
+        assert(a->calls == 20 && a->largestBlock == 256 && skipped->calls == 0);
+
+        // Clones keep bypass flags and start from cleared state
+        PostFilterChain copy;
+        const bool cloned = chain.clone(copy);
+        assert(cloned && copy.size() == 3 && copy.isBypassed(1)); (void)cloned;
+        copy.prepare(48000, 2);
+        std::vector<float> z = x;
+        copy.process(z.data(), 5000);
+        assert(z == ref);
+        chain.setBypassed(1, false);
+        assert(chain.activeCount() == 3);
+    }
+
+    // Parameter exchange: only the newest published set arrives, once
+    {
+        ParameterExchange<int> px(1);
+        int v = 0;
+        bool fresh = px.fetch(v);
+        assert(!fresh);
+        px.publish(2); px.publish(3);
+        fresh = px.fetch(v);
+        assert(fresh && v == 3);
+        fresh = px.fetch(v);
+        assert(!fresh && px.latest() == 3);
+        px.publish(4);
+        fresh = px.fetch(v);
+        assert(fresh && v == 4); (void)fresh;
+    }
+
+    // Biquad cascade: the wavefront path equals running sample by sample
+    {
+        iir::BiquadCascade wave, serial;
+        wave.setSections(8); serial.setSections(8);
+        for (size_t s = 0; s < 8; ++s) {
+            const auto c = iir::design(iir::BiquadType::Peaking, 48000, 200.0 * (s + 1), 1.0, s % 2 ? 6.0 : -4.0);
+            wave.setCoeffs(s, c); serial.setCoeffs(s, c);
+        }
+        std::vector<float> x(3000);
+        for (size_t i = 0; i < x.size(); ++i) x[i] = std::sin(0.013f * i) + ((i * 7919) % 17) * 0.03f;
+        std::vector<float> y = x, z = x;
+        wave.process(y.data(), 1000); wave.process(y.data() + 1000, 2000);
+        for (size_t i = 0; i < z.size(); ++i) serial.process(&z[i], 1);
+        assert(y == z);
+    }
+
+    // DSP post-filters
+    {
+        auto tone = [](float hz, float amp, size_t n) {
+            std::vector<float> v(n);
+            for (size_t i = 0; i < n; ++i) v[i] = amp * std::sin(6.28318530718f * hz * i / 48000.0f);
+            return v;
+        };
+        auto peak = [](const std::vector<float>& v, size_t from) {
+            float p = 0.0f;
+            for (size_t i = from; i < v.size(); ++i) p = std::max(p, std::fabs(v[i]));
+            return p;
+        };
+        // EQ: +6 dB peak at its centre, untouched far away
+        EqualizerParams eq; eq.bands = 1;
+        eq.band[0] = EqBand{iir::BiquadType::Peaking, 1000.0f, 1.0f, 6.0f};
+        EqualizerFilter eqf(eq);
+        eqf.prepare(48000, 1);
+        auto a = tone(1000.0f, 0.25f, 9600);
+        eqf.process(a.data(), a.size());
+        assert(std::fabs(peak(a, 4800) - 0.25f * 1.9953f) < 0.01f);
+        // a change published mid-stream glides to the new gain
+        eq.band[0].gainDb = 0.0f;
+        eqf.setParams(eq);
+        auto b = tone(1000.0f, 0.25f, 9600);
+        eqf.process(b.data(), b.size());
+        assert(peak(b, 0) > 0.3f && std::fabs(peak(b, 4800) - 0.25f) < 0.01f);
+
+        // Limiter: nothing exceeds the ceiling
+        CompressorFilter lim(CompressorParams::limiter(-6.0f));
+        lim.prepare(48000, 2);
+        std::vector<float> st(2 * 4800);
+        for (size_t i = 0; i < 4800; ++i) st[2 * i] = st[2 * i + 1] = std::sin(0.05f * i);
+        lim.process(st.data(), 4800);
+        assert(peak(st, 0) <= 0.5012f && peak(st, 4800) > 0.45f);
+        // Compressor: 4:1 over -18 dB takes a 0 dB tone to about -13.5 dB
+        CompressorParams cp; cp.kneeDb = 0.0f;
+        CompressorFilter comp(cp);
+        comp.prepare(48000, 1);
+        auto c = tone(440.0f, 1.0f, 9600);
+        comp.process(c.data(), c.size());
+        assert(std::fabs(20.0f * std::log10(peak(c, 4800)) + 13.5f) < 1.0f);
+
+        // De-esser: sibilance is cut, a low voice band is not
+        DeEsserFilter des;
+        des.prepare(48000, 1);
+        auto s = tone(6500.0f, 0.5f, 9600), v = tone(200.0f, 0.5f, 9600);
+        des.process(s.data(), s.size());
+        des.reset();
+        des.process(v.data(), v.size());
+        assert(peak(s, 4800) < 0.5f * 0.5f && std::fabs(peak(v, 4800) - 0.5f) < 0.02f);
+
+        // Tilt: treble up, bass down; clones keep the parameters
+        TiltFilter tilt(TiltParams{12.0f, 1000.0f});
+        auto tc = tilt.clone();
+        tc->prepare(48000, 1);
+        auto lo = tone(100.0f, 0.25f, 9600), hi = tone(10000.0f, 0.25f, 9600);
+        tc->process(lo.data(), lo.size());
+        tc->reset();
+        tc->process(hi.data(), hi.size());
+        assert(peak(lo, 4800) < 0.25f * 0.6f && peak(hi, 4800) > 0.25f * 1.6f);
+        // Back to flat and away again: the shelves resume from cleared history, exactly
+        // like a filter that was flat all along
+        TiltFilter t2(TiltParams{12.0f, 1000.0f}), t3(TiltParams{0.0f, 1000.0f});
+        t2.prepare(48000, 1); t3.prepare(48000, 1);
+        auto w = tone(3000.0f, 0.25f, 9600), w3 = tone(300.0f, 0.25f, 9600);
+        t2.process(w.data(), w.size());
+        t2.setParams(TiltParams{0.0f, 1000.0f});
+        t2.process(w.data(), w.size()); t2.process(w.data(), w.size()); // glide settles at 0
+        auto w2 = w3;
+        t3.process(w3.data(), 64); t2.process(w2.data(), 64); // flat
+        t2.setParams(TiltParams{12.0f, 1000.0f}); t3.setParams(TiltParams{12.0f, 1000.0f});
+        t2.process(w2.data() + 64, w2.size() - 64); t3.process(w3.data() + 64, w3.size() - 64);
+        assert(w2 == w3);
+
+        // Band counts past the cascade's capacity are clamped
+        EqualizerParams many; many.bands = 20;
+        EqualizerFilter eqMany(many);
+        eqMany.prepare(48000, 1);
+        eqMany.setParams(many);
+        auto m = tone(1000.0f, 0.25f, 256);
+        eqMany.process(m.data(), m.size());
+        assert(eqMany.params().bands == iir::BiquadCascade::kMaxSections);
+        (void)peak;
+    }
+
     std::cout << "core tests passed\n";
 
     // Basic WAV roundtrip (16-bit)
@@ -100,6 +760,73 @@ int main() {
         for (size_t n=0;n<N;++n) assert(std::abs(X[n].real() - x[n].real()) < 1e-3f);
     }
 
+    // FFTPlan matches a direct DFT (forward sign convention e^{-i...})
+    {
+        const size_t N = 64;
+        vv::fft::FFTPlan plan(N);
+        assert(plan.size() == N && vv::fft::FFTPlan(48).size() == 0 && vv::fft::FFTPlan::nextPow2(65) == 128);
+        std::vector<std::complex<float>> x(N);
+        for (size_t n = 0; n < N; ++n) x[n] = {std::cos(0.3f * n) + 0.1f * n, std::sin(0.7f * n)};
+        auto X = x; plan.forward(X.data());
+        for (size_t k = 0; k < N; ++k) {
+            std::complex<double> ref = 0;
+            for (size_t n = 0; n < N; ++n) ref += std::complex<double>(x[n]) * std::polar(1.0, -2.0 * 3.14159265358979323846 * k * n / N);
+            assert(std::abs(std::complex<double>(X[k]) - ref) < 1e-3);
+        }
+        plan.inverse(X.data());
+        for (size_t n = 0; n < N; ++n) assert(std::abs(X[n] - x[n]) < 1e-4f);
+
+        // real-input plan agrees with the complex transform of the same samples
+        vv::fft::RealFFTPlan rplan(N);
+        assert(rplan.bins() == N / 2 + 1 && vv::fft::RealFFTPlan(2).size() == 0);
+        std::vector<float> r(N);
+        for (size_t n = 0; n < N; ++n) { r[n] = x[n].real(); x[n] = {r[n], 0.0f}; }
+        std::vector<std::complex<float>> R(rplan.bins());
+        rplan.forward(r.data(), R.data());
+        plan.forward(x.data());
+        for (size_t k = 0; k < R.size(); ++k) assert(std::abs(R[k] - x[k]) < 1e-3f);
+    }
+
+    // Batched plan: every lane of a split, lane-interleaved batch matches FFTPlan alone
+    {
+        const size_t N = 32, L = 4;
+        vv::fft::FFTPlan plan(N);
+        vv::fft::BatchFFTPlan<L> batch(N);
+        assert(batch.size() == N && vv::fft::BatchFFTPlan<L>(24).size() == 0);
+        std::vector<float> re(N * L), im(N * L);
+        std::vector<std::vector<std::complex<float>>> ref(L, std::vector<std::complex<float>>(N));
+        for (size_t l = 0; l < L; ++l) {
+            for (size_t n = 0; n < N; ++n) {
+                ref[l][n] = {std::cos(0.2f * n * (l + 1)), 0.1f * n - 0.3f * l};
+                re[n * L + l] = ref[l][n].real(); im[n * L + l] = ref[l][n].imag();
+            }
+            plan.forward(ref[l].data());
+        }
+        const auto re0 = re, im0 = im;
+        batch.forward(re.data(), im.data());
+        for (size_t l = 0; l < L; ++l)
+            for (size_t k = 0; k < N; ++k) assert(std::abs(std::complex<float>(re[k * L + l], im[k * L + l]) - ref[l][k]) < 1e-4f);
+        batch.inverse(re.data(), im.data());
+        for (size_t i = 0; i < N * L; ++i) assert(std::fabs(re[i] - re0[i]) < 1e-5f && std::fabs(im[i] - im0[i]) < 1e-5f);
+    }
+
+    // Array log/exp/sincos agree with libm, and exp saturates instead of overflowing
+    {
+        std::vector<float> x(1000), y(1000), s(1000), c(1000);
+        for (size_t i = 0; i < x.size(); ++i) x[i] = std::exp(-40.0f + 0.08f * i);
+        vv::vmath::log(x.data(), y.data(), x.size());
+        for (size_t i = 0; i < x.size(); ++i) assert(std::fabs(y[i] - std::log(x[i])) < 1e-5f);
+        for (size_t i = 0; i < x.size(); ++i) x[i] = -80.0f + 0.16f * i;
+        vv::vmath::exp(x.data(), y.data(), x.size());
+        for (size_t i = 0; i < x.size(); ++i) assert(std::fabs(y[i] / std::exp(x[i]) - 1.0f) < 1e-6f);
+        for (size_t i = 0; i < x.size(); ++i) x[i] = -500.0f + 1.0007f * i;
+        vv::vmath::sincos(x.data(), s.data(), c.data(), x.size());
+        for (size_t i = 0; i < x.size(); ++i) assert(std::fabs(s[i] - std::sin(x[i])) < 1e-6f && std::fabs(c[i] - std::cos(x[i])) < 1e-6f);
+        float big[2] = {1e30f, -1e30f};
+        vv::vmath::exp(big, big, 2);
+        assert(std::isfinite(big[0]) && big[0] > 1e38f && big[1] >= 0.0f && big[1] < 1e-37f);
+    }
+
     std::cout << "audio utils tests passed\n";
     return 0;
 }
@@ -1,10 +1,24 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <vector>
 
+#include "core/BlockSource.h"
+#include "core/ComputationGraph.h"
 #include "core/DataPacket.h"
+#include "core/MemoryResource.h"
+#include "world/AnalysisUtils.h"
+#include "world/ChunkedAnalysis.h"
+#include "world/PulseVocoder.h"
+#include "world/RealtimeSynthesizer.h"
+#include "world/SpectralCodec.h"
+#include "world/UtauWorldInterface.h"
+#include "world/Voicebank.h"
+#include "utils/WavIO.h"
 #include "world/WorldAnalysisNode.h"
 #include "world/WorldSynthesisNode.h"
 #include "core/DummyGainFilter.h"
@@ -32,8 +46,410 @@ int main() {
     auto analyzed = analysis.process(in);
     assert(analyzed);
     assert(analyzed->hasFeature("f0"));
-    assert(analyzed->hasFeature("spectral_envelope"));
-    assert(analyzed->hasFeature("aperiodicity"));
+    assert(analyzed->hasMatrix("spectral_envelope"));
+    assert(analyzed->hasMatrix("aperiodicity"));
+    // matrices carry their own shape
+    const auto* envm = analyzed->getMatrix("spectral_envelope");
+    assert(envm->rows() > 0 && envm->cols() > 0);
+    assert(analyzed->getMatrix("aperiodicity")->rows() == envm->rows());
+#ifndef VV_USE_WORLD
+    // Fallback STFT features are per bin: the tone's bin dominates the envelope, and the
+    // tonal low band is far less aperiodic than white noise
+    {
+        const size_t r = envm->rows() / 2;
+        size_t peak = 0;
+        for (size_t k = 1; k < envm->cols(); ++k) if (envm->at(r, k) > envm->at(r, peak)) peak = k;
+        const double binHz = static_cast<double>(sr) / static_cast<double>((envm->cols() - 1) * 2);
+        assert(std::fabs(peak * binHz - freq) < 200.0);
+        (void)binHz;
+        std::vector<float> noise(x.size());
+        uint32_t seed = 1;
+        for (auto& v : noise) { seed = seed * 1664525u + 1013904223u; v = static_cast<float>(seed >> 8) / 16777216.0f - 0.5f; }
+        auto na = analysis.process(std::make_shared<DataPacket>(noise, sr, 1, 32));
+        assert(analyzed->getMatrix("aperiodicity")->at(r, 1) < 0.5 * na->getMatrix("aperiodicity")->at(r, 1));
+    }
+#endif
+
+    // Time-parallel analysis matches the serial result bit for bit
+    {
+        WorldParams pp = params; pp.analysisThreads = 4; pp.framesPerTask = 5;
+        WorldAnalysisNode parallel(pp);
+        auto pa = parallel.process(in);
+        assert(pa && pa->contentHash() == analyzed->contentHash());
+        // the frame ranges are hashed (WORLD seeds per range), the thread count is not
+        WorldParams serialChunks = pp; serialChunks.analysisThreads = 1;
+        uint64_t hs = 0, hp = 0, hd = 0;
+        assert(WorldAnalysisNode(serialChunks).parameterHash(hs) && parallel.parameterHash(hp) && hs == hp);
+        assert(analysis.parameterHash(hd) && hd != hp);
+        (void)hs; (void)hp; (void)hd; (void)serialChunks;
+        // clones (e.g. executeBatch lane replicas) share one pool instead of one each
+        auto r1 = std::static_pointer_cast<WorldAnalysisNode>(parallel.clone());
+        auto r2 = std::static_pointer_cast<WorldAnalysisNode>(parallel.clone());
+        assert(r1->threadPool() && r1->threadPool() == r2->threadPool() && r1->threadPool() == parallel.threadPool());
+        WorldSynthesisNode ps;
+        ps.setSynthesisThreads(4);
+        auto s1 = std::static_pointer_cast<WorldSynthesisNode>(ps.clone());
+        auto s2 = std::static_pointer_cast<WorldSynthesisNode>(ps.clone());
+        assert(s1->threadPool() && s1->threadPool() == s2->threadPool());
+        assert(!std::static_pointer_cast<WorldAnalysisNode>(analysis.clone())->threadPool()); // serial: none
+        // shared pool, and from inside a graph worker (nested parallelFor)
+        auto pool = std::make_shared<ThreadPool>(3);
+        auto shared = std::make_shared<WorldAnalysisNode>(pp);
+        shared->setId("parallel_analysis");
+        shared->setThreadPool(pool);
+        ComputationGraph pg;
+        pg.setThreadPool(pool);
+        std::unordered_map<std::string, std::shared_ptr<DataPacket>> pouts;
+        const bool ran = pg.addNode(shared) && pg.execute(in, pouts, 3);
+        assert(ran); (void)ran;
+        assert(pouts["parallel_analysis"]->contentHash() == analyzed->contentHash());
+    }
+
+    // Arena-backed analysis: identical output, and a reset recycles the render's memory
+    {
+        Arena arena;
+        WorldAnalysisNode arenaAnalysis(params);
+        arenaAnalysis.setMemoryResource(&arena);
+        {
+            auto a = arenaAnalysis.process(in);
+            assert(a && a->contentHash() == analyzed->contentHash() && arena.bytesUsed() > 0);
+        }
+        const size_t reserved = arena.bytesReserved();
+        arena.reset();
+        { auto a = arenaAnalysis.process(in); assert(a); }
+        assert(arena.bytesReserved() == reserved);
+        (void)reserved;
+    }
+
+    // Disk-cached analysis: the second node over the same audio and parameters reuses the
+    // stored features; any parameter change is a different entry
+    {
+        namespace fs = std::filesystem;
+        const auto dir = (fs::temp_directory_path() / "vv_test_analysis_cache").string();
+        std::error_code ec; fs::remove_all(dir, ec);
+        auto cache = std::make_shared<PacketDiskCache>(dir);
+        WorldAnalysisNode first(params), second(params);
+        first.setDiskCache(cache);
+        second.setDiskCache(cache);
+        auto a = first.process(in);
+        auto b = second.process(in);
+        assert(a && b && cache->misses() == 1 && cache->hits() == 1);
+        assert(a->contentHash() == analyzed->contentHash() && b->contentHash() == analyzed->contentHash());
+        WorldParams other = params; other.hopSize = 128;
+        assert(first.diskCacheKey(*in) != WorldAnalysisNode(other).diskCacheKey(*in));
+        (void)other;
+        fs::remove_all(dir, ec);
+    }
+
+    // F0 tier and range are parameters: they change the hash, and the range bounds the estimate
+    {
+        F0Method m;
+        assert(parseF0Method("dio-harvest", m) && m == F0Method::DioHarvest && !parseF0Method("yin", m));
+        WorldParams fast = params; fast.f0Method = F0Method::Dio;
+        uint64_t h0 = 0, h1 = 0;
+        assert(analysis.parameterHash(h0) && WorldAnalysisNode(fast).parameterHash(h1) && h0 != h1);
+        (void)m; (void)fast; (void)h0; (void)h1;
+        WorldParams narrow = params; narrow.f0Floor = 150.0; narrow.f0Ceil = 300.0;
+        auto na = WorldAnalysisNode(narrow).process(in);
+        for (float f : *na->getFeature(FeatureKey::F0)) { assert(f == 0.0f || (f >= 149.0f && f <= 301.0f)); (void)f; }
+    }
+
+    // UTAU .frq: binary round-trip, and a supplied track replaces F0 estimation
+    {
+        const auto& f0 = *analyzed->getFeature(FeatureKey::F0);
+        UtauFrq frq = UtauWorldIO::makeFrq(x, f0, static_cast<double>(params.hopSize));
+        assert(frq.f0.size() == (x.size() + 255) / 256 && std::fabs(frq.averageF0 - freq) < 2.0);
+        double amp = 0.0;
+        for (double a : frq.amplitude) amp += a / static_cast<double>(frq.amplitude.size());
+        assert(std::fabs(amp - 0.25 * 32768.0 * 2.0 / 3.1415926535) < 100.0); // mean |sine| on the 16-bit scale
+        namespace fs = std::filesystem;
+        const auto path = (fs::temp_directory_path() / "vv_test_sample_wav.frq").string();
+        const bool wrote = UtauWorldIO::writeFrq(path, frq);
+        assert(wrote); (void)wrote;
+        assert(fs::file_size(path) == 40 + 16 * frq.f0.size());
+        UtauFrq back;
+        const bool read = UtauWorldIO::readFrq(path, back);
+        assert(read); (void)read;
+        assert(back.samplesPerFrame == 256 && back.averageF0 == frq.averageF0);
+        assert(back.f0 == frq.f0 && back.amplitude == frq.amplitude);
+        fs::resize_file(path, 40 + 16 * frq.f0.size() - 8);
+        const bool truncated = UtauWorldIO::readFrq(path, back);
+        assert(!truncated); (void)truncated;
+        std::error_code ec; fs::remove(path, ec);
+
+        std::fill(back.f0.begin(), back.f0.end(), 300.0);
+        back.f0[3] = 0.0;
+        DataPacket withFrq(x, sr, 1, 32);
+        UtauWorldIO::attachFrq(withFrq, back);
+        WorldParams ext = params; ext.externalF0 = true;
+        uint64_t h0 = 0, h1 = 0;
+        assert(analysis.parameterHash(h0) && WorldAnalysisNode(ext).parameterHash(h1) && h0 != h1);
+        (void)h0; (void)h1;
+        auto ea = WorldAnalysisNode(ext).process(std::make_shared<DataPacket>(withFrq));
+        const auto& ef0 = *ea->getFeature(FeatureKey::F0);
+        assert(ef0.size() == f0.size() && ea->getMatrix("spectral_envelope")->rows() == envm->rows());
+        // frq frame 3 covers samples [768, 1024): hop-256 frames 2..4 border or hit it
+        for (size_t i = 0; i < ef0.size(); ++i) assert(ef0[i] == (i == 3 ? 0.0f : 300.0f));
+    }
+
+    // oto.ini parsing (CRLF, BOM, Shift-JIS names) and a deduplicated, parallel bank analysis
+    {
+        std::vector<OtoEntry> oto;
+        const std::string sjisSo = "\x83\x5c"; // Shift-JIS katakana "so": second byte is '\\'
+        const bool parsed = OtoIni::parse("\xEF\xBB\xBF" "a.wav=a,100,50,-300,80,20\r\n\r\nsub\\" + sjisSo + ".wav=,1,2,3,4,5\r\n", oto);
+        assert(parsed); (void)parsed;
+        assert(oto.size() == 2 && oto[0].file == "a.wav" && oto[0].alias == "a");
+        assert(oto[0].offsetMs == 100.0 && oto[0].overlapMs == 20.0 && oto[0].endMs(5000.0) == 400.0);
+        assert(oto[1].file == "sub/" + sjisSo + ".wav" && oto[1].alias == sjisSo && oto[1].endMs(5000.0) == 4997.0);
+
+        namespace fs = std::filesystem;
+        const auto bank = fs::temp_directory_path() / "vv_test_bank";
+        std::error_code ec; fs::remove_all(bank, ec);
+        fs::create_directories(bank / "sub");
+        wavio::WavData wd; wd.sampleRate = sr; wd.channels = 1; wd.samples = x;
+        const bool wrote = wavio::writeWav32f((bank / "a.wav").string(), wd) && wavio::writeWav32f((bank / "sub" / "b.wav").string(), wd);
+        assert(wrote); (void)wrote;
+        { std::ofstream o(bank / "oto.ini"); o << "a.wav=a,10,0,0,0,0\r\na.wav=b,50,0,-60,0,0\r\n"; }
+        { std::ofstream o(bank / "sub" / "oto.ini"); o << "b.wav=c,0,0,0,0,0\r\nnone.wav=d,0,0,0,0,0\r\n"; }
+        VoicebankOptions opts; opts.params = params; opts.threads = 2; opts.otoRegions = true;
+        VoicebankAnalyzer analyzer(bank.string(), (bank / "out").string(), opts);
+        const bool loaded = analyzer.load();
+        assert(loaded && analyzer.files().size() == 3 && analyzer.entryCount() == 4); (void)loaded;
+        size_t calls = 0;
+        const bool allOk = analyzer.run([&](const VoicebankProgress& p, const VoicebankAnalyzer::File&, bool) { calls = p.done; });
+        assert(!allOk && calls == 3 && analyzer.failures().size() == 1 && analyzer.progress().failed == 1);
+        (void)allOk;
+        UtauWorldMeta meta, whole;
+        const bool read = UtauWorldIO::readMetaJson((bank / "out" / "a" / "meta.json").string(), meta) &&
+                          UtauWorldIO::readMetaJson((bank / "out" / "sub" / "b" / "meta.json").string(), whole);
+        assert(read); (void)read;
+        assert(meta.startSample > 0 && meta.startSample <= sr / 100 && meta.frames < whole.frames);
+        assert(whole.startSample == 0 && whole.sampleCount == x.size());
+        fs::remove_all(bank, ec);
+    }
+
+    // Compact spectra: warped cepstrum and band aperiodicity codes round-trip smooth spectra
+    // closely, shrink the matrices by an order of magnitude, and survive the file format
+    {
+        const size_t bins = 1025;
+        MelCepstrumCodec mcep(bins, 60, melCepstrumAlpha(48000));
+        std::vector<double> env(bins), back(bins);
+        for (size_t k = 0; k < bins; ++k) {
+            const double hz = 24000.0 * static_cast<double>(k) / (bins - 1);
+            env[k] = 1e-4 * std::exp(-hz / 4000.0) * (1.0 + 20.0 * std::exp(-std::pow((hz - 700.0) / 150.0, 2)) +
+                                                       8.0 * std::exp(-std::pow((hz - 1200.0) / 200.0, 2)));
+        }
+        std::vector<float> cep(mcep.order());
+        mcep.encode(env.data(), cep.data());
+        mcep.decode(cep.data(), back.data());
+        for (size_t k = 0; k < bins; ++k) assert(std::fabs(10.0 * std::log10(back[k] / env[k])) < 1.0);
+
+        BandAperiodicityCodec bap(bins, 48000);
+        assert(bap.bands() == 9);
+        std::vector<double> ap(bins), apBack(bins);
+        for (size_t k = 0; k < bins; ++k) ap[k] = std::pow(10.0, (-40.0 + 35.0 * k / (bins - 1)) / 20.0); // linear in dB
+        std::vector<float> db(bap.bands());
+        bap.encode(ap.data(), db.data());
+        bap.decode(db.data(), apBack.data());
+        for (size_t k = 40; k + 40 < bins; ++k) assert(std::fabs(20.0 * std::log10(apBack[k] / ap[k])) < 0.5);
+        // Nyquist below half a band still keeps the 0 Hz and Nyquist centres
+        BandAperiodicityCodec narrow(65, 2000);
+        assert(narrow.bands() == 2);
+        std::vector<double> flat(65, 0.1), flatBack(65);
+        std::vector<float> flatDb(narrow.bands());
+        narrow.encode(flat.data(), flatDb.data());
+        narrow.decode(flatDb.data(), flatBack.data());
+        for (double v : flatBack) { assert(std::fabs(v - 0.1) < 1e-4); (void)v; }
+
+        WorldParams compactParams = params; compactParams.cepstrumOrder = 40;
+        uint64_t h0 = 0, h1 = 0;
+        assert(analysis.parameterHash(h0) && WorldAnalysisNode(compactParams).parameterHash(h1) && h0 != h1);
+        (void)h0; (void)h1;
+        auto packed = WorldAnalysisNode(compactParams).process(in);
+        assert(packed && !packed->hasMatrix(FeatureKey::SpectralEnvelope) && !packed->hasMatrix(FeatureKey::Aperiodicity));
+        const auto* pc = packed->getMatrix(FeatureKey::MelCepstrum);
+        assert(pc && pc->rows() == envm->rows() && pc->cols() == 40);
+        assert(10 * (pc->cols() + packed->getMatrix(FeatureKey::BandAperiodicity)->cols()) < envm->cols());
+        FeatureMatrix de, da;
+        const bool decoded = decodeSpectralFeatures(*packed, ElementType::Float64, de, da);
+        assert(decoded); (void)decoded;
+        assert(de.rows() == envm->rows() && de.cols() == envm->cols() && da.cols() == envm->cols());
+
+        namespace fs = std::filesystem;
+        const auto dir = (fs::temp_directory_path() / "vv_test_compact").string();
+        std::error_code ec; fs::create_directories(dir, ec);
+        const bool wrote = UtauWorldIO::writeAnalysis(dir, *packed, params.hopSize, x.size());
+        assert(wrote && fs::exists(dir + "/mcep.bin") && !fs::exists(dir + "/sp.bin")); (void)wrote;
+        DataPacket reread; UtauWorldMeta meta;
+        const bool read = UtauWorldIO::readAnalysis(dir, reread, meta);
+        assert(read && meta.cepstrumOrder == 40); (void)read;
+        assert(reread.getMatrix(FeatureKey::MelCepstrum)->contentHash() == pc->contentHash());
+        (void)pc;
+        assert(reread.getScalar(FeatureKey::MelCepstrumAlpha) == packed->getScalar(FeatureKey::MelCepstrumAlpha));
+        fs::remove_all(dir, ec);
+    }
+
+    // Real-time synthesis: frames pushed incrementally, audio pulled in fixed blocks; the
+    // block size changes only the latency, never the samples
+    {
+        auto render = [&](const DataPacket& pkt, size_t blockSize, RealtimeSynthesizer& rt) {
+            std::vector<float> y, block(blockSize);
+            size_t pushed = 0;
+            while (!rt.drained()) {
+                pushed += rt.pushFrames(pkt, pushed);
+                if (pushed == pkt.getFeature(FeatureKey::F0)->size()) rt.finish();
+                const bool pulled = rt.pull(block.data());
+                assert(pulled); (void)pulled;
+                y.insert(y.end(), block.begin(), block.end());
+            }
+            assert(rt.underruns() == 0);
+            return y;
+        };
+        RealtimeSynthesisConfig cfg;
+        cfg.sampleRate = sr; cfg.fftSize = (envm->cols() - 1) * 2; cfg.hopSize = params.hopSize;
+        cfg.blockSize = 128; cfg.maxFrames = 8;
+        RealtimeSynthesizer rt(cfg);
+        assert(rt.bins() == envm->cols() && rt.latencySamples() == 128 + params.hopSize);
+        std::vector<float> silent(cfg.blockSize, 1.0f);
+        assert(!rt.ready());
+        const bool pulled = rt.pull(silent.data());
+        assert(!pulled && silent[0] == 0.0f && rt.underruns() == 1); (void)pulled;
+        rt.reset();
+        const auto y = render(*analyzed, cfg.blockSize, rt);
+        cfg.blockSize = 300;
+        RealtimeSynthesizer rt2(cfg);
+        const auto y2 = render(*analyzed, cfg.blockSize, rt2);
+        const size_t frames = envm->rows();
+        assert(y.size() >= frames * params.hopSize && y2.size() >= frames * params.hopSize);
+        for (size_t i = 0; i < std::min(y.size(), y2.size()); ++i) assert(y[i] == y2[i]);
+        // Post-filters run on each pulled block
+        auto chain = std::make_shared<PostFilterChain>();
+        chain->add(std::make_shared<DummyGainFilter>(0.5f));
+        rt2.setPostFilters(chain);
+        rt2.reset();
+        const auto y3 = render(*analyzed, cfg.blockSize, rt2);
+        assert(y3.size() == y2.size());
+        for (size_t i = 0; i < y2.size(); ++i) assert(y3[i] == 0.5f * y2[i]);
+        // Synthesized from a 220 Hz tone's features, the output is pitched at 220 Hz
+        const std::vector<float> body(y.begin() + 2048, y.begin() + static_cast<std::ptrdiff_t>(frames * params.hopSize) - 2048);
+        auto yf0 = estimateF0(body, sr, 256, 50.0, 1100.0);
+        std::sort(yf0.begin(), yf0.end());
+        assert(std::fabs(yf0[yf0.size() / 2] - freq) < 3.0f);
+
+        WorldParams compactParams = params; compactParams.cepstrumOrder = 40;
+        auto packed = WorldAnalysisNode(compactParams).process(in);
+        RealtimeSynthesizer rt3(cfg);
+        const size_t queued = rt3.pushFrames(*packed);
+        assert(queued == cfg.maxFrames); (void)queued;
+
+        // Offline, the same pulses rendered at once, serially or as segments on a pool
+        PulseVocoderConfig vc;
+        vc.sampleRate = sr; vc.fftSize = cfg.fftSize; vc.hopSize = cfg.hopSize;
+        const auto& af0 = *analyzed->getFeature(FeatureKey::F0);
+        const auto& aap = *analyzed->getMatrix(FeatureKey::Aperiodicity);
+        std::vector<float> serial, segmented;
+        bool rendered = PulseVocoder::synthesize(af0, *envm, aap, vc, serial);
+        assert(rendered && serial.size() == af0.size() * params.hopSize);
+        for (size_t i = 0; i < serial.size(); ++i) assert(serial[i] == y[i]);
+        ThreadPool pool(3);
+        rendered = PulseVocoder::synthesize(af0, *envm, aap, vc, segmented, &pool, 7);
+        assert(rendered && segmented.size() == serial.size()); (void)rendered;
+        float peak = 0.0f, err = 0.0f;
+        for (size_t i = 0; i < serial.size(); ++i) {
+            peak = std::max(peak, std::fabs(serial[i]));
+            err = std::max(err, std::fabs(serial[i] - segmented[i]));
+        }
+        assert(peak > 0.0f && err <= 1e-5f * peak);
+
+        WorldSynthesisNode parallel;
+        parallel.setSynthesisThreads(4);
+        parallel.setNativeSynthesis(true); // threads never swap WORLD for PulseVocoder
+        auto features = std::make_shared<DataPacket>(*analyzed);
+        features->samples().clear(); // samples present would be passed through
+        auto po = parallel.process(features);
+        assert(po && po->samples().size() == serial.size());
+        for (size_t i = 0; i < serial.size(); ++i) assert(std::fabs(po->samples()[i] - serial[i]) <= 1e-5f * peak);
+        packed->samples().clear();
+        auto pc = parallel.process(packed); // compact spectra are decoded first
+        assert(pc && pc->samples().size() == serial.size());
+        WorldSynthesisNode native;
+        native.setNativeSynthesis(true); // the default unless WORLD is linked
+        auto no = native.process(features);
+        assert(no && no->samples() == serial);
+
+        // Streamed in blocks, spectra render as one continuous utterance
+        auto streamBlocks = [&](const std::shared_ptr<const DataPacket>& pkt, size_t framesPerBlock) {
+            WorldSynthesisNode node;
+            node.setNativeSynthesis(true);
+            node.beginStream();
+            PacketBlockSource blocks(pkt, framesPerBlock, params.hopSize);
+            std::shared_ptr<const DataPacket> b;
+            StreamBlock info;
+            std::vector<float> streamed;
+            while (blocks.next(b, info)) {
+                auto o = node.processBlock(b, info);
+                assert(o);
+                streamed.insert(streamed.end(), o->samples().begin(), o->samples().end());
+            }
+            return streamed;
+        };
+        // (blocks slice matrices with one row per F0 frame; the fallback analysis may emit
+        // a few more)
+        auto perFrame = [&](const DataPacket& pkt) {
+            auto p = std::make_shared<DataPacket>(pkt);
+            pkt.forEachMatrix([&](const std::string& key, const FeatureMatrix& m) { p->setMatrix(key, m.sliceRows(0, af0.size())); });
+            return p;
+        };
+        assert(streamBlocks(perFrame(*features), 7) == serial);
+        assert(streamBlocks(perFrame(*features), 100) == serial); // more frames than the engine queues
+        const auto pcs = streamBlocks(perFrame(*packed), 5);
+        auto pcn = native.process(packed);
+        assert(pcs.size() == pcn->samples().size());
+        for (size_t i = 0; i < pcs.size(); ++i) assert(std::fabs(pcs[i] - pcn->samples()[i]) <= 1e-6f * peak);
+    }
+
+    // Fallback YIN tracker: accurate on a steady tone, unvoiced on silence
+    {
+        auto f0 = estimateF0(x, sr, 256, 50.0, 1100.0);
+        assert(!f0.empty());
+        for (float f : f0) { assert(std::fabs(f - freq) < 1.0f); (void)f; }
+        auto quiet = estimateF0(std::vector<float>(x.size(), 0.0f), sr, 256);
+        for (float f : quiet) { assert(f == 0.0f); (void)f; }
+    }
+
+    // Chunked analysis: small blocks read incrementally reassemble the whole-file result
+    {
+        size_t pos = 0;
+        auto reader = [&](float* dst, size_t maxFrames) {
+            const size_t n = std::min(maxFrames, x.size() - pos);
+            std::copy(x.begin() + pos, x.begin() + pos + n, dst);
+            pos += n;
+            return n;
+        };
+        ChunkedAnalysisSource source(std::make_shared<WorldAnalysisNode>(params), reader, x.size(), sr, 1, 7);
+        assert(source.totalFrames() == envm->rows() && source.blockCount() > 3);
+        std::vector<float> f0, env, samples;
+        size_t frames = 0;
+        const bool ok = source.run([&](const StreamBlock& info, const std::shared_ptr<DataPacket>& block) {
+            assert(info.firstFrame == frames);
+            frames += info.frames;
+            const auto* f = block->getFeature(FeatureKey::F0);
+            const auto* e = block->getMatrix(FeatureKey::SpectralEnvelope);
+            assert(f && e && e->rows() == info.frames);
+            assert(block->getMatrix(FeatureKey::Aperiodicity)->rows() == info.frames);
+            f0.insert(f0.end(), f->begin(), f->end());
+            for (size_t r = 0; r < e->rows(); ++r) env.push_back(static_cast<float>(e->at(r, 0)));
+            samples.insert(samples.end(), block->samples().begin(), block->samples().end());
+            return true;
+        });
+        assert(ok && frames == source.totalFrames() && samples == x);
+        (void)ok;
+        assert(source.peakWindowSamples() < x.size() / 2);
+#ifndef VV_USE_WORLD
+        assert(f0 == *analyzed->getFeature(FeatureKey::F0));
+        for (size_t r = 0; r < envm->rows(); ++r) assert(env[r] == static_cast<float>(envm->at(r, 0)));
+#endif
+    }
 
     WorldSynthesisNode synth;
     synth.setId("world_synth");
@@ -70,6 +486,32 @@ int main() {
     double r1 = rms(out_gain->samples());
     assert(r1 < r0 * 0.9); // allow tolerance; should be significantly lower
 
+    // Block streaming through the synthesis node matches whole-utterance rendering
+    {
+        auto feats = std::make_shared<DataPacket>(std::vector<float>{}, sr, 1, 32);
+        std::vector<float> f0track(40);
+        for (size_t i = 0; i < f0track.size(); ++i) f0track[i] = 180.0f + static_cast<float>(i);
+        feats->setFeature("f0", f0track);
+        auto stream_synth = std::make_shared<WorldSynthesisNode>();
+        stream_synth->setId("stream_synth");
+        auto whole = stream_synth->process(feats);
+        ComputationGraph g;
+        ExecutionPlan plan;
+        const bool built = g.addNode(stream_synth) && g.compile(plan);
+        assert(built); (void)built;
+        PacketBlockSource blocks(feats, 7, 240);
+        std::vector<float> streamed;
+        const bool ok = g.runStreaming(plan,
+            [&](std::shared_ptr<const DataPacket>& b, StreamBlock& info) { return blocks.next(b, info); },
+            [&](const StreamBlock&, const std::shared_ptr<DataPacket>& o) {
+                streamed.insert(streamed.end(), o->samples().begin(), o->samples().end());
+                return true;
+            });
+        assert(ok); (void)ok;
+        assert(streamed.size() == whole->samples().size());
+        for (size_t i = 0; i < streamed.size(); ++i) assert(std::fabs(streamed[i] - whole->samples()[i]) < 1e-6f);
+    }
+
     std::cout << "world tests passed\n";
     return 0;
 }